@@ -108,31 +108,33 @@ syntax keyword vifmHiColors contained black red green yellow blue magenta cyan
 syntax case match
 
 " Options
-syntax keyword vifmOption contained aproposprg autochpos cdpath cd chaselinks
-		\ classify columns co confirm cf cpoptions cpo dotdirs fastrun fillchars fcs
-		\ findprg followlinks fusehome gdefault grepprg history hi hlsearch hls iec
-		\ ignorecase ic incsearch is laststatus lines locateprg ls lsview
-		\ mintimeoutlen number nu numberwidth nuw relativenumber rnu rulerformat ruf
-		\ runexec scrollbind scb scrolloff so sort sortorder shell sh shortmess shm
-		\ slowfs smartcase scs sortnumbers statusline stl syscalls tabstop timefmt
-		\ timeoutlen tm trash trashdir ts tuioptions to undolevels ul vicmd
-		\ viewcolumns vifminfo vimhelp vixcmd wildmenu wmnu wordchars wrap wrapscan
-		\ ws
+syntax keyword vifmOption contained aproposprg autochpos calcdirsizes cdpath cd
+		\ chaselinks classify columns co confirm cf copyjobs cpoptions cpo diskusage
+		\ dotdirs fastrun fillchars fcs findprg followlinks fusehome gdefault
+		\ grepprg history hi hlsearch hls iec ignorecase ic incsearch is laststatus
+		\ lines listcache locateprg ls lsview mintimeoutlen number nu numberwidth
+		\ nuw prefetch relativenumber rnu rulerformat ruf runexec scrollbind scb
+		\ scrolloff so sort sortorder shell sh shortmess shm slowfs smartcase scs
+		\ sortnumbers statusline stl syscalls tabstop timefmt timeoutlen tm trash
+		\ trashdir trustnotify ts tuioptions to undolevels ul vicmd viewcolumns
+		\ vifminfo vimhelp vixcmd wildmenu wmnu wordchars wrap wrapscan ws
 
 " Disabled boolean options
-syntax keyword vifmOption contained noautochpos noconfirm nocf nochaselinks
-		\ nofastrun nofollowlinks nohlsearch nohls noiec noignorecase noic
-		\ noincsearch nois nolaststatus nols nolsview nonumber nonu norelativenumber
-		\ nornu noscrollbind noscb norunexec nosmartcase noscs nosortnumbers
-		\ nosyscalls notrash novimhelp nowildmenu nowmnu nowrap nowrapscan nows
+syntax keyword vifmOption contained noautochpos nocalcdirsizes noconfirm nocf
+		\ nochaselinks nodiskusage nofastrun nofollowlinks nohlsearch nohls noiec
+		\ noignorecase noic noincsearch nois nolaststatus nols nolsview nonumber
+		\ nonu noprefetch norelativenumber nornu noscrollbind noscb norunexec
+		\ nosmartcase noscs nosortnumbers nosyscalls notrash notrustnotify novimhelp
+		\ nowildmenu nowmnu nowrap nowrapscan nows
 
 " Inverted boolean options
-syntax keyword vifmOption contained invautochpos invconfirm invcf invchaselinks
-		\ invfastrun invfollowlinks invhlsearch invhls inviec invignorecase invic
-		\ invincsearch invis invlaststatus invls invlsview invnumber invnu
-		\ invrelativenumber invrnu invscrollbind invscb invrunexec invsmartcase
-		\ invscs invsortnumbers invsyscalls invtrash invvimhelp invwildmenu invwmnu
-		\ invwrap invwrapscan invws
+syntax keyword vifmOption contained invautochpos invcalcdirsizes invconfirm
+		\ invcf invchaselinks invdiskusage invfastrun invfollowlinks invhlsearch
+		\ invhls inviec invignorecase invic invincsearch invis invlaststatus invls
+		\ invlsview invnumber invnu invprefetch invrelativenumber invrnu
+		\ invscrollbind invscb invrunexec invsmartcase invscs invsortnumbers
+		\ invsyscalls invtrash invtrustnotify invvimhelp invwildmenu invwmnu invwrap
+		\ invwrapscan invws
 
 " Expressions
 syntax region vifmStatement start='^\(\s\|:\)*'
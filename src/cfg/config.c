@@ -160,6 +160,12 @@ cfg_init(void)
 	cfg.selection_is_primary = 1;
 	cfg.tab_switches_pane = 1;
 	cfg.use_system_calls = 0;
+	cfg.copy_jobs = 4;
+	cfg.trust_notify = 0;
+	cfg.calc_dir_sizes = 0;
+	cfg.disk_usage = 0;
+	cfg.list_cache_size = 8192;
+	cfg.prefetch_dirs = 0;
 	cfg.tab_stop = 8;
 	cfg.ruler_format = strdup("%l/%S ");
 	cfg.status_line = strdup("");
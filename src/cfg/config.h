@@ -115,6 +115,12 @@ typedef struct config_t
 	int selection_is_primary; /* For yy, dd and DD: act on selection not file. */
 	int tab_switches_pane; /* Whether <tab> is switch pane or history forward. */
 	int use_system_calls; /* Prefer performing operations with system calls. */
+	int copy_jobs; /* Number of files copied to one device at the same time. */
+	int trust_notify; /* Rely on change notifications to skip some of stat()s. */
+	int calc_dir_sizes; /* Calculate unknown sizes of directories to sort. */
+	int disk_usage; /* Sizes of directories are allocated space like in du. */
+	int list_cache_size; /* Size limit of cache of file lists in kilobytes. */
+	int prefetch_dirs; /* Read directory under cursor in background. */
 	int tab_stop;
 	char *ruler_format;
 	char *status_line;
@@ -0,0 +1,527 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dirsizes.h"
+
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+#include <sys/stat.h> /* stat */
+
+#include <inttypes.h> /* PRId64 PRIu64 SCNd64 SCNu64 */
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* int64_t uint64_t */
+#include <stdio.h> /* FILE fclose() fprintf() remove() snprintf() sscanf() */
+#include <stdlib.h> /* free() realpath() */
+#include <string.h> /* strchr() strcpy() strdup() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "../utils/file_streams.h"
+#include "../utils/fs.h"
+#include "../utils/log.h"
+#include "../utils/path.h"
+#include "../utils/tree.h"
+#include "../utils/utils.h"
+#include "../opt_handlers.h"
+#include "config.h"
+
+/* State of a size. */
+typedef enum
+{
+	RS_VALID,     /* Size is up to date as far as we can tell. */
+	RS_UNCHECKED, /* Size was read from the file, but wasn't checked yet. */
+	RS_STALE,     /* Directory has changed since its size was calculated. */
+}
+RecordState;
+
+/* Size of a single directory. */
+typedef struct
+{
+	char *path;        /* Full path to the directory. */
+	uint64_t size;     /* Size of the directory. */
+	dir_stamp_t stamp; /* State of the directory at the time of calculation. */
+	RecordState state; /* Whether the size can be used. */
+	int exact;         /* Whether the size wasn't adjusted by estimated delta. */
+}
+record_t;
+
+static void adjust_record(record_t *record, int64_t delta, int exact);
+static int find_record(const char path[]);
+static int add_record(const char path[]);
+static void read_file(void);
+static void write_file(void);
+static int get_stamp(const char path[], dir_stamp_t *stamp);
+static int stamps_equal(const dir_stamp_t *a, const dir_stamp_t *b);
+static int get_file_path(char buf[], size_t buf_len);
+
+/* Protects all the state of the unit. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Maps paths to indexes in the records array. */
+static tree_t paths = NULL_TREE;
+/* Sizes of directories. */
+static record_t *records;
+/* Number of records. */
+static int nrecords;
+/* Number of allocated records. */
+static int records_cap;
+/* Whether the file was read. */
+static int loaded;
+/* Whether the file needs to be updated. */
+static int changed;
+
+int
+dirsizes_reset(void)
+{
+	int i;
+
+	pthread_mutex_lock(&lock);
+
+	for(i = 0; i < nrecords; ++i)
+	{
+		free(records[i].path);
+	}
+	free(records);
+	records = NULL;
+	nrecords = 0;
+	records_cap = 0;
+
+	tree_free(paths);
+	paths = tree_create(0, 0);
+
+	loaded = 0;
+	changed = 0;
+
+	pthread_mutex_unlock(&lock);
+
+	return paths == NULL_TREE;
+}
+
+int
+dirsizes_get(const char path[], uint64_t *size, int *exact)
+{
+	int pos;
+	record_t record;
+	dir_stamp_t stamp;
+	int valid;
+
+	pthread_mutex_lock(&lock);
+
+	if(!loaded)
+	{
+		loaded = 1;
+		read_file();
+	}
+
+	pos = find_record(path);
+	if(pos < 0 || records[pos].state != RS_UNCHECKED)
+	{
+		const int found = (pos >= 0 && records[pos].state == RS_VALID);
+		if(found)
+		{
+			*size = records[pos].size;
+			if(exact != NULL)
+			{
+				*exact = records[pos].exact;
+			}
+		}
+		pthread_mutex_unlock(&lock);
+		return !found;
+	}
+
+	record = records[pos];
+	pthread_mutex_unlock(&lock);
+
+	/* Querying file system might take a while, so do it without the lock. */
+	valid = (get_stamp(path, &stamp) == 0)
+	     && stamps_equal(&stamp, &record.stamp);
+
+	pthread_mutex_lock(&lock);
+
+	/* The array could have been reallocated in the meantime. */
+	pos = find_record(path);
+	if(pos >= 0 && records[pos].state == RS_UNCHECKED)
+	{
+		records[pos].state = valid ? RS_VALID : RS_STALE;
+		changed |= !valid;
+	}
+
+	valid = (pos >= 0 && records[pos].state == RS_VALID);
+	if(valid)
+	{
+		*size = records[pos].size;
+		if(exact != NULL)
+		{
+			*exact = records[pos].exact;
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+	return !valid;
+}
+
+void
+dirsizes_set(const char path[], uint64_t size, int exact,
+		const dir_stamp_t *stamp)
+{
+	dir_stamp_t own_stamp = { .dev = 0 };
+	int pos;
+
+	if(stamp == NULL)
+	{
+		(void)get_stamp(path, &own_stamp);
+		stamp = &own_stamp;
+	}
+
+	pthread_mutex_lock(&lock);
+
+	pos = find_record(path);
+	if(pos < 0)
+	{
+		pos = add_record(path);
+	}
+
+	if(pos >= 0)
+	{
+		records[pos].size = size;
+		records[pos].stamp = *stamp;
+		records[pos].state = RS_VALID;
+		records[pos].exact = exact;
+		changed = 1;
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+dirsizes_update(const char path[], int64_t delta, int exact,
+		const char other[])
+{
+	char dir[PATH_MAX];
+	char other_dir[PATH_MAX];
+	dir_stamp_t stamp;
+	int have_stamp;
+	int pos;
+
+	if(realpath(path, dir) != dir)
+	{
+		return;
+	}
+	if(other != NULL && realpath(other, other_dir) != other_dir)
+	{
+		return;
+	}
+
+	/* Modification time of the directory has just changed. */
+	have_stamp = (get_stamp(dir, &stamp) == 0);
+
+	pthread_mutex_lock(&lock);
+
+	/* Sizes from the file would be taken for valid on the next lookup, because
+	 * the change doesn't affect stamps of ancestors. */
+	if(!loaded)
+	{
+		loaded = 1;
+		read_file();
+	}
+
+	/* Otherwise the size would be dropped on the next run. */
+	pos = find_record(dir);
+	if(pos >= 0 && records[pos].state == RS_VALID && have_stamp)
+	{
+		records[pos].stamp = stamp;
+		changed = 1;
+	}
+
+	while(other == NULL || !path_starts_with(other_dir, dir))
+	{
+		pos = find_record(dir);
+		if(pos >= 0)
+		{
+			adjust_record(&records[pos], delta, exact);
+		}
+
+		if(is_root_dir(dir) || strchr(dir, '/') == NULL)
+		{
+			break;
+		}
+		remove_last_path_component(dir);
+		if(dir[0] == '\0')
+		{
+			strcpy(dir, "/");
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+dirsizes_write(void)
+{
+	if(!(cfg.vifm_info & VIFMINFO_DIRSIZES))
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+
+	if(changed)
+	{
+		/* Sizes from the file that weren't looked up must not be lost. */
+		if(!loaded)
+		{
+			loaded = 1;
+			read_file();
+		}
+
+		write_file();
+		changed = 0;
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/* Adds delta to size of the record.  A size that wasn't checked yet is dropped,
+ * as it's unknown whether it was up to date before the change. */
+static void
+adjust_record(record_t *record, int64_t delta, int exact)
+{
+	if(record->state == RS_STALE)
+	{
+		return;
+	}
+
+	changed = 1;
+
+	if(record->state == RS_UNCHECKED)
+	{
+		record->state = RS_STALE;
+		return;
+	}
+
+	if(delta < 0 && (uint64_t)-delta > record->size)
+	{
+		record->size = 0U;
+	}
+	else
+	{
+		record->size += delta;
+	}
+
+	record->exact &= exact;
+}
+
+/* Looks up record by path.  Returns its index or -1 if there is no such
+ * record. */
+static int
+find_record(const char path[])
+{
+	tree_val_t pos;
+	if(paths == NULL_TREE || tree_get_data(paths, path, &pos) != 0)
+	{
+		return -1;
+	}
+	return pos;
+}
+
+/* Appends new record for the path.  Returns its index or -1 on error. */
+static int
+add_record(const char path[])
+{
+	char *path_copy;
+
+	if(paths == NULL_TREE)
+	{
+		return -1;
+	}
+
+	if(nrecords == records_cap)
+	{
+		const int new_cap = (records_cap == 0) ? 64 : records_cap*2;
+		record_t *const new_records = reallocarray(records, new_cap,
+				sizeof(*new_records));
+		if(new_records == NULL)
+		{
+			return -1;
+		}
+		records = new_records;
+		records_cap = new_cap;
+	}
+
+	path_copy = strdup(path);
+	if(path_copy == NULL || tree_set_data(paths, path, nrecords) != 0)
+	{
+		free(path_copy);
+		return -1;
+	}
+
+	records[nrecords].path = path_copy;
+	return nrecords++;
+}
+
+/* Reads sizes from the file unless they are known already.  Each line of the
+ * file is "[~]<size> <dev> <ino> <mtime> <path>", where tilde marks
+ * estimates. */
+static void
+read_file(void)
+{
+	char file[PATH_MAX];
+	FILE *fp;
+	char *line = NULL;
+
+	if(!(cfg.vifm_info & VIFMINFO_DIRSIZES))
+	{
+		return;
+	}
+
+	if(get_file_path(file, sizeof(file)) != 0)
+	{
+		return;
+	}
+
+	fp = os_fopen(file, "r");
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	while((line = read_line(fp, line)) != NULL)
+	{
+		uint64_t size;
+		dir_stamp_t stamp;
+		int path_offset;
+		int pos;
+		const int exact = (line[0] != '~');
+		const char *const fields = exact ? line : line + 1;
+
+		if(sscanf(fields, "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNd64 "%n",
+					&size, &stamp.dev, &stamp.ino, &stamp.mtime, &path_offset) != 4 ||
+				fields[path_offset] != ' ' || fields[path_offset + 1] == '\0')
+		{
+			continue;
+		}
+
+		/* Sizes calculated during this session are newer. */
+		if(find_record(fields + path_offset + 1) >= 0)
+		{
+			continue;
+		}
+
+		pos = add_record(fields + path_offset + 1);
+		if(pos < 0)
+		{
+			free(line);
+			break;
+		}
+
+		records[pos].size = size;
+		records[pos].stamp = stamp;
+		records[pos].state = RS_UNCHECKED;
+		records[pos].exact = exact;
+	}
+
+	fclose(fp);
+}
+
+/* Replaces contents of the file with sizes that are known to be or might be
+ * up to date. */
+static void
+write_file(void)
+{
+	char file[PATH_MAX];
+	char tmp_file[PATH_MAX];
+	FILE *fp;
+	int i;
+	int len;
+
+	if(get_file_path(file, sizeof(file)) != 0)
+	{
+		LOG_ERROR_MSG("Path to dirsizes file is too long");
+		return;
+	}
+
+	len = snprintf(tmp_file, sizeof(tmp_file), "%s_%u", file, get_pid());
+	if(len < 0 || (size_t)len >= sizeof(tmp_file))
+	{
+		LOG_ERROR_MSG("Path to temporary dirsizes file is too long");
+		return;
+	}
+
+	fp = os_fopen(tmp_file, "w");
+	if(fp == NULL)
+	{
+		LOG_ERROR_MSG("Can't open %s for writing", tmp_file);
+		return;
+	}
+
+	for(i = 0; i < nrecords; ++i)
+	{
+		const record_t *const record = &records[i];
+		if(record->state != RS_STALE && strchr(record->path, '\n') == NULL)
+		{
+			fprintf(fp, "%s%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRId64 " %s\n",
+					record->exact ? "" : "~", record->size, record->stamp.dev,
+					record->stamp.ino, record->stamp.mtime, record->path);
+		}
+	}
+
+	fclose(fp);
+
+	if(rename_file(tmp_file, file) != 0)
+	{
+		LOG_ERROR_MSG("Can't replace dirsizes file with its temporary copy");
+		(void)remove(tmp_file);
+	}
+}
+
+/* Queries current state of the directory.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+get_stamp(const char path[], dir_stamp_t *stamp)
+{
+	struct stat st;
+	if(os_stat(path, &st) != 0)
+	{
+		return 1;
+	}
+
+	stamp->dev = st.st_dev;
+	stamp->ino = st.st_ino;
+	stamp->mtime = st.st_mtime;
+	return 0;
+}
+
+/* Compares two stamps.  Returns non-zero if they are equal, otherwise zero is
+ * returned. */
+static int
+stamps_equal(const dir_stamp_t *a, const dir_stamp_t *b)
+{
+	return a->dev == b->dev && a->ino == b->ino && a->mtime == b->mtime;
+}
+
+/* Formats path to the file with sizes of current kind.  Returns zero on
+ * success and non-zero if the path doesn't fit into the buffer. */
+static int
+get_file_path(char buf[], size_t buf_len)
+{
+	const int len = snprintf(buf, buf_len, "%s/dirsizes%s", cfg.config_dir,
+			cfg.disk_usage ? ".du" : "");
+	return len < 0 || (size_t)len >= buf_len;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,63 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__CFG__DIRSIZES_H__
+#define VIFM__CFG__DIRSIZES_H__
+
+#include <stdint.h> /* int64_t uint64_t */
+
+#include "../utils/dir_size.h"
+
+/* Cache of calculated sizes of directories.  When 'vifminfo' contains
+ * "dirsizes", it's stored in $VIFM/dirsizes file (or $VIFM/dirsizes.du for
+ * sizes calculated with 'diskusage' on) between runs.  The file is
+ * read on first lookup of a size, which is missing in memory, and sizes read
+ * from it are used only if device, inode and modification time of their
+ * directories didn't change.  Sizes adjusted after file operations without
+ * recalculation are estimates unless all sizes involved were known exactly.
+ * All functions are thread-safe. */
+
+/* Forgets all sizes.  The file is read again on the next lookup.  Returns zero
+ * on success, otherwise non-zero is returned. */
+int dirsizes_reset(void);
+
+/* Looks up size of the directory.  *exact (if exact isn't NULL) is set to zero
+ * for sizes that are estimates.  Returns zero and sets *size if it's known,
+ * otherwise non-zero is returned. */
+int dirsizes_get(const char path[], uint64_t *size, int *exact);
+
+/* Remembers size of the directory, which is an estimate unless exact is set.
+ * The stamp can be NULL, in which case it's obtained by querying the
+ * directory. */
+void dirsizes_set(const char path[], uint64_t size, int exact,
+		const dir_stamp_t *stamp);
+
+/* Adds delta to known sizes of the directory and its ancestors.  Ancestors that
+ * also contain the other path (can be NULL) are left untouched.  The sizes turn
+ * into estimates unless the delta is exact. */
+void dirsizes_update(const char path[], int64_t delta, int exact,
+		const char other[]);
+
+/* Writes sizes to $VIFM/dirsizes if they have changed and 'vifminfo' includes
+ * "dirsizes". */
+void dirsizes_write(void);
+
+#endif /* VIFM__CFG__DIRSIZES_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -54,6 +54,7 @@
 #include "../status.h"
 #include "../trash.h"
 #include "config.h"
+#include "dirsizes.h"
 #include "hist.h"
 #include "info_chars.h"
 
@@ -476,6 +477,8 @@ write_info_file(void)
 			(void)remove(tmp_file);
 		}
 	}
+
+	dirsizes_write();
 }
 
 /* Copies the src file to the dst location.  Returns zero on success. */
@@ -1052,6 +1055,8 @@ write_options(FILE *const fp)
 		fprintf(fp, ",dirstack");
 	if(cfg.vifm_info & VIFMINFO_REGISTERS)
 		fprintf(fp, ",registers");
+	if(cfg.vifm_info & VIFMINFO_DIRSIZES)
+		fprintf(fp, ",dirsizes");
 	fprintf(fp, "\n");
 
 	fprintf(fp, "=%svimhelp\n", cfg.use_vim_help ? "" : "no");
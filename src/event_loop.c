@@ -44,6 +44,7 @@
 #include "utils/utils.h"
 #include "background.h"
 #include "filelist.h"
+#include "flist_prefetch.h"
 #include "ipc.h"
 #include "status.h"
 
@@ -53,6 +54,7 @@ static void process_scheduled_updates(void);
 static int process_scheduled_updates_of_view(FileView *view);
 static int should_check_views_for_changes(void);
 static void check_view_for_changes(FileView *view);
+static void prefetch_for_curr_view(void);
 static void reset_input_buf(wchar_t curr_input_buf[],
 		size_t *curr_input_buf_pos);
 
@@ -311,6 +313,9 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 			process_scheduled_updates();
 		}
 
+		/* Cursor rests, use the time to read list of directory under it. */
+		prefetch_for_curr_view();
+
 		timeout -= cfg.min_timeout_len;
 	}
 	while(timeout > 0);
@@ -395,6 +400,18 @@ check_view_for_changes(FileView *view)
 	}
 }
 
+/* Starts reading list of directory under cursor in the current view in
+ * background if user is browsing files. */
+static void
+prefetch_for_curr_view(void)
+{
+	if(vle_mode_is(NORMAL_MODE) && !is_status_bar_multiline() &&
+			window_shows_dirlist(curr_view))
+	{
+		flist_prefetch(curr_view);
+	}
+}
+
 void
 update_input_buf(void)
 {
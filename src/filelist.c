@@ -20,7 +20,6 @@
 #include "filelist.h"
 
 #ifdef _WIN32
-#include <fcntl.h>
 #include <lm.h>
 #include <windows.h>
 #include <winioctl.h>
@@ -28,8 +27,9 @@
 
 #include <curses.h>
 
-#include <sys/stat.h> /* stat */
-#include <unistd.h> /* close() fork() pipe() */
+#include <sys/stat.h> /* stat fstatat() */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW O_CLOEXEC O_DIRECTORY O_RDONLY open() */
+#include <unistd.h> /* close() fork() pipe() readlinkat() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
@@ -37,11 +37,12 @@
 #include <stdint.h> /* uint64_t */
 #include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* abs() calloc() free() */
-#include <string.h> /* memcmp() memcpy() memset() strcat() strcmp() strcpy()
-                       strdup() strlen() */
+#include <string.h> /* memcmp() memcpy() memmove() memset() strcat() strcmp()
+                       strcpy() strdup() strlen() */
 #include <time.h> /* localtime() */
 
 #include "cfg/config.h"
+#include "cfg/dirsizes.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "compat/reallocarray.h"
@@ -49,6 +50,7 @@
 #include "int/fuse.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/modes.h"
+#include "ui/cancellation.h"
 #include "ui/fileview.h"
 #include "ui/statusbar.h"
 #include "ui/statusline.h"
@@ -57,17 +59,20 @@
 #include "utils/env.h"
 #include "utils/filemon.h"
 #include "utils/fs.h"
+#include "utils/fswatch.h"
 #include "utils/log.h"
 #include "utils/macros.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/str.h"
+#include "utils/str_arena.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
-#include "utils/tree.h"
 #include "utils/trie.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
 #include "filtering.h"
+#include "flist_cache.h"
 #include "macros.h"
 #include "opt_handlers.h"
 #include "running.h"
@@ -75,6 +80,22 @@
 #include "status.h"
 #include "types.h"
 
+/* Minimal number of entries whose meta-data is loaded by a single thread.
+ * Smaller lists are processed without spawning any threads. */
+#define METADATA_CHUNK 256
+
+/* Number of entries enumerated between updates of progress of reading a big
+ * directory and checks for cancellation. */
+#define PROGRESS_STEP 1024
+
+/* Number of files processed between checks for cancellation of reading a list
+ * in background. */
+#define CANCEL_CHECK_STEP 64
+
+/* Maximum number of new entries that are inserted into sorted list one by one
+ * instead of sorting the whole list anew. */
+#define MAX_INSERTED_ENTRIES 256
+
 /* Custom argument for is_in_list() function. */
 typedef struct
 {
@@ -83,6 +104,51 @@ typedef struct
 }
 list_t;
 
+/* State shared by threads that load meta-data of file entries. */
+typedef struct
+{
+	const FileView *view; /* View whose entries are processed. */
+	dir_entry_t *entries; /* Entries to be processed (start of the range). */
+	char *failed;         /* Whether loading failed, one per entry. */
+	char *affected;       /* Whether sorting is affected, per entry or NULL. */
+	size_t tracked;       /* Number of leading entries that have affected flag. */
+	int dir_fd;           /* Descriptor of directory that contains entries. */
+	const char *dir;      /* Path to directory that contains entries. */
+}
+metadata_job_t;
+
+/* State of applying changes reported by directory watcher. */
+typedef struct
+{
+	FileView *view; /* View whose list is being updated. */
+	int resort;     /* Whether list needs to be sorted. */
+	int reload;     /* Whether changes can't be applied and reload is needed. */
+	trie_t seen;    /* Names for which events were already applied. */
+}
+fs_changes_t;
+
+/* State of reading list of files of a directory. */
+typedef struct
+{
+	FileView *view;      /* View whose list is being read. */
+	int progressive;     /* Whether partial list is displayed while reading. */
+	int partial_shown;   /* Whether first screenful was displayed already. */
+	int metadata_loaded; /* Number of leading entries that have meta-data. */
+	int stopped;         /* Whether reading was stopped on purpose. */
+}
+read_dir_t;
+
+/* State of reading list of files that isn't bound to a view. */
+typedef struct
+{
+	dir_entry_t *entries;        /* List of read entries. */
+	int count;                   /* Number of entries in the list. */
+	int max_count;               /* Limit on number of entries. */
+	cancel_check_func cancelled; /* Checks whether reading should stop. */
+	void *arg;                   /* Argument for the cancelled callback. */
+}
+raw_read_t;
+
 /* Type of predicate functions to reason about entries.  Should return non-zero
  * if particular property holds and zero otherwise. */
 typedef int (*predicate_func)(const dir_entry_t *entry);
@@ -101,26 +167,58 @@ static void save_selection(FileView *view);
 static void free_saved_selection(FileView *view);
 static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
 #ifndef _WIN32
-static int fill_dir_entry(dir_entry_t *entry, const char path[],
-		const struct dirent *d);
-static int data_is_dir_entry(const struct dirent *d);
+static int fill_dir_entry_at(dir_entry_t *entry, int dir_fd, const char dir[]);
+static int lstat_dir_entry_at(dir_entry_t *entry, int dir_fd, const char dir[]);
+static void load_link_target_mode(dir_entry_t *entry, int dir_fd,
+		const char dir[]);
+static int fill_dir_entry_from_stat(dir_entry_t *entry, const struct stat *s);
+static int link_targets_slower_fs(int dir_fd, const char dir[],
+		const dir_entry_t *entry);
+static int data_is_dir_entry(const dir_batch_entry_t *entry);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const WIN32_FIND_DATAW *ffd);
 static int data_is_dir_entry(const WIN32_FIND_DATAW *ffd);
 #endif
 static int is_in_list(FileView *view, const dir_entry_t *entry, void *arg);
+static uint64_t get_entries_mem_usage(const FileView *view,
+		const dir_entry_t entries[], int count);
 static void load_dir_list_internal(FileView *view, int reload, int draw_only);
 static int populate_dir_list_internal(FileView *view, int reload);
+#ifndef _WIN32
+static int restore_cached_list(FileView *view);
+static void finish_raw_list(FileView *view);
+static int is_visible_raw_entry(FileView *view, const dir_entry_t *entry,
+		void *arg);
+static int add_raw_entries(const dir_batch_entry_t entries[], int count,
+		void *param);
+static int add_raw_entry(raw_read_t *rr, const dir_batch_entry_t *d);
+static void free_raw_entries(dir_entry_t *entries, int count);
+#endif
 static int is_dead_or_filtered(FileView *view, const dir_entry_t *entry,
 		void *arg);
 static void update_entries_data(FileView *view);
 static int is_dir_big(const char path[]);
 static void free_view_entries(FileView *view);
-static int update_dir_list(FileView *view, int reload);
+static int update_dir_list(FileView *view, int reload, int progressive);
+#ifndef _WIN32
+static int add_file_entries_to_view(const dir_batch_entry_t entries[],
+		int count, void *param);
+#endif
 static int add_file_entry_to_view(const char name[], const void *data,
 		void *param);
+static int report_reading_progress(read_dir_t *rd);
+static void show_partial_list(read_dir_t *rd);
+#ifndef _WIN32
+static int load_entries_metadata(FileView *view, int from, int known,
+		int *order_changed);
+static void load_metadata_range(size_t from, size_t to, void *arg);
+static int has_metadata(FileView *view, const dir_entry_t *entry, void *arg);
+static int insert_new_entries(FileView *view, int from);
+#endif
 static void sort_dir_list(int msg, FileView *view);
+static int merge_reloaded_list(FileView *view, dir_entry_t *prev,
+		int prev_count, int trusted);
 static void merge_lists(FileView *view, dir_entry_t *entries, int len);
 static void merge_entries(dir_entry_t *new, const dir_entry_t *prev);
 static int correct_pos(FileView *view, int pos, int dist, int closes);
@@ -136,6 +234,13 @@ static void find_dir_in_cdpath(const char base_dir[], const char dst[],
 		char buf[], size_t buf_size);
 static int iter_entries(FileView *view, dir_entry_t **entry,
 		predicate_func pred);
+#ifndef _WIN32
+static int process_dir_watch(FileView *view);
+static void apply_fs_event(FSWatchEvent event, const char name[], void *arg);
+static void add_created_entry(fs_changes_t *changes, const char name[],
+		const char path[]);
+static void remove_entry(FileView *view, int pos);
+#endif
 static int is_entry_selected(const dir_entry_t *entry);
 static int is_entry_marked(const dir_entry_t *entry);
 static void clear_marking(FileView *view);
@@ -183,10 +288,12 @@ init_flist(FileView *view)
 	view->custom.orig_dir = NULL;
 	view->custom.title = NULL;
 
+	view->names = str_arena_create();
+
 	/* Load fake empty element to make dir_entry valid. */
 	view->dir_entry = dynarray_extend(NULL, sizeof(dir_entry_t));
 	memset(view->dir_entry, 0, sizeof(*view->dir_entry));
-	view->dir_entry[0].name = strdup("");
+	view->dir_entry[0].name = str_arena_dup(view->names, "");
 	view->dir_entry[0].type = FT_DIR;
 	view->dir_entry[0].hi_num = -1;
 	view->dir_entry[0].origin = &view->curr_dir[0];
@@ -889,6 +996,9 @@ change_directory(FileView *view, const char directory[])
 	if(is_dir_list_loaded(view))
 	{
 		save_view_history(view, NULL, NULL, -1);
+#ifndef _WIN32
+		flist_cache_put(view, &view->mon);
+#endif
 	}
 
 	if(cfg.chase_links)
@@ -1181,6 +1291,9 @@ flist_custom_start(FileView *view, const char title[])
 	free_dir_entries(view, &view->custom.entries, &view->custom.entry_count);
 	(void)replace_string(&view->custom.title, title);
 
+	/* Let memory of current list go away along with the list. */
+	str_arena_new_gen(view->names);
+
 	view->custom.paths_cache = trie_create();
 }
 
@@ -1188,6 +1301,7 @@ void
 flist_custom_add(FileView *view, const char path[])
 {
 	char canonic_path[PATH_MAX];
+	char origin[PATH_MAX];
 	dir_entry_t *dir_entry;
 
 	if(to_canonic_path(path, canonic_path, sizeof(canonic_path)) != 0)
@@ -1209,8 +1323,11 @@ flist_custom_add(FileView *view, const char path[])
 
 	init_dir_entry(view, dir_entry, get_last_path_component(canonic_path));
 
-	dir_entry->origin = strdup(canonic_path);
-	remove_last_path_component(dir_entry->origin);
+	/* Files of custom views usually come from a handful of directories, so
+	 * there is no point in keeping a copy of origin per file. */
+	copy_str(origin, sizeof(origin), canonic_path);
+	remove_last_path_component(origin);
+	dir_entry->origin = str_arena_intern(view->names, origin);
 
 	if(fill_dir_entry_by_path(dir_entry, canonic_path) != 0)
 	{
@@ -1224,69 +1341,188 @@ flist_custom_add(FileView *view, const char path[])
 #ifndef _WIN32
 
 /* Fills directory entry with information about file specified by the path.
- * Returns non-zero on error, otherwise zero is returned. */
+ * Type previously stored in the entry is used as a fallback.  Returns non-zero
+ * on error, otherwise zero is returned. */
 static int
 fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
 {
-	return fill_dir_entry(entry, path, NULL);
+	struct stat s;
+
+	/* Load the inode information or leave blank values in the entry. */
+	if(os_lstat(path, &s) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Can't lstat() \"%s\"", path);
+		return 1;
+	}
+
+	if(fill_dir_entry_from_stat(entry, &s) != 0)
+	{
+		LOG_ERROR_MSG("Can't determine type of \"%s\"", path);
+		return 1;
+	}
+
+	if(entry->type == FT_LINK)
+	{
+		if(get_symlink_type(path) == SLT_SLOW)
+		{
+			entry->link_state = LTS_VALID;
+		}
+		else if(os_stat(path, &s) == 0)
+		{
+			/* Query mode of symbolic link target. */
+			entry->mode = s.st_mode;
+			entry->link_state = LTS_VALID;
+		}
+		else
+		{
+			entry->link_state = LTS_BROKEN;
+		}
+	}
+
+	return 0;
+}
+
+/* Fills directory entry with information about file named after the entry,
+ * which resides in directory specified by its descriptor and path.  Unlike
+ * fill_dir_entry_by_path(), doesn't depend on current working directory and
+ * avoids walking the path for every file.  Type previously stored in the entry
+ * is used as a fallback.  Returns non-zero on error, otherwise zero is
+ * returned. */
+static int
+fill_dir_entry_at(dir_entry_t *entry, int dir_fd, const char dir[])
+{
+	if(lstat_dir_entry_at(entry, dir_fd, dir) != 0)
+	{
+		return 1;
+	}
+
+	load_link_target_mode(entry, dir_fd, dir);
+	return 0;
 }
 
-/* Fills fields of the entry from stat information of the file specified by its
- * path.  d is optional source of file type.  Returns zero on success, otherwise
- * non-zero is returned. */
+/* Same as fill_dir_entry_at(), but doesn't query mode of targets of symbolic
+ * links.  Returns non-zero on error, otherwise zero is returned. */
 static int
-fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
+lstat_dir_entry_at(dir_entry_t *entry, int dir_fd, const char dir[])
 {
 	struct stat s;
 
 	/* Load the inode information or leave blank values in the entry. */
-	if(os_lstat(path, &s) != 0)
+	if(fstatat(dir_fd, entry->name, &s, AT_SYMLINK_NOFOLLOW) != 0)
 	{
-		LOG_SERROR_MSG(errno, "Can't lstat() \"%s\"", path);
+		LOG_SERROR_MSG(errno, "Can't lstat() \"%s/%s\"", dir, entry->name);
 		return 1;
 	}
 
-	entry->type = get_type_from_mode(s.st_mode);
-	if(entry->type == FT_UNK)
+	if(fill_dir_entry_from_stat(entry, &s) != 0)
+	{
+		LOG_ERROR_MSG("Can't determine type of \"%s/%s\"", dir, entry->name);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Replaces mode of symbolic link entry with mode of its target unless it
+ * resides on slower file system and records whether the link is broken.  Does
+ * nothing for other kinds of entries. */
+static void
+load_link_target_mode(dir_entry_t *entry, int dir_fd, const char dir[])
+{
+	struct stat s;
+
+	if(entry->type != FT_LINK)
+	{
+		return;
+	}
+
+	if(link_targets_slower_fs(dir_fd, dir, entry))
+	{
+		entry->link_state = LTS_VALID;
+	}
+	else if(fstatat(dir_fd, entry->name, &s, 0) == 0)
+	{
+		/* Query mode of symbolic link target. */
+		entry->mode = s.st_mode;
+		entry->link_state = LTS_VALID;
+	}
+	else
 	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
+		entry->link_state = LTS_BROKEN;
+	}
+}
+
+/* Fills fields of the entry from stat information.  Type previously stored in
+ * the entry is used if file mode doesn't correspond to any known type.
+ * Returns zero on success and non-zero if type of file is unknown. */
+static int
+fill_dir_entry_from_stat(dir_entry_t *entry, const struct stat *s)
+{
+	const FileType type = get_type_from_mode(s->st_mode);
+	if(type != FT_UNK)
+	{
+		entry->type = type;
 	}
 	if(entry->type == FT_UNK)
 	{
-		LOG_ERROR_MSG("Can't determine type of \"%s\"", path);
 		return 1;
 	}
 
-	entry->size = (uintmax_t)s.st_size;
-	entry->mode = s.st_mode;
-	entry->uid = s.st_uid;
-	entry->gid = s.st_gid;
-	entry->mtime = s.st_mtime;
-	entry->atime = s.st_atime;
-	entry->ctime = s.st_ctime;
+	entry->size = (uintmax_t)s->st_size;
+	entry->mode = s->st_mode;
+	entry->link_state = LTS_UNKNOWN;
+	entry->uid = s->st_uid;
+	entry->gid = s->st_gid;
+	entry->mtime = s->st_mtime;
+	entry->atime = s->st_atime;
+	entry->ctime = s->st_ctime;
+	return 0;
+}
+
+/* Checks whether symbolic link entry in the directory specified by its
+ * descriptor and path points to a slower file system (see 'slowfs').  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+link_targets_slower_fs(int dir_fd, const char dir[], const dir_entry_t *entry)
+{
+	char full_path[PATH_MAX];
+	char link_target[PATH_MAX];
+	char target[PATH_MAX];
+	ssize_t len;
 
-	if(entry->type == FT_LINK)
+	/* Avoid reading the link when there are no slow file systems. */
+	if(cfg.slow_fs_list[0] == '\0')
 	{
-		/* Query mode of symbolic link target. */
+		return 0;
+	}
 
-		struct stat s;
+	len = readlinkat(dir_fd, entry->name, link_target, sizeof(link_target) - 1);
+	if(len == -1)
+	{
+		LOG_SERROR_MSG(errno, "Can't readlink \"%s/%s\"", dir, entry->name);
+		return 0;
+	}
+	link_target[len] = '\0';
 
-		const SymLinkType symlink_type = get_symlink_type(entry->name);
-		if(symlink_type != SLT_SLOW && os_stat(entry->name, &s) == 0)
-		{
-			entry->mode = s.st_mode;
-		}
+	snprintf(full_path, sizeof(full_path), "%s/%s", dir, entry->name);
+	if(is_path_absolute(link_target))
+	{
+		copy_str(target, sizeof(target), link_target);
+	}
+	else
+	{
+		snprintf(target, sizeof(target), "%s/%s", dir, link_target);
 	}
 
-	return 0;
+	return refers_to_slower_fs(full_path, target);
 }
 
 /* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
  * is returned. */
 static int
-data_is_dir_entry(const struct dirent *d)
+data_is_dir_entry(const dir_batch_entry_t *entry)
 {
-	return is_dirent_targets_dir(d);
+	return batch_entry_targets_dir(entry);
 }
 
 #else
@@ -1479,6 +1715,39 @@ flist_get_dir(const FileView *view)
 	return view->curr_dir;
 }
 
+uint64_t
+flist_get_mem_usage(const FileView *view)
+{
+	return get_entries_mem_usage(view, view->dir_entry, view->list_rows)
+	     + get_entries_mem_usage(view, view->custom.entries,
+	                             view->custom.entry_count)
+	     + str_arena_mem_usage(view->names);
+}
+
+/* Estimates amount of memory occupied by list of entries not counting strings
+ * that are stored in arena of the view.  Returns the amount in bytes. */
+static uint64_t
+get_entries_mem_usage(const FileView *view, const dir_entry_t entries[],
+		int count)
+{
+	int i;
+	uint64_t usage = (uint64_t)count*sizeof(*entries);
+	for(i = 0; i < count; ++i)
+	{
+		const dir_entry_t *const entry = &entries[i];
+		if(!str_arena_owns(view->names, entry->name))
+		{
+			usage += strlen(entry->name) + 1U;
+		}
+		if(entry->origin != &view->curr_dir[0] &&
+				!str_arena_owns(view->names, entry->origin))
+		{
+			usage += strlen(entry->origin) + 1U;
+		}
+	}
+	return usage;
+}
+
 void
 flist_goto_by_path(FileView *view, const char path[])
 {
@@ -1579,6 +1848,9 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 static int
 populate_dir_list_internal(FileView *view, int reload)
 {
+	int big;
+	int cached;
+
 	view->filtered = 0;
 
 	if(flist_custom_active(view))
@@ -1604,7 +1876,14 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 1;
 	}
 
-	if(!reload && is_dir_big(view->curr_dir))
+#ifndef _WIN32
+	cached = !reload && restore_cached_list(view);
+#else
+	cached = 0;
+#endif
+
+	big = !cached && !reload && is_dir_big(view->curr_dir);
+	if(big)
 	{
 		if(!vle_mode_is(CMDLINE_MODE))
 		{
@@ -1617,14 +1896,15 @@ populate_dir_list_internal(FileView *view, int reload)
 		update_all_windows();
 	}
 
-	/* this is needed for lstat() below */
+	/* Loading of entries doesn't depend on working directory, but the rest of
+	 * the code expects it to match directory of the view that was loaded. */
 	if(vifm_chdir(view->curr_dir) != 0 && !is_unc_root(view->curr_dir))
 	{
 		LOG_SERROR_MSG(errno, "Can't chdir() into \"%s\"", view->curr_dir);
 		return 1;
 	}
 
-	if(update_dir_list(view, reload) != 0)
+	if(!cached && update_dir_list(view, reload, big) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
@@ -1636,6 +1916,18 @@ populate_dir_list_internal(FileView *view, int reload)
 		clean_status_bar();
 	}
 
+	if(big && ui_cancellation_requested())
+	{
+		status_bar_message("Reading of directory was cancelled, list is partial");
+	}
+
+	if(big)
+	{
+		LOG_INFO_MSG("Loaded %d entries of \"%s\" (%" PRINTF_ULL " bytes)",
+				view->list_rows, view->curr_dir,
+				(unsigned long long)flist_get_mem_usage(view));
+	}
+
 	view->column_count = calculate_columns_count(view);
 
 	/* If reloading the same directory don't jump to history position.  Stay at
@@ -1662,110 +1954,345 @@ populate_dir_list_internal(FileView *view, int reload)
 	return 0;
 }
 
-/* zap_entries() filter to filter-out inexistent files or files which names
- * match local filter. */
+#ifndef _WIN32
+
+/* Replaces list of the view with cached list of its directory if it's still
+ * valid.  Returns non-zero if list was replaced, otherwise zero is returned. */
 static int
-is_dead_or_filtered(FileView *view, const dir_entry_t *entry, void *arg)
+restore_cached_list(FileView *view)
 {
-	if(!path_exists_at(entry->origin, entry->name, DEREF))
+	dir_entry_t *entries;
+	int count;
+	int raw;
+	int i;
+
+	if(flist_cache_take(view, &view->mon, &entries, &count, &view->filtered,
+				&raw) != 0)
 	{
 		return 0;
 	}
 
-	if(local_filter_matches(view, entry))
+	free_view_entries(view);
+	view->dir_entry = entries;
+	view->list_rows = count;
+	view->matches = 0;
+	view->selected_files = 0;
+
+	for(i = 0; i < count; ++i)
 	{
-		return 1;
+		entries[i].origin = &view->curr_dir[0];
 	}
 
-	++view->filtered;
-	return 0;
+	if(raw)
+	{
+		finish_raw_list(view);
+	}
+
+	return 1;
 }
 
-/* Re-read meta-data for each entry (does nothing for entries on which querying
- * fails). */
+/* Turns list of all files of current directory of the view into the one to be
+ * displayed by loading modes of targets of symbolic links, filtering and
+ * sorting it.  Doesn't list directory anew. */
 static void
-update_entries_data(FileView *view)
+finish_raw_list(FileView *view)
 {
-	int i;
-	for(i = 0; i < view->list_rows; ++i)
+	const int dir_fd = open(view->curr_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(dir_fd != -1)
 	{
-		dir_entry_t *const entry = &view->dir_entry[i];
+		int i;
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			load_link_target_mode(&view->dir_entry[i], dir_fd, view->curr_dir);
+		}
+		(void)close(dir_fd);
+	}
 
-		char full_path[PATH_MAX];
-		get_full_path_of(entry, sizeof(full_path), full_path);
+	view->filtered = zap_entries(view, view->dir_entry, &view->list_rows,
+			&is_visible_raw_entry, NULL, 1);
 
-		/* Do not care about possible failure, just use previous meta-data. */
-		(void)fill_dir_entry_by_path(entry, full_path);
+	if(cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)) ||
+			view->list_rows == 0)
+	{
+		add_parent_dir(view);
+	}
+
+	sort_dir_list(1, view);
+
+	view->dir_entry = dynarray_shrink(view->dir_entry);
+}
+
+/* zap_entries() filter to filter-out files that aren't displayed in the view.
+ * Returns non-zero if entry is to be kept and zero otherwise. */
+static int
+is_visible_raw_entry(FileView *view, const dir_entry_t *entry, void *arg)
+{
+	/* Modes of targets of symbolic links are loaded at this point, so there is
+	 * no need to query file system to check whether entry is a directory. */
+	const int is_dir = (entry->type == FT_DIR)
+	                || (entry->type == FT_LINK && S_ISDIR(entry->mode));
+
+	if(view->hide_dot && entry->name[0] == '.')
+	{
+		return 0;
 	}
+
+	return !filters_depend_on_type(view)
+	    || file_is_visible(view, entry->name, is_dir);
 }
 
 int
-zap_entries(FileView *view, dir_entry_t *entries, int *count, zap_filter filter,
-		void *arg, int allow_empty_list)
+flist_read_raw(const char dir[], int max_count, cancel_check_func cancelled,
+		void *arg, dir_entry_t **entries, int *count)
 {
+	raw_read_t rr = {
+		.max_count = max_count, .cancelled = cancelled, .arg = arg
+	};
+	int dir_fd;
 	int i, j;
 
+	if(enum_dir_batches(dir, 0U, &add_raw_entries, &rr) != 0)
+	{
+		free_raw_entries(rr.entries, rr.count);
+		return 1;
+	}
+
+	dir_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(dir_fd == -1)
+	{
+		LOG_SERROR_MSG(errno, "Can't open() \"%s\"", dir);
+		free_raw_entries(rr.entries, rr.count);
+		return 1;
+	}
+
 	j = 0;
-	for(i = 0; i < *count; ++i)
+	for(i = 0; i < rr.count; ++i)
 	{
-		dir_entry_t *const entry = &entries[i];
-		if(!filter(view, entry, arg))
+		dir_entry_t *const entry = &rr.entries[i];
+
+		if(i%CANCEL_CHECK_STEP == 0 && cancelled(arg))
 		{
-			free_dir_entry(view, entry);
-			continue;
+			break;
 		}
 
-		if(i != j)
+		if(lstat_dir_entry_at(entry, dir_fd, dir) != 0)
 		{
-			entries[j] = entries[i];
+			free(entry->name);
+			continue;
 		}
 
-		++j;
+		rr.entries[j++] = *entry;
 	}
 
-	*count = j;
+	(void)close(dir_fd);
 
-	if(*count == 0 && !allow_empty_list)
+	if(i != rr.count)
 	{
-		add_parent_dir(view);
+		/* Reading was cancelled, move unprocessed entries to be freed. */
+		while(i < rr.count)
+		{
+			rr.entries[j++] = rr.entries[i++];
+		}
+		free_raw_entries(rr.entries, j);
+		return 1;
 	}
 
-	return i - j;
+	*entries = rr.entries;
+	*count = j;
+	return 0;
 }
 
-/* Checks for subjectively relative size of a directory specified by the path
- * parameter.  Returns non-zero if size of the directory in question is
- * considered to be big. */
+/* enum_dir_batches() callback that appends files to a list that isn't bound
+ * to a view.  Returns zero on success or non-zero to indicate failure and stop
+ * enumeration. */
 static int
-is_dir_big(const char path[])
+add_raw_entries(const dir_batch_entry_t entries[], int count, void *param)
 {
-#ifndef _WIN32
-	struct stat s;
-	if(os_stat(path, &s) != 0)
+	raw_read_t *const rr = param;
+	int i;
+
+	if(rr->count + count > rr->max_count || rr->cancelled(rr->arg))
 	{
-		LOG_SERROR_MSG(errno, "Can't stat() \"%s\"", path);
 		return 1;
 	}
-	return s.st_size > s.st_blksize;
-#else
-	return 1;
-#endif
-}
 
-/* Frees list of directory entries of the view. */
-static void
-free_view_entries(FileView *view)
-{
-	free_dir_entries(view, &view->dir_entry, &view->list_rows);
-}
+	for(i = 0; i < count; ++i)
+	{
+		if(add_raw_entry(rr, &entries[i]) != 0)
+		{
+			return 1;
+		}
+	}
 
-/* Updates file list with files from current directory.  Returns zero on
+	return 0;
+}
+
+/* Appends single file to a list that isn't bound to a view.  Returns zero on
  * success, otherwise non-zero is returned. */
 static int
-update_dir_list(FileView *view, int reload)
+add_raw_entry(raw_read_t *rr, const dir_batch_entry_t *d)
+{
+	dir_entry_t *const entry = alloc_dir_entry(&rr->entries, rr->count);
+	if(entry == NULL)
+	{
+		return 1;
+	}
+
+	*entry = (dir_entry_t){
+		.name = strdup(d->name),
+		.uid = (uid_t)-1,
+		.gid = (gid_t)-1,
+		.type = type_from_dir_entry(d->type),
+		.list_num = -1,
+		.hi_num = -1,
+	};
+	if(entry->name == NULL)
+	{
+		return 1;
+	}
+
+	++rr->count;
+	return 0;
+}
+
+/* Frees list of entries that isn't bound to a view. */
+static void
+free_raw_entries(dir_entry_t *entries, int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(entries[i].name);
+	}
+	dynarray_free(entries);
+}
+
+#endif
+
+/* zap_entries() filter to filter-out inexistent files or files which names
+ * match local filter. */
+static int
+is_dead_or_filtered(FileView *view, const dir_entry_t *entry, void *arg)
+{
+	if(!path_exists_at(entry->origin, entry->name, DEREF))
+	{
+		return 0;
+	}
+
+	if(local_filter_matches(view, entry))
+	{
+		return 1;
+	}
+
+	++view->filtered;
+	return 0;
+}
+
+/* Re-read meta-data for each entry (does nothing for entries on which querying
+ * fails). */
+static void
+update_entries_data(FileView *view)
+{
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		char full_path[PATH_MAX];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+
+		/* Do not care about possible failure, just use previous meta-data. */
+		(void)fill_dir_entry_by_path(entry, full_path);
+	}
+}
+
+int
+zap_entries(FileView *view, dir_entry_t *entries, int *count, zap_filter filter,
+		void *arg, int allow_empty_list)
+{
+	int i, j;
+
+	j = 0;
+	for(i = 0; i < *count; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+		if(!filter(view, entry, arg))
+		{
+			free_dir_entry(view, entry);
+			continue;
+		}
+
+		if(i != j)
+		{
+			entries[j] = entries[i];
+		}
+
+		++j;
+	}
+
+	*count = j;
+
+	if(*count == 0 && !allow_empty_list)
+	{
+		add_parent_dir(view);
+	}
+
+	return i - j;
+}
+
+/* Checks for subjectively relative size of a directory specified by the path
+ * parameter.  Returns non-zero if size of the directory in question is
+ * considered to be big. */
+static int
+is_dir_big(const char path[])
+{
+#ifndef _WIN32
+	struct stat s;
+	if(os_stat(path, &s) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Can't stat() \"%s\"", path);
+		return 1;
+	}
+	return s.st_size > s.st_blksize;
+#else
+	return 1;
+#endif
+}
+
+/* Frees list of directory entries of the view. */
+static void
+free_view_entries(FileView *view)
+{
+	free_dir_entries(view, &view->dir_entry, &view->list_rows);
+}
+
+/* Updates file list with files from current directory.  The progressive
+ * parameter enables displaying of first screenful of files before the whole
+ * directory is read and cancellation of reading.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+update_dir_list(FileView *view, int reload, int progressive)
 {
 	dir_entry_t *prev_dir_entries = NULL;
 	int prev_list_rows = 0;
+	int result;
+	read_dir_t rd = { .view = view, .progressive = progressive };
+#ifndef _WIN32
+	int trusted = 0;
+	int watched;
+
+	if(reload)
+	{
+		/* Make sure list is up to date with reported changes before deciding
+		 * whether it can be trusted. */
+		trusted = cfg.trust_notify && process_dir_watch(view) == 0 &&
+		          view->watch_covers_list;
+	}
+
+	/* Changes made while the directory is being read will be reported. */
+	watched = view->watch != NULL &&
+	          stroscmp(view->watched_dir, view->curr_dir) == 0;
+#endif
 
 	if(reload)
 	{
@@ -1779,6 +2306,9 @@ update_dir_list(FileView *view, int reload)
 		free_view_entries(view);
 	}
 
+	/* Names of the new list shouldn't keep memory of the previous one alive. */
+	str_arena_new_gen(view->names);
+
 	view->matches = 0;
 	view->selected_files = 0;
 
@@ -1791,13 +2321,54 @@ update_dir_list(FileView *view, int reload)
 	}
 #endif
 
-	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
+	if(progressive)
+	{
+		ui_cancellation_reset();
+		ui_cancellation_enable();
+	}
+
+#ifndef _WIN32
+	result = enum_dir_batches(view->curr_dir, 0U, &add_file_entries_to_view,
+			&rd);
+	if(rd.stopped)
+	{
+		/* Not an error, use whatever was read. */
+		result = 0;
+	}
+#else
+	result = enum_dir_content(view->curr_dir, &add_file_entry_to_view, &rd);
+#endif
+
+	if(progressive)
+	{
+		ui_cancellation_disable();
+	}
+
+	if(result != 0)
 	{
 		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
 		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
 		return 1;
 	}
 
+#ifndef _WIN32
+	if(reload)
+	{
+		result = merge_reloaded_list(view, prev_dir_entries, prev_list_rows,
+				trusted);
+		view->watch_covers_list = (result == 0 && watched);
+		return result;
+	}
+
+	if(load_entries_metadata(view, rd.metadata_loaded, 0, NULL) != 0)
+	{
+		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
+		return 1;
+	}
+
+	view->watch_covers_list = watched;
+#endif
+
 	if(cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)) ||
 			view->list_rows == 0)
 	{
@@ -1819,12 +2390,39 @@ update_dir_list(FileView *view, int reload)
 	return 0;
 }
 
-/* enum_dir_content() callback that appends files to file list.  Returns zero on
- * success or non-zero to indicate failure and stop enumeration. */
+#ifndef _WIN32
+
+/* enum_dir_batches() callback that appends files to file list.  Returns zero
+ * on success or non-zero to stop enumeration. */
+static int
+add_file_entries_to_view(const dir_batch_entry_t entries[], int count,
+		void *param)
+{
+	read_dir_t *const rd = param;
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		if(add_file_entry_to_view(entries[i].name, &entries[i], rd) != 0)
+		{
+			rd->stopped = 1;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+#endif
+
+/* Appends file to file list.  On *nix data points to dir_batch_entry_t, on
+ * Windows to WIN32_FIND_DATAW.  Returns zero on success or non-zero to indicate
+ * failure and stop enumeration. */
 static int
 add_file_entry_to_view(const char name[], const void *data, void *param)
 {
-	FileView *const view = param;
+	read_dir_t *const rd = param;
+	FileView *const view = rd->view;
 	dir_entry_t *entry;
 
 	/* Always ignore the "." and ".." directories. */
@@ -1839,7 +2437,10 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 		return 0;
 	}
 
-	if(!file_is_visible(view, name, data_is_dir_entry(data)))
+	/* Checking whether entry is a directory might involve stat() calls, so do
+	 * it only when result of the check is actually needed. */
+	if(filters_depend_on_type(view) &&
+			!file_is_visible(view, name, data_is_dir_entry(data)))
 	{
 		++view->filtered;
 		return 0;
@@ -1854,6 +2455,12 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 
 	init_dir_entry(view, entry, name);
 
+#ifndef _WIN32
+	/* Meta-data is loaded for all entries at once after enumeration, just
+	 * remember type reported by the directory entry to use it as a fallback. */
+	entry->type = type_from_dir_entry(((const dir_batch_entry_t *)data)->type);
+	++view->list_rows;
+#else
 	if(fill_dir_entry(entry, entry->name, data) == 0)
 	{
 		++view->list_rows;
@@ -1861,11 +2468,404 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 	else
 	{
 		free_dir_entry(view, entry);
+		return 0;
+	}
+#endif
+
+	return rd->progressive ? report_reading_progress(rd) : 0;
+}
+
+/* Keeps user informed about reading of a big directory and checks whether it
+ * should be stopped.  Returns non-zero if reading was cancelled, otherwise zero
+ * is returned. */
+static int
+report_reading_progress(read_dir_t *rd)
+{
+	FileView *const view = rd->view;
+
+	if(!rd->partial_shown && view->window_cells != 0U &&
+			view->list_rows >= (int)view->window_cells)
+	{
+		show_partial_list(rd);
 	}
 
+	if(view->list_rows%PROGRESS_STEP != 0)
+	{
+		return 0;
+	}
+
+	if(!vle_mode_is(CMDLINE_MODE))
+	{
+		ui_sb_quick_msgf("Reading directory... %d items (Ctrl-C to stop)",
+				view->list_rows);
+	}
+
+	return ui_cancellation_requested();
+}
+
+/* Displays files that were read so far, so that there is something to look at
+ * while the rest of the directory is being read. */
+static void
+show_partial_list(read_dir_t *rd)
+{
+	FileView *const view = rd->view;
+
+	rd->partial_shown = 1;
+
+#ifndef _WIN32
+	if(load_entries_metadata(view, rd->metadata_loaded, 0, NULL) != 0)
+	{
+		return;
+	}
+#endif
+	rd->metadata_loaded = view->list_rows;
+
+	if(view->list_rows == 0)
+	{
+		return;
+	}
+
+	/* Entries read so far are a small part of the directory, so sorting them is
+	 * cheap and makes partial list look like the complete one. */
+	sort_view(view);
+
+	view->list_pos = 0;
+	view->top_line = 0;
+	view->curr_line = 0;
+	view->column_count = calculate_columns_count(view);
+	draw_dir_list(view);
+
+	if(!vle_mode_is(CMDLINE_MODE))
+	{
+		ui_sb_quick_msgf("Reading directory... %d items (Ctrl-C to stop)",
+				view->list_rows);
+	}
+}
+
+#ifndef _WIN32
+
+/* Loads meta-data of entries of the view starting with the one at the from
+ * index and removes entries for which it's unavailable.  Large lists are
+ * processed by several threads, while the order of entries stays the same.
+ * Entries before the known index are expected to have meta-data already.
+ * When order_changed isn't NULL, *order_changed is set to whether updating
+ * meta-data of such entries might have affected sorting.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+load_entries_metadata(FileView *view, int from, int known, int *order_changed)
+{
+	metadata_job_t job;
+	const int count = view->list_rows - from;
+	const int tracked = (order_changed == NULL || known <= from)
+	                  ? 0
+	                  : MIN(known, view->list_rows) - from;
+
+	if(order_changed != NULL)
+	{
+		*order_changed = 0;
+	}
+
+	if(count <= 0)
+	{
+		return 0;
+	}
+
+	job.dir = view->curr_dir;
+	job.dir_fd = open(job.dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(job.dir_fd == -1)
+	{
+		LOG_SERROR_MSG(errno, "Can't open() \"%s\"", job.dir);
+		return 1;
+	}
+
+	job.view = view;
+	job.entries = view->dir_entry + from;
+	job.failed = calloc(count, sizeof(*job.failed));
+	job.affected = (tracked == 0) ? NULL : calloc(tracked, sizeof(*job.affected));
+	job.tracked = tracked;
+	if(job.failed == NULL || (tracked != 0 && job.affected == NULL))
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		free(job.failed);
+		free(job.affected);
+		(void)close(job.dir_fd);
+		return 1;
+	}
+
+	parallel_for(count, METADATA_CHUNK, &load_metadata_range, &job);
+
+	if(order_changed != NULL)
+	{
+		int i;
+		for(i = 0; i < tracked && !*order_changed; ++i)
+		{
+			*order_changed = job.affected[i];
+		}
+	}
+
+	(void)zap_entries(view, view->dir_entry, &view->list_rows, &has_metadata,
+			&job, 1);
+
+	free(job.affected);
+	free(job.failed);
+	(void)close(job.dir_fd);
 	return 0;
 }
 
+/* Turns list of previously loaded entries into the one that was just read into
+ * the view, reusing entries of files that still exist.  Meta-data is re-read
+ * for all entries unless the list is trusted to be up to date, in which case
+ * it's loaded only for new entries.  The list is resorted only if order of its
+ * entries might have changed.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+merge_reloaded_list(FileView *view, dir_entry_t *prev, int prev_count,
+		int trusted)
+{
+	int i;
+	int count;
+	int kept;
+	int pos;
+	int order_changed;
+	int has_parent;
+	int resort;
+	dir_entry_t *const read = view->dir_entry;
+	const int read_count = view->list_rows;
+	const int parent_visible =
+		cfg_parent_dir_is_visible(is_root_dir(view->curr_dir));
+	trie_t names;
+
+	names = trie_create();
+	if(names == NULL_TRIE)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		free_dir_entries(view, &prev, &prev_count);
+		return 1;
+	}
+
+	if(read_count != 0)
+	{
+		dir_entry_t *const extended =
+			dynarray_extend(prev, sizeof(*prev)*read_count);
+		if(extended == NULL)
+		{
+			show_error_msg("Memory Error", "Unable to allocate enough memory");
+			trie_free(names);
+			free_dir_entries(view, &prev, &prev_count);
+			return 1;
+		}
+		prev = extended;
+	}
+
+	for(i = 0; i < read_count; ++i)
+	{
+		(void)trie_set(names, read[i].name, &read[i]);
+	}
+
+	/* Drop entries of files that are gone preserving order of the rest and
+	 * keeping cursor at the same file or at the next one after it. */
+	count = 0;
+	pos = 0;
+	has_parent = 0;
+	for(i = 0; i < prev_count; ++i)
+	{
+		dir_entry_t *const entry = &prev[i];
+		void *data;
+
+		if(is_parent_dir(entry->name))
+		{
+			if(!parent_visible)
+			{
+				free_dir_entry(view, entry);
+				continue;
+			}
+			has_parent = 1;
+			/* Move the name to current generation of the arena. */
+			(void)fentry_rename(view, entry, entry->name);
+		}
+		else if(trie_get(names, entry->name, &data) != 0 || data == NULL)
+		{
+			free_dir_entry(view, entry);
+			continue;
+		}
+		else
+		{
+			/* Take name of the duplicate, which is freed below, so that memory of
+			 * the previous list doesn't outlive it. */
+			dir_entry_t *const dup = data;
+			char *const name = dup->name;
+			dup->name = entry->name;
+			entry->name = name;
+
+			/* Mark the entry as reused. */
+			(void)trie_set(names, entry->name, NULL);
+		}
+
+		entry->search_match = 0;
+		entry->marked = 0;
+		/* Targets of links aren't watched, so resolve them again on next
+		 * redraw. */
+		entry->link_state = LTS_UNKNOWN;
+		prev[count++] = *entry;
+		pos += (i < view->list_pos);
+	}
+	kept = count;
+
+	/* Append entries of new files and free duplicates of reused ones. */
+	for(i = 0; i < read_count; ++i)
+	{
+		void *data;
+		(void)trie_get(names, read[i].name, &data);
+		if(data == NULL)
+		{
+			free_dir_entry(view, &read[i]);
+			continue;
+		}
+		prev[count++] = read[i];
+	}
+
+	trie_free(names);
+	dynarray_free(read);
+
+	view->dir_entry = prev;
+	view->list_rows = count;
+	view->list_pos = pos;
+
+	if(load_entries_metadata(view, trusted ? kept : 0, kept,
+			&order_changed) != 0)
+	{
+		return 1;
+	}
+
+	/* New entries stay at the end unless some of the old ones were dropped while
+	 * loading meta-data, which can happen only when it's loaded for all of
+	 * them. */
+	resort = order_changed || (!trusted && view->list_rows != count);
+
+	if((parent_visible && !has_parent) || view->list_rows == 0)
+	{
+		add_parent_dir(view);
+		resort = 1;
+	}
+
+	view->selected_files = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		view->selected_files += (view->dir_entry[i].selected != 0);
+	}
+
+	flist_ensure_pos_is_valid(view);
+	if(resort || insert_new_entries(view, kept) != 0)
+	{
+		resort_dir_list(0, view);
+	}
+
+	view->dir_entry = dynarray_shrink(view->dir_entry);
+	return 0;
+}
+
+/* parallel_for() callback that loads meta-data of a range of entries. */
+static void
+load_metadata_range(size_t from, size_t to, void *arg)
+{
+	metadata_job_t *const job = arg;
+
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		dir_entry_t *const entry = &job->entries[i];
+		const dir_entry_t was = *entry;
+
+		job->failed[i] = (fill_dir_entry_at(entry, job->dir_fd, job->dir) != 0);
+
+		if(i < job->tracked && !job->failed[i] &&
+				sort_is_affected(job->view, &was, entry))
+		{
+			job->affected[i] = 1;
+			if(was.type != entry->type)
+			{
+				entry->hi_num = -1;
+			}
+		}
+	}
+}
+
+/* zap_entries() filter to filter-out entries for which meta-data loading
+ * failed.  Entries that weren't processed by the job are kept.  Returns
+ * non-zero if entry is to be kept and zero otherwise. */
+static int
+has_metadata(FileView *view, const dir_entry_t *entry, void *arg)
+{
+	const metadata_job_t *const job = arg;
+	return entry < job->entries || !job->failed[entry - job->entries];
+}
+
+/* Moves entries starting at the from index into their places in sorted list
+ * preceding them, which costs O(log n) comparisons per entry instead of sorting
+ * the whole list.  Cursor and scrolling position stay on the same entry.
+ * Returns zero on success and non-zero if the list needs to be resorted. */
+static int
+insert_new_entries(FileView *view, int from)
+{
+	dir_entry_t *const entries = view->dir_entry;
+	const int count = view->list_rows - from;
+	dir_entry_t *added;
+	int i;
+	int end, dst;
+	int shift;
+
+	if(count == 0)
+	{
+		return 0;
+	}
+	if(count > MAX_INSERTED_ENTRIES || count > from)
+	{
+		return 1;
+	}
+
+	added = reallocarray(NULL, count, sizeof(*added));
+	if(added == NULL)
+	{
+		return 1;
+	}
+
+	/* Order new entries among themselves. */
+	for(i = 0; i < count; ++i)
+	{
+		const int pos = sort_find_insert_pos(view, added, i, &entries[from + i]);
+		memmove(&added[pos + 1], &added[pos], sizeof(*added)*(i - pos));
+		added[pos] = entries[from + i];
+	}
+
+	/* Merge them into the list from its end, so that each old entry is moved at
+	 * most once. */
+	end = from;
+	dst = view->list_rows;
+	shift = 0;
+	for(i = count - 1; i >= 0; --i)
+	{
+		const int pos = sort_find_insert_pos(view, entries, end, &added[i]);
+
+		dst -= end - pos;
+		memmove(&entries[dst], &entries[pos], sizeof(*entries)*(end - pos));
+		entries[--dst] = added[i];
+		end = pos;
+
+		shift += (pos <= view->list_pos);
+	}
+
+	free(added);
+
+	if(view->list_pos < from)
+	{
+		view->list_pos += shift;
+		view->top_line += shift;
+	}
+	return 0;
+}
+
+#endif
+
 void
 resort_dir_list(int msg, FileView *view)
 {
@@ -1919,7 +2919,8 @@ merge_lists(FileView *view, dir_entry_t *entries, int len)
 		(void)code;
 
 		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
+		str_arena_release(view->names, entries[i].name);
+		entries[i].name = NULL;
 	}
 
 	closes_dist = INT_MIN;
@@ -2014,6 +3015,7 @@ add_parent_dir(FileView *view)
 {
 	dir_entry_t *dir_entry;
 	struct stat s;
+	char path[PATH_MAX];
 
 	dir_entry = alloc_dir_entry(&view->dir_entry, view->list_rows);
 	if(dir_entry == NULL)
@@ -2026,12 +3028,11 @@ add_parent_dir(FileView *view)
 	dir_entry->type = FT_DIR;
 
 	/* Load the inode info or leave blank values in dir_entry. */
-	if(os_lstat(dir_entry->name, &s) != 0)
+	snprintf(path, sizeof(path), "%s/%s", flist_get_dir(view), dir_entry->name);
+	if(os_lstat(path, &s) != 0)
 	{
 		free_dir_entry(view, dir_entry);
-		LOG_SERROR_MSG(errno, "Can't lstat() \"%s/%s\"", view->curr_dir,
-				dir_entry->name);
-		log_cwd();
+		LOG_SERROR_MSG(errno, "Can't lstat() \"%s\"", path);
 		return;
 	}
 
@@ -2053,7 +3054,7 @@ add_parent_dir(FileView *view)
 static void
 init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 {
-	entry->name = strdup(name);
+	entry->name = str_arena_dup(view->names, name);
 	entry->origin = &view->curr_dir[0];
 
 	entry->size = 0ULL;
@@ -2071,6 +3072,7 @@ init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 
 	entry->type = FT_UNK;
 	entry->hi_num = -1;
+	entry->link_state = LTS_UNKNOWN;
 
 	/* All files start as unselected, unmatched and unmarked. */
 	entry->selected = 0;
@@ -2096,12 +3098,15 @@ replace_dir_entries(FileView *view, dir_entry_t **entries, int *count,
 
 	memcpy(new, with_entries, sizeof(*new)*with_count);
 
+	/* Let memory of the list that is replaced go away along with it. */
+	str_arena_new_gen(view->names);
+
 	for(i = 0; i < with_count; ++i)
 	{
 		dir_entry_t *const entry = &new[i];
 
-		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
+		entry->name = str_arena_dup(view->names, entry->name);
+		entry->origin = str_arena_intern(view->names, entry->origin);
 
 		if(entry->name == NULL || entry->origin == NULL)
 		{
@@ -2135,16 +3140,31 @@ free_dir_entries(FileView *view, dir_entry_t **entries, int *count)
 void
 free_dir_entry(const FileView *view, dir_entry_t *entry)
 {
-	free(entry->name);
+	str_arena_release(view->names, entry->name);
 	entry->name = NULL;
 
 	if(entry->origin != &view->curr_dir[0])
 	{
-		free(entry->origin);
+		str_arena_release(view->names, entry->origin);
 		entry->origin = NULL;
 	}
 }
 
+int
+fentry_rename(const FileView *view, dir_entry_t *entry, const char name[])
+{
+	/* Name can point to the old name, so release it only after making copy. */
+	char *const new_name = str_arena_dup(view->names, name);
+	if(new_name == NULL)
+	{
+		return 1;
+	}
+
+	str_arena_release(view->names, entry->name);
+	entry->name = new_name;
+	return 0;
+}
+
 int
 add_dir_entry(dir_entry_t **list, size_t *list_size, const dir_entry_t *entry)
 {
@@ -2187,6 +3207,11 @@ check_if_filelist_have_changed(FileView *view)
 	}
 
 #ifndef _WIN32
+	/* Not all file systems report every change (e.g. network ones don't know
+	 * about remote changes), so regular check is performed anyway.  It doesn't
+	 * cause reloads for changes that were already applied. */
+	(void)process_dir_watch(view);
+
 	{
 		filemon_t mon;
 		failed = filemon_from_file(view->curr_dir, &mon) != 0;
@@ -2222,6 +3247,215 @@ check_if_filelist_have_changed(FileView *view)
 	}
 }
 
+#ifndef _WIN32
+
+/* Applies changes reported by watcher of directory of the view and sets up the
+ * watcher when directory changes.  Returns zero if the list is up to date with
+ * all changes reported by the watcher, otherwise non-zero is returned. */
+static int
+process_dir_watch(FileView *view)
+{
+	fs_changes_t changes = { .view = view };
+	FSWatchState state;
+
+	if(stroscmp(view->watched_dir, view->curr_dir) != 0)
+	{
+		fswatch_free(view->watch);
+		view->watch = fswatch_create(view->curr_dir);
+		copy_str(view->watched_dir, sizeof(view->watched_dir), view->curr_dir);
+		/* Changes made after the list was loaded, but before the watcher was set
+		 * up, can be detected only by regular check. */
+		view->watch_covers_list = 0;
+		return 1;
+	}
+
+	if(view->watch == NULL)
+	{
+		return 1;
+	}
+
+	state = fswatch_poll(view->watch, &apply_fs_event, &changes);
+	trie_free(changes.seen);
+	if(state == FSWS_ERRORED)
+	{
+		/* Some changes were lost, so reload the list and start watching anew. */
+		fswatch_free(view->watch);
+		view->watch = NULL;
+		view->watched_dir[0] = '\0';
+		view->watch_covers_list = 0;
+		ui_view_schedule_reload(view);
+		return 1;
+	}
+
+	if(state == FSWS_UNCHANGED)
+	{
+		return 0;
+	}
+
+	if(changes.reload || view->list_rows == 0)
+	{
+		ui_view_schedule_reload(view);
+		return 1;
+	}
+
+	if(changes.resort)
+	{
+		resort_dir_list(0, view);
+	}
+
+	flist_ensure_pos_is_valid(view);
+	view->column_count = calculate_columns_count(view);
+	fview_list_updated(view);
+	/* Keep regular check from reloading the list once again. */
+	(void)update_dir_mtime(view);
+	ui_view_schedule_redraw(view);
+	return 0;
+}
+
+/* fswatch_poll() callback that applies single change to the list of the
+ * view. */
+static void
+apply_fs_event(FSWatchEvent event, const char name[], void *arg)
+{
+	fs_changes_t *const changes = arg;
+	FileView *const view = changes->view;
+	char path[PATH_MAX];
+	int pos;
+	dir_entry_t was;
+
+	if(changes->reload)
+	{
+		return;
+	}
+
+	if(changes->seen == NULL_TRIE)
+	{
+		changes->seen = trie_create();
+	}
+	/* Entries are queried after the fact, so the first event for a name already
+	 * brings the entry up to date with all modifications that follow it. */
+	if(changes->seen != NULL_TRIE && trie_put(changes->seen, name) > 0 &&
+			event == FSWE_MODIFIED)
+	{
+		return;
+	}
+
+	pos = find_file_pos_in_list(view, name);
+	snprintf(path, sizeof(path), "%s/%s", view->curr_dir, name);
+
+	if(pos < 0)
+	{
+		/* Modification of an entry that's not in the list means that the entry is
+		 * filtered out. */
+		if(event == FSWE_CREATED)
+		{
+			add_created_entry(changes, name, path);
+		}
+		else if(event == FSWE_DELETED && view->filtered > 0)
+		{
+			--view->filtered;
+		}
+		return;
+	}
+
+	if(event == FSWE_DELETED)
+	{
+		remove_entry(view, pos);
+		return;
+	}
+
+	/* The entry might be gone already, events are processed with a delay. */
+	was = view->dir_entry[pos];
+	if(fill_dir_entry_by_path(&view->dir_entry[pos], path) != 0)
+	{
+		remove_entry(view, pos);
+		return;
+	}
+
+	view->dir_entry[pos].hi_num = -1;
+	if(sort_is_affected(view, &was, &view->dir_entry[pos]))
+	{
+		changes->resort = 1;
+	}
+}
+
+/* Adds entry for a new file to the list unless it's filtered out. */
+static void
+add_created_entry(fs_changes_t *changes, const char name[], const char path[])
+{
+	FileView *const view = changes->view;
+	dir_entry_t *entry;
+
+	if(view->hide_dot && name[0] == '.')
+	{
+		++view->filtered;
+		return;
+	}
+
+	if(filters_depend_on_type(view) && !file_is_visible(view, name, is_dir(path)))
+	{
+		++view->filtered;
+		return;
+	}
+
+	/* Placeholder entry of empty directory should disappear, the rules for this
+	 * are in the code that loads the list. */
+	if(view->list_rows == 1 && is_parent_dir(view->dir_entry[0].name) &&
+			!cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)))
+	{
+		changes->reload = 1;
+		return;
+	}
+
+	entry = alloc_dir_entry(&view->dir_entry, view->list_rows);
+	if(entry == NULL)
+	{
+		changes->reload = 1;
+		return;
+	}
+
+	init_dir_entry(view, entry, name);
+	if(fill_dir_entry_by_path(entry, path) != 0)
+	{
+		free_dir_entry(view, entry);
+		return;
+	}
+
+	++view->list_rows;
+	if(insert_new_entries(view, view->list_rows - 1) != 0)
+	{
+		changes->resort = 1;
+	}
+}
+
+/* Removes entry at the pos from the list of the view keeping cursor at the
+ * same entry if possible. */
+static void
+remove_entry(FileView *view, int pos)
+{
+	dir_entry_t *const entry = &view->dir_entry[pos];
+
+	if(entry->selected)
+	{
+		--view->selected_files;
+	}
+	if(entry->search_match)
+	{
+		--view->matches;
+	}
+
+	free_dir_entry(view, entry);
+	memmove(entry, entry + 1, sizeof(*entry)*(view->list_rows - pos - 1));
+	--view->list_rows;
+
+	if(view->list_pos > pos)
+	{
+		--view->list_pos;
+	}
+}
+
+#endif
+
 int
 cd_is_possible(const char *path)
 {
@@ -2510,16 +3744,22 @@ set_view_path(FileView *view, const char path[])
 }
 
 uint64_t
-get_file_size_by_entry(const FileView *view, size_t pos)
+get_file_size_by_entry(const FileView *view, size_t pos, int *exact)
 {
 	uint64_t size = 0;
+	int size_exact = 1;
 	const dir_entry_t *const entry = &view->dir_entry[pos];
 
 	if(is_directory_entry(entry))
 	{
 		char full_path[PATH_MAX];
 		get_full_path_of(entry, sizeof(full_path), full_path);
-		tree_get_data(curr_stats.dirsize_cache, full_path, &size);
+		dirsizes_get(full_path, &size, &size_exact);
+	}
+
+	if(exact != NULL)
+	{
+		*exact = size_exact;
 	}
 
 	return (size == 0) ? entry->size : size;
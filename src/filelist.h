@@ -40,6 +40,10 @@ FileListScope;
  * if entry is to be keeped and zero otherwise. */
 typedef int (*zap_filter)(FileView *view, const dir_entry_t *entry, void *arg);
 
+/* Type of function that checks whether an operation should be stopped.  Should
+ * return non-zero if so and zero otherwise. */
+typedef int (*cancel_check_func)(void *arg);
+
 /* Initialization/termination functions. */
 
 /* Prepares views for the first time. */
@@ -185,6 +189,20 @@ void flist_custom_exclude(FileView *view);
 const char * flist_get_dir(const FileView *view);
 /* Selects entry that corresponds to the path as the current one. */
 void flist_goto_by_path(FileView *view, const char path[]);
+/* Estimates amount of memory occupied by lists of entries of the view
+ * (including list of custom view).  Returns the amount in bytes. */
+uint64_t flist_get_mem_usage(const FileView *view);
+#ifndef _WIN32
+/* Reads list of all files of the directory along with their meta-data except
+ * for modes of targets of symbolic links without involving any view, so it's
+ * safe to call from a background thread.  Reading fails if directory contains
+ * more than max_count files or the cancelled callback returns non-zero.  On
+ * success, *entries (allocated via dynarray_extend()) and *count are set and
+ * entries have NULL origin.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int flist_read_raw(const char dir[], int max_count, cancel_check_func cancelled,
+		void *arg, dir_entry_t **entries, int *count);
+#endif
 /* Loads filelist for the view, but doesn't redraw the view.  The reload
  * parameter should be set in case of view refresh operation. */
 void populate_dir_list(FileView *view, int reload);
@@ -213,8 +231,9 @@ int is_dir_list_loaded(FileView *view);
 int view_needs_cd(const FileView *view, const char path[]);
 /* Sets view's current directory from path value. */
 void set_view_path(FileView *view, const char path[]);
-/* Returns possible cached or calculated value of file size. */
-uint64_t get_file_size_by_entry(const FileView *view, size_t pos);
+/* Returns possible cached or calculated value of file size.  *exact (if exact
+ * isn't NULL) is set to zero if the size is an estimate. */
+uint64_t get_file_size_by_entry(const FileView *view, size_t pos, int *exact);
 /* Checks whether entry corresponds to a directory.  Returns non-zero if so,
  * otherwise zero is returned. */
 int is_directory_entry(const dir_entry_t *entry);
@@ -273,6 +292,9 @@ int add_dir_entry(dir_entry_t **list, size_t *list_size,
 		const dir_entry_t *entry);
 /* Frees single directory entry. */
 void free_dir_entry(const FileView *view, dir_entry_t *entry);
+/* Replaces name of the entry, which belongs to one of lists of the view.
+ * Returns zero on success, otherwise non-zero is returned. */
+int fentry_rename(const FileView *view, dir_entry_t *entry, const char name[]);
 /* Adds parent directory entry (..) to filelist. */
 void add_parent_dir(FileView *view);
 /* Loads list of paths (absolute or relative to the path) into custom view.
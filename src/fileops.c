@@ -21,8 +21,6 @@
 
 #include <regex.h>
 
-#include <pthread.h>
-
 #include <fcntl.h>
 #include <sys/stat.h> /* stat */
 #include <sys/types.h> /* waitpid() */
@@ -35,6 +33,7 @@
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() tolower() */
 #include <errno.h> /* errno */
+#include <inttypes.h> /* PRIu64 */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
 #include <stdio.h> /* snprintf() */
@@ -43,6 +42,7 @@
                        strerror() */
 
 #include "cfg/config.h"
+#include "cfg/dirsizes.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "int/vim.h"
@@ -55,6 +55,9 @@
 #include "ui/fileview.h"
 #include "ui/statusbar.h"
 #include "ui/ui.h"
+#ifndef _WIN32
+#include "utils/dir_size.h"
+#endif
 #ifdef _WIN32
 #include "utils/env.h"
 #endif
@@ -63,7 +66,6 @@
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
-#include "utils/tree.h"
 #include "utils/test_helpers.h"
 #include "utils/utils.h"
 #include "background.h"
@@ -144,6 +146,30 @@ typedef struct
 }
 dir_size_args_t;
 
+#ifndef _WIN32
+
+/* Argument of dir_size_calc() callbacks. */
+typedef struct
+{
+	const char *path; /* Path to the directory being processed. */
+	bg_op_t *bg_op;   /* Background operation to report progress to or NULL. */
+}
+dir_size_client_arg_t;
+
+#else
+
+/* State of calc_dir_size() while it processes a directory. */
+typedef struct
+{
+	const char *path;  /* Path to the directory. */
+	const char *slash; /* Separator to put after the path. */
+	int force_update;  /* Whether cached values should be ignored. */
+	uint64_t size;     /* Size accumulated so far. */
+}
+dir_size_state_t;
+
+#endif
+
 static void io_progress_changed(const io_progress_t *const state);
 static int calc_io_progress(const io_progress_t *const state, int *skip);
 static void io_progress_fg(const io_progress_t *const state, int progress);
@@ -234,8 +260,18 @@ static int check_if_dir_writable(DirRole dir_role, const char path[]);
 static void update_dir_entry_size(const FileView *view, int index, int force);
 static void start_dir_size_calc(const char path[], int force);
 static void dir_size_bg(bg_op_t *bg_op, void *arg);
-static void dir_size(char path[], int force);
-static void set_dir_size(const char path[], uint64_t size);
+static void dir_size(char path[], int force, bg_op_t *bg_op);
+static uint64_t calc_dir_size(const char path[], int force, bg_op_t *bg_op);
+#ifndef _WIN32
+static int lookup_dir_size(const char path[], uint64_t *size, void *arg);
+static void store_dir_sizes(const dir_size_result_t results[], int count,
+		void *arg);
+static void report_dir_size_progress(uint64_t ndirs, uint64_t size,
+		void *arg);
+#else
+static int add_entries_size(const dir_batch_entry_t entries[], int count,
+		void *param);
+#endif
 static void redraw_after_path_change(FileView *view, const char path[]);
 
 /* Temporary storage for extension of file being renamed in name-only mode. */
@@ -890,9 +926,8 @@ rename_file_cb(const char new_name[])
 	}
 
 	/* Rename file in internal structures for correct positioning of cursor after
-	 * reloading, as cursor will be positioned on the file with the same name.
-	 * TODO: maybe create a function in ui or filelist to do this. */
-	(void)replace_string(&entry->name, new);
+	 * reloading, as cursor will be positioned on the file with the same name. */
+	(void)fentry_rename(curr_view, entry, new);
 
 	ui_view_schedule_reload(curr_view);
 }
@@ -1079,7 +1114,7 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 				 * positioning of cursor after reloading, as cursor will be positioned
 				 * on the file with the same name.  For custom views rename to prevent
 				 * files from disappearing. */
-				(void)replace_string(&entry->name, new_name);
+				(void)fentry_rename(view, entry, new_name);
 
 				if(flist_custom_active(view))
 				{
@@ -1087,7 +1122,7 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 							view->custom.entry_count, path);
 					if(entry != NULL)
 					{
-						(void)replace_string(&entry->name, new_name);
+						(void)fentry_rename(view, entry, new_name);
 					}
 				}
 			}
@@ -2972,7 +3007,7 @@ fixup_entry_after_rename(FileView *view, dir_entry_t *entry,
 		/* Rename file in internal structures for correct positioning of cursor
 		 * after reloading, as cursor will be positioned on the file with the same
 		 * name. */
-		(void)replace_string(&entry->name, new_fname);
+		(void)fentry_rename(view, entry, new_fname);
 	}
 }
 
@@ -4094,7 +4129,7 @@ dir_size_bg(bg_op_t *bg_op, void *arg)
 {
 	dir_size_args_t *const args = arg;
 
-	dir_size(args->path, args->force);
+	dir_size(args->path, args->force, bg_op);
 
 	free(args->path);
 	free(args);
@@ -4103,9 +4138,9 @@ dir_size_bg(bg_op_t *bg_op, void *arg)
 /* Calculates directory size and triggers view updates if necessary.  Changes
  * path. */
 static void
-dir_size(char path[], int force)
+dir_size(char path[], int force, bg_op_t *bg_op)
 {
-	(void)calculate_dir_size(path, force);
+	(void)calc_dir_size(path, force, bg_op);
 
 	remove_last_path_component(path);
 
@@ -4113,68 +4148,127 @@ dir_size(char path[], int force)
 	redraw_after_path_change(&rwin, path);
 }
 
-/* Calculates size of a directory possibly using cache of known sizes.  Returns
- * size of a directory or zero on error. */
 uint64_t
 calculate_dir_size(const char path[], int force_update)
 {
-	DIR* dir;
-	struct dirent* dentry;
-	const char* slash = "";
+	return calc_dir_size(path, force_update, NULL);
+}
+
+#ifndef _WIN32
+
+/* Calculates size of a directory possibly using cache of known sizes and
+ * reporting progress to bg_op, which can be NULL.  Returns size of a directory
+ * or zero on error. */
+static uint64_t
+calc_dir_size(const char path[], int force, bg_op_t *bg_op)
+{
+	dir_size_client_arg_t arg = { .path = path, .bg_op = bg_op };
+	const dir_size_client_t client = {
+		.lookup = force ? NULL : &lookup_dir_size,
+		.store = &store_dir_sizes,
+		.progress = (bg_op == NULL) ? NULL : &report_dir_size_progress,
+		.arg = &arg,
+		.disk_usage = cfg.disk_usage,
+	};
 	uint64_t size;
 
-	dir = os_opendir(path);
-	if(dir == NULL)
+	return (dir_size_calc(path, &client, &size) == 0) ? size : 0U;
+}
+
+/* dir_size_calc() callback that queries cache of directory sizes.  Estimates
+ * are recalculated.  Returns zero if size is known, otherwise non-zero is
+ * returned. */
+static int
+lookup_dir_size(const char path[], uint64_t *size, void *arg)
+{
+	int exact;
+	return dirsizes_get(path, size, &exact) != 0 || !exact;
+}
+
+/* dir_size_calc() callback that puts batch of calculated sizes into the
+ * cache. */
+static void
+store_dir_sizes(const dir_size_result_t results[], int count, void *arg)
+{
+	int i;
+	for(i = 0; i < count; ++i)
 	{
-		return 0;
+		dirsizes_set(results[i].path, results[i].size, results[i].exact,
+				&results[i].stamp);
 	}
+}
+
+/* dir_size_calc() callback that displays progress of calculation in
+ * description of background operation. */
+static void
+report_dir_size_progress(uint64_t ndirs, uint64_t size, void *arg)
+{
+	const dir_size_client_arg_t *const client_arg = arg;
+	char size_str[64];
+	char descr[PATH_MAX + 128];
+
+	friendly_size_notation(size, sizeof(size_str), size_str);
+	snprintf(descr, sizeof(descr), "%s (%s in %" PRIu64 " dirs)",
+			client_arg->path, size_str, ndirs);
+	bg_op_set_descr(client_arg->bg_op, descr);
+}
 
-	if(!ends_with_slash(path))
+#else
+
+/* Calculates size of a directory possibly using cache of known sizes.  Returns
+ * size of a directory or zero on error. */
+static uint64_t
+calc_dir_size(const char path[], int force, bg_op_t *bg_op)
+{
+	dir_size_state_t state = {
+		.path = path,
+		.slash = ends_with_slash(path) ? "" : "/",
+		.force_update = force,
+		.size = 0U,
+	};
+
+	if(enum_dir_batches(path, 0U, &add_entries_size, &state) != 0)
 	{
-		slash = "/";
+		return 0;
 	}
 
-	size = 0;
-	while((dentry = os_readdir(dir)) != NULL)
+	dirsizes_set(path, state.size, 1, NULL);
+	return state.size;
+}
+
+/* enum_dir_batches() callback that accumulates sizes of directory entries.
+ * Returns zero. */
+static int
+add_entries_size(const dir_batch_entry_t entries[], int count, void *param)
+{
+	dir_size_state_t *const state = param;
+	int i;
+
+	for(i = 0; i < count; ++i)
 	{
 		char buf[PATH_MAX];
 
-		if(is_builtin_dir(dentry->d_name))
-		{
-			continue;
-		}
-
-		snprintf(buf, sizeof(buf), "%s%s%s", path, slash, dentry->d_name);
-		if(is_dir_entry(buf, dentry))
+		snprintf(buf, sizeof(buf), "%s%s%s", state->path, state->slash,
+				entries[i].name);
+		if(batch_entry_is_dir(buf, &entries[i]))
 		{
 			uint64_t dir_size = 0;
-			if(tree_get_data(curr_stats.dirsize_cache, buf, &dir_size) != 0
-					|| force_update)
-				dir_size = calculate_dir_size(buf, force_update);
-			size += dir_size;
+			int exact;
+			if(dirsizes_get(buf, &dir_size, &exact) != 0 || !exact ||
+					state->force_update)
+				dir_size = calc_dir_size(buf, state->force_update, NULL);
+			state->size += dir_size;
 		}
 		else
 		{
-			size += get_file_size(buf);
+			state->size += get_file_size(buf);
 		}
 	}
 
-	os_closedir(dir);
-
-	set_dir_size(path, size);
-	return size;
+	return 0;
 }
 
-/* Updates cached directory size in a thread-safe way. */
-static void
-set_dir_size(const char path[], uint64_t size)
-{
-	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-
-	pthread_mutex_lock(&mutex);
-	tree_set_data(curr_stats.dirsize_cache, path, size);
-	pthread_mutex_unlock(&mutex);
-}
+#endif
 
 /* Schedules view redraw in case path change might have affected it. */
 static void
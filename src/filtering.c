@@ -258,6 +258,14 @@ file_is_visible(FileView *view, const char filename[], int is_dir)
 	}
 }
 
+int
+filters_depend_on_type(const FileView *view)
+{
+	return !filter_is_empty(&view->auto_filter)
+	    || !filter_is_empty(&view->local_filter.filter)
+	    || !filter_is_empty(&view->manual_filter);
+}
+
 void
 filters_dir_updated(FileView *view)
 {
@@ -61,6 +61,12 @@ void toggle_filter_inversion(FileView *view);
  * zero is returned, in which case the file should be hidden. */
 int file_is_visible(FileView *view, const char filename[], int is_dir);
 
+/* Checks whether result of file_is_visible() might depend on value of its
+ * is_dir parameter (i.e. when at least one of filters is set).  Returns zero
+ * when file_is_visible() is known to return non-zero for any file, otherwise
+ * non-zero is returned. */
+int filters_depend_on_type(const FileView *view);
+
 /* Callback-like function which triggers some view-specific updates after
  * directory of the view changes. */
 void filters_dir_updated(FileView *view);
@@ -0,0 +1,469 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "flist_cache.h"
+
+#include <sys/stat.h> /* S_ISDIR() */
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memcmp() memcpy() memmove() strchr() strcmp() strdup()
+                       strlen() */
+
+#include "cfg/config.h"
+#include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
+#include "ui/ui.h"
+#include "utils/dynarray.h"
+#include "utils/filemon.h"
+#include "utils/path.h"
+#include "utils/str.h"
+#include "utils/string_array.h"
+#include "filelist.h"
+
+/* Single cached file list. */
+typedef struct
+{
+	char *path;           /* Directory of the list. */
+	filemon_t mon;        /* State of the directory when the list was read. */
+	dir_entry_t *entries; /* The list itself. */
+	int count;            /* Number of entries in the list. */
+	int filtered;         /* Number of files that were filtered out. */
+	uint64_t size;        /* Memory occupied by the list. */
+	int raw;              /* Whether list isn't filtered and sorted. */
+
+	/* State of the view that affects contents and order of the list. */
+	char *filters;        /* Patterns of all filters of the view. */
+	char sort[SK_COUNT];  /* Sorting keys. */
+	int hide_dot;         /* Whether dot files were hidden. */
+	int invert;           /* Whether name filter was inverted. */
+	int sort_numbers;     /* Value of 'sortnumbers' option. */
+	int dot_dirs;         /* Value of 'dotdirs' option. */
+}
+cached_list_t;
+
+static void add_list(cached_list_t *list, uint64_t limit);
+static uint64_t get_list_size(const dir_entry_t entries[], int count);
+static int fill_view_state(cached_list_t *list, const FileView *view);
+static int state_matches(const cached_list_t *list, const FileView *view);
+static uint64_t get_limit(void);
+static void trim(uint64_t limit);
+static void drop_list(size_t idx);
+static void free_list(cached_list_t *list);
+static int is_affected(const char list_path[], const char path[]);
+static cached_list_t * find_list(const char path[]);
+
+/* Cached lists ordered from the least recently used to the most recently used
+ * one. */
+static cached_list_t *lists;
+/* Number of elements in the lists array. */
+static size_t nlists;
+/* Total memory occupied by lists. */
+static uint64_t used;
+/* Protects the cache from concurrent access. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+void
+flist_cache_put(const FileView *view, const filemon_t *mon)
+{
+	cached_list_t list = { .count = 0 };
+	uint64_t limit;
+
+	limit = get_limit();
+	if(limit == 0U || flist_custom_active(view) || view->list_rows == 0)
+	{
+		return;
+	}
+
+	list.size = get_list_size(view->dir_entry, view->list_rows);
+	if(list.size > limit)
+	{
+		return;
+	}
+
+	list.path = strdup(view->curr_dir);
+	list.entries = dynarray_extend(NULL, sizeof(*list.entries)*view->list_rows);
+	if(list.path == NULL || list.entries == NULL || fill_view_state(&list, view))
+	{
+		free_list(&list);
+		return;
+	}
+
+	filemon_assign(&list.mon, mon);
+	list.filtered = view->filtered;
+
+	for(; list.count < view->list_rows; ++list.count)
+	{
+		dir_entry_t *const entry = &list.entries[list.count];
+		*entry = view->dir_entry[list.count];
+
+		entry->name = strdup(entry->name);
+		if(entry->name == NULL)
+		{
+			free_list(&list);
+			return;
+		}
+
+		/* Origin points into the view, it's restored on taking the list back. */
+		entry->origin = NULL;
+
+		/* Transient state of entries is lost on reading directory anew. */
+		entry->selected = 0;
+		entry->was_selected = 0;
+		entry->search_match = 0;
+		entry->marked = 0;
+		entry->hi_num = -1;
+	}
+
+	add_list(&list, limit);
+}
+
+void
+flist_cache_put_raw(const char path[], const filemon_t *mon,
+		dir_entry_t *entries, int count)
+{
+	cached_list_t list = { .entries = entries, .count = count, .raw = 1 };
+	const uint64_t limit = get_limit();
+
+	list.size = get_list_size(entries, count);
+	list.path = strdup(path);
+	list.filters = strdup("");
+	if(list.size > limit || list.path == NULL || list.filters == NULL)
+	{
+		free_list(&list);
+		return;
+	}
+
+	filemon_assign(&list.mon, mon);
+	add_list(&list, limit);
+}
+
+int
+flist_cache_take(const FileView *view, const filemon_t *mon,
+		dir_entry_t **entries, int *count, int *filtered, int *raw)
+{
+	size_t i;
+
+	pthread_mutex_lock(&lock);
+
+	for(i = 0U; i < nlists; ++i)
+	{
+		cached_list_t *const list = &lists[i];
+		if(stroscmp(list->path, view->curr_dir) != 0)
+		{
+			continue;
+		}
+
+		if(!filemon_equal(&list->mon, mon) ||
+				(!list->raw && !state_matches(list, view)))
+		{
+			/* The list is outdated and there can't be another one for the path. */
+			drop_list(i);
+			break;
+		}
+
+		*entries = list->entries;
+		*count = list->count;
+		*filtered = list->filtered;
+		*raw = list->raw;
+
+		/* Ownership of entries is transferred to the caller. */
+		list->entries = NULL;
+		list->count = 0;
+		drop_list(i);
+
+		pthread_mutex_unlock(&lock);
+		return 0;
+	}
+
+	pthread_mutex_unlock(&lock);
+	return 1;
+}
+
+int
+flist_cache_contains(const char path[])
+{
+	int contains;
+
+	pthread_mutex_lock(&lock);
+	contains = (find_list(path) != NULL);
+	pthread_mutex_unlock(&lock);
+
+	return contains;
+}
+
+int
+flist_cache_get_names(const char path[], const filemon_t *mon,
+		char ***names)
+{
+	const cached_list_t *list;
+	int i;
+	int count = -1;
+
+	*names = NULL;
+
+	pthread_mutex_lock(&lock);
+
+	list = find_list(path);
+	if(list != NULL && filemon_equal(&list->mon, mon))
+	{
+		count = 0;
+		for(i = 0; i < list->count; ++i)
+		{
+			const dir_entry_t *const entry = &list->entries[i];
+			const int dir = (entry->type == FT_DIR)
+			             || (entry->type == FT_LINK && S_ISDIR(entry->mode));
+			if(is_parent_dir(entry->name))
+			{
+				continue;
+			}
+
+			count = put_into_string_array(names, count,
+					format_str("%s%s", entry->name, dir ? "/" : ""));
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	return count;
+}
+
+void
+flist_cache_invalidate(const char path[])
+{
+	char canonic[PATH_MAX];
+	size_t i;
+
+	if(to_canonic_path(path, canonic, sizeof(canonic)) != 0)
+	{
+		/* Can't tell what's affected, so assume that everything is. */
+		canonic[0] = '\0';
+	}
+
+	pthread_mutex_lock(&lock);
+
+	i = 0U;
+	while(i < nlists)
+	{
+		if(is_affected(lists[i].path, canonic))
+		{
+			drop_list(i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+flist_cache_trim(void)
+{
+	pthread_mutex_lock(&lock);
+	trim(get_limit());
+	pthread_mutex_unlock(&lock);
+}
+
+uint64_t
+flist_cache_get_mem_usage(void)
+{
+	uint64_t result;
+
+	pthread_mutex_lock(&lock);
+	result = used;
+	pthread_mutex_unlock(&lock);
+
+	return result;
+}
+
+/* Appends the list to the cache, replacing list of the same directory and
+ * evicting other lists to fit into the limit.  Takes ownership of the list. */
+static void
+add_list(cached_list_t *list, uint64_t limit)
+{
+	cached_list_t *new_lists;
+	cached_list_t *old;
+
+	pthread_mutex_lock(&lock);
+
+	/* There can be at most one outdated list for the same path. */
+	old = find_list(list->path);
+	if(old != NULL)
+	{
+		drop_list(old - lists);
+	}
+
+	trim(limit - list->size);
+
+	new_lists = reallocarray(lists, nlists + 1U, sizeof(*lists));
+	if(new_lists == NULL)
+	{
+		pthread_mutex_unlock(&lock);
+		free_list(list);
+		return;
+	}
+
+	lists = new_lists;
+	lists[nlists++] = *list;
+	used += list->size;
+
+	pthread_mutex_unlock(&lock);
+}
+
+/* Estimates amount of memory occupied by list of entries.  Returns the amount
+ * in bytes. */
+static uint64_t
+get_list_size(const dir_entry_t entries[], int count)
+{
+	int i;
+	uint64_t size = sizeof(*entries)*count;
+	for(i = 0; i < count; ++i)
+	{
+		size += strlen(entries[i].name) + 1U;
+	}
+	return size;
+}
+
+/* Remembers state of the view that affects list of files in the list.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+fill_view_state(cached_list_t *list, const FileView *view)
+{
+	list->filters = format_str("%s\n%s\n%s", view->manual_filter.raw,
+			view->auto_filter.raw, view->local_filter.filter.raw);
+	memcpy(list->sort, view->sort, sizeof(list->sort));
+	list->hide_dot = view->hide_dot;
+	list->invert = view->invert;
+	list->sort_numbers = cfg.sort_numbers;
+	list->dot_dirs = cfg.dot_dirs;
+	return list->filters == NULL;
+}
+
+/* Checks whether the list would look the same if it was loaded for current
+ * state of the view.  Returns non-zero if so, otherwise zero is returned. */
+static int
+state_matches(const cached_list_t *list, const FileView *view)
+{
+	cached_list_t current = { .count = 0 };
+	int matches;
+
+	if(fill_view_state(&current, view) != 0)
+	{
+		free(current.filters);
+		return 0;
+	}
+
+	matches = strcmp(current.filters, list->filters) == 0
+	       && memcmp(current.sort, list->sort, sizeof(list->sort)) == 0
+	       && current.hide_dot == list->hide_dot
+	       && current.invert == list->invert
+	       && current.sort_numbers == list->sort_numbers
+	       && current.dot_dirs == list->dot_dirs;
+
+	free(current.filters);
+	return matches;
+}
+
+/* Retrieves size limit of the cache.  Returns the limit in bytes. */
+static uint64_t
+get_limit(void)
+{
+	return (cfg.list_cache_size > 0) ? (uint64_t)cfg.list_cache_size*1024U : 0U;
+}
+
+/* Evicts least recently used lists until memory used by the cache doesn't
+ * exceed the limit.  Should be called with the lock held. */
+static void
+trim(uint64_t limit)
+{
+	while(nlists != 0U && used > limit)
+	{
+		drop_list(0U);
+	}
+}
+
+/* Removes list at specified position from the cache.  Should be called with the
+ * lock held. */
+static void
+drop_list(size_t idx)
+{
+	used -= lists[idx].size;
+	free_list(&lists[idx]);
+	memmove(&lists[idx], &lists[idx + 1U], sizeof(*lists)*(nlists - idx - 1U));
+	--nlists;
+}
+
+/* Frees resources of the list. */
+static void
+free_list(cached_list_t *list)
+{
+	int i;
+	for(i = 0; i < list->count; ++i)
+	{
+		free(list->entries[i].name);
+	}
+	dynarray_free(list->entries);
+	free(list->filters);
+	free(list->path);
+}
+
+/* Looks up list of the directory at the path.  Should be called with the lock
+ * held.  Returns the list or NULL if there is none. */
+static cached_list_t *
+find_list(const char path[])
+{
+	size_t i;
+	for(i = 0U; i < nlists; ++i)
+	{
+		if(stroscmp(lists[i].path, path) == 0)
+		{
+			return &lists[i];
+		}
+	}
+	return NULL;
+}
+
+/* Checks whether list of the list_path directory might be affected by change
+ * of the path.  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_affected(const char list_path[], const char path[])
+{
+	const char *rest;
+
+	if(path_starts_with(list_path, path))
+	{
+		return 1;
+	}
+
+	if(!path_starts_with(path, list_path))
+	{
+		return 0;
+	}
+
+	/* Is list_path a parent of the path? */
+	rest = path + strlen(list_path);
+	rest += (rest[0] == '/');
+	return strchr(rest, '/') == NULL;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
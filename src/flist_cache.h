@@ -0,0 +1,83 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__FLIST_CACHE_H__
+#define VIFM__FLIST_CACHE_H__
+
+#include <stdint.h> /* uint64_t */
+
+#include "ui/ui.h"
+#include "utils/filemon.h"
+
+/* Cache of file lists of recently visited directories.  Lists are stored along
+ * with directory monitor and state of the view they were loaded for, so that
+ * list is never restored for a directory that was changed since then or if
+ * it was filtered or sorted differently.  Raw lists, which contain all files of
+ * a directory and aren't sorted, don't depend on state of a view and are used
+ * for prefetched directories.  Least recently used lists are evicted to keep
+ * memory used by the cache under the limit set by 'listcache' option.  All
+ * functions are thread-safe. */
+
+/* Puts copy of file list of the view into the cache.  The mon parameter
+ * describes state of the directory at the moment the list was read.  Does
+ * nothing for custom views, when list doesn't fit into the cache or caching is
+ * disabled. */
+void flist_cache_put(const FileView *view, const filemon_t *mon);
+
+/* Puts raw list of files of the directory at the path into the cache taking
+ * ownership of the entries (allocated via dynarray_extend()).  The mon
+ * parameter describes state of the directory before the list was read. */
+void flist_cache_put_raw(const char path[], const filemon_t *mon,
+		dir_entry_t *entries, int count);
+
+/* Removes list of current directory of the view from the cache if it's
+ * still valid for the mon state of the directory and current state of the
+ * view.  On success, *entries and *count are set to the list (allocated via
+ * dynarray_extend()), which should be freed by the caller and whose entries
+ * have NULL origin, *filtered is set to number of files that were filtered out
+ * and *raw is set to whether the list is raw and needs to be filtered and
+ * sorted.  Returns zero on success, otherwise non-zero is returned. */
+int flist_cache_take(const FileView *view, const filemon_t *mon,
+		dir_entry_t **entries, int *count, int *filtered, int *raw);
+
+/* Checks whether there is a list for the path in the cache.  Returns non-zero
+ * if so, otherwise zero is returned. */
+int flist_cache_contains(const char path[]);
+
+/* Retrieves names of files of the directory at the path from its cached list
+ * if it's valid for the mon state of the directory.  Names of directories end
+ * with a slash.  *names is set to an array that should be freed by the caller.
+ * Returns number of names or -1 if there is no suitable list. */
+int flist_cache_get_names(const char path[], const filemon_t *mon,
+		char ***names);
+
+/* Drops cached lists that might be affected by changes of the path: list of
+ * its parent directory and lists of the path and all directories under it. */
+void flist_cache_invalidate(const char path[]);
+
+/* Evicts least recently used lists until the cache fits into its size
+ * limit. */
+void flist_cache_trim(void);
+
+/* Queries amount of memory used by the cache.  Returns the amount in bytes. */
+uint64_t flist_cache_get_mem_usage(void);
+
+#endif /* VIFM__FLIST_CACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,247 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "flist_prefetch.h"
+
+#include <sys/stat.h> /* S_ISDIR() */
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_create()
+                        pthread_detach() pthread_mutex_* pthread_t */
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+
+#include "cfg/config.h"
+#include "compat/fs_limits.h"
+#include "ui/ui.h"
+#include "utils/filemon.h"
+#include "utils/fs.h"
+#include "utils/path.h"
+#include "utils/str.h"
+#include "utils/utils.h"
+#include "filelist.h"
+#include "flist_cache.h"
+#include "status.h"
+
+/* Directories with more files than this aren't prefetched. */
+#define MAX_PREFETCH_FILES 10000
+
+/* Maximum number of prefetching tasks that can exist at the same time
+ * (including those that were cancelled, but didn't finish yet). */
+#define MAX_PREFETCH_TASKS 2
+
+#ifndef _WIN32
+
+static int should_prefetch(const dir_entry_t *entry, const char path[]);
+static void * prefetch_thread(void *arg);
+static int is_cancelled(void *arg);
+
+/* Path to directory that is being prefetched or NULL.  Tasks for other
+ * directories are cancelled. */
+static char *wanted;
+/* Number of running prefetching tasks. */
+static int running;
+/* Protects wanted and running, which are accessed by background tasks. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Path to directory that was last considered for prefetching or NULL.  Used to
+ * avoid checking the same directory over and over again. */
+static char *last_request;
+
+#endif
+
+void
+flist_prefetch(FileView *view)
+{
+#ifndef _WIN32
+	char path[PATH_MAX];
+	const dir_entry_t *const entry = get_current_entry(view);
+	char *task_path;
+	pthread_t id;
+
+	if(!cfg.prefetch_dirs || cfg.list_cache_size <= 0 || entry == NULL ||
+			is_parent_dir(entry->name))
+	{
+		flist_prefetch_cancel();
+		return;
+	}
+
+	get_full_path_of(entry, sizeof(path), path);
+	if(last_request != NULL && stroscmp(last_request, path) == 0)
+	{
+		return;
+	}
+
+	if(!should_prefetch(entry, path))
+	{
+		flist_prefetch_cancel();
+		(void)update_string(&last_request, path);
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	if(running >= MAX_PREFETCH_TASKS)
+	{
+		/* Try again later, when cancelled tasks are finished. */
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+	/* This also cancels prefetching of previously requested directory. */
+	if(update_string(&wanted, path) != 0)
+	{
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+	++running;
+	pthread_mutex_unlock(&lock);
+
+	/* This is an implementation detail rather than an operation requested by
+	 * the user, so it's not registered as a background job. */
+	task_path = strdup(path);
+	if(task_path == NULL ||
+			pthread_create(&id, NULL, &prefetch_thread, task_path) != 0)
+	{
+		free(task_path);
+
+		pthread_mutex_lock(&lock);
+		(void)update_string(&wanted, NULL);
+		--running;
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+	(void)pthread_detach(id);
+
+	(void)update_string(&last_request, path);
+#endif
+}
+
+void
+flist_prefetch_cancel(void)
+{
+#ifndef _WIN32
+	pthread_mutex_lock(&lock);
+	(void)update_string(&wanted, NULL);
+	pthread_mutex_unlock(&lock);
+
+	(void)update_string(&last_request, NULL);
+#endif
+}
+
+int
+flist_prefetch_in_progress(void)
+{
+#ifndef _WIN32
+	int result;
+
+	pthread_mutex_lock(&lock);
+	result = (running != 0);
+	pthread_mutex_unlock(&lock);
+
+	return result;
+#else
+	return 0;
+#endif
+}
+
+#ifndef _WIN32
+
+/* Checks whether directory of the entry at the path is worth prefetching.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+should_prefetch(const dir_entry_t *entry, const char path[])
+{
+	if(entry->type == FT_LINK)
+	{
+		char target[PATH_MAX];
+
+		if(!S_ISDIR(entry->mode))
+		{
+			return 0;
+		}
+
+		if(get_link_target_abs(path, entry->origin, target, sizeof(target)) != 0 ||
+				refers_to_slower_fs(path, target))
+		{
+			return 0;
+		}
+	}
+	else if(entry->type != FT_DIR)
+	{
+		return 0;
+	}
+
+	return !flist_cache_contains(path) && !is_on_slow_fs(path);
+}
+
+/* Entry point of a thread that reads list of a directory into the cache.
+ * Returns NULL. */
+static void *
+prefetch_thread(void *arg)
+{
+	char *const path = arg;
+	filemon_t mon;
+	dir_entry_t *entries;
+	int count;
+
+	/* State of the directory is queried before reading it, so that changes made
+	 * in the process would render the list outdated. */
+	if(filemon_from_file(path, &mon) == 0 &&
+			flist_read_raw(path, MAX_PREFETCH_FILES, &is_cancelled, path, &entries,
+				&count) == 0)
+	{
+		flist_cache_put_raw(path, &mon, entries, count);
+
+		if(curr_stats.view)
+		{
+			/* Let quick view display the list. */
+			ui_view_schedule_redraw(&lwin);
+			ui_view_schedule_redraw(&rwin);
+		}
+	}
+
+	pthread_mutex_lock(&lock);
+	if(wanted != NULL && stroscmp(wanted, path) == 0)
+	{
+		(void)update_string(&wanted, NULL);
+	}
+	--running;
+	pthread_mutex_unlock(&lock);
+
+	free(path);
+	return NULL;
+}
+
+/* Checks whether prefetching of the directory specified by arg was cancelled.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_cancelled(void *arg)
+{
+	const char *const path = arg;
+	int cancelled;
+
+	pthread_mutex_lock(&lock);
+	cancelled = (wanted == NULL || stroscmp(wanted, path) != 0);
+	pthread_mutex_unlock(&lock);
+
+	return cancelled;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,44 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__FLIST_PREFETCH_H__
+#define VIFM__FLIST_PREFETCH_H__
+
+#include "ui/ui.h"
+
+/* Background reading of directories that are likely to be visited next.  Lists
+ * are read into cache of file lists, from where they are picked up on entering
+ * a directory or to preview it.  Reading happens only when 'prefetch' option is
+ * set. */
+
+/* Starts reading list of directory under cursor of the view in background if
+ * it's not in the cache yet.  Prefetching of any other directory is
+ * cancelled. */
+void flist_prefetch(FileView *view);
+
+/* Cancels prefetching that's in progress, if any. */
+void flist_prefetch_cancel(void);
+
+/* Checks whether any of prefetching tasks (including cancelled ones) is still
+ * running.  Returns non-zero if so, otherwise zero is returned. */
+int flist_prefetch_in_progress(void);
+
+#endif /* VIFM__FLIST_PREFETCH_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
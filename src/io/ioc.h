@@ -95,6 +95,10 @@ struct io_args_t
 	 * outside. */
 	int cancellable;
 
+	/* Maximum number of files that recursive copying writes to the same device
+	 * at the same time.  Values less than two disable parallel copying. */
+	int max_jobs;
+
 	/* File overwrite confirmation callback.  Set to NULL to silently
 	 * overwrite. */
 	io_confirm confirm;
@@ -24,16 +24,25 @@
 
 #include "iop.h"
 
+#ifdef __linux__
+#include <sys/ioctl.h> /* _IOW ioctl() */
+#include <sys/sendfile.h> /* sendfile() */
+#include <sys/syscall.h> /* SYS_copy_file_range */
+#endif
 #include <sys/stat.h> /* stat */
-#include <sys/types.h> /* mode_t */
-#include <unistd.h> /* rmdir() symlink() unlink() */
+#include <sys/types.h> /* mode_t off_t */
+#include <fcntl.h> /* POSIX_FADV_* posix_fadvise() */
+#include <pthread.h> /* PTHREAD_* pthread_* */
+#include <unistd.h> /* ftruncate() lseek() read() rmdir() symlink() syscall()
+                       unlink() write() */
 
-#include <errno.h> /* EEXIST ENOENT EISDIR errno */
+#include <errno.h> /* EEXIST EINTR ENOENT ENOMEM ENOSYS ENXIO EISDIR errno */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE fpos_t fclose() fgetpos() fread() fseek() fsetpos()
-                      fwrite() snprintf() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strchr() strerror() */
+#include <stdint.h> /* UINT64_MAX uint64_t */
+#include <stdio.h> /* FILE fpos_t fclose() fflush() fgetpos() fileno() fread()
+                      fseek() fseeko() fsetpos() ftello() fwrite() snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcmp() strchr() strerror() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
@@ -50,8 +59,101 @@
 #include "private/ioeta.h"
 #include "ioc.h"
 
-/* Amount of data to transfer at once. */
-#define BLOCK_SIZE 32*1024
+/* Amount of data to transfer at once when copying in user space. */
+#define BLOCK_SIZE (1024*1024)
+
+#ifdef __linux__
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+/* Headers might hide these depending on feature macros. */
+#ifndef SEEK_DATA
+#define SEEK_DATA 3
+#endif
+#ifndef SEEK_HOLE
+#define SEEK_HOLE 4
+#endif
+
+/* Amount of data to transfer at once when copying in the kernel.  Progress and
+ * cancellation are processed after each chunk. */
+#define KERNEL_CHUNK_SIZE (8*1024*1024)
+
+#endif
+
+#ifndef _WIN32
+
+/* Granularity of detecting blocks of zeroes that are turned into holes when
+ * copying sparse files. */
+#define ZERO_BLOCK_SIZE 4096
+
+/* Number of buffers that are filled by reader and emptied by writer during
+ * pipelined copying. */
+#define RING_NBUFFERS 4
+
+/* Size of each of the buffers of pipelined copying. */
+#define RING_BUFFER_SIZE (4*1024*1024)
+
+/* Files smaller than this are not worth starting a thread for them. */
+#define PIPELINE_MIN_FILE_SIZE (2*RING_BUFFER_SIZE)
+
+/* Result of copying file contents via file descriptors. */
+typedef enum
+{
+	CR_DONE,      /* Whole file was copied. */
+	CR_FALLBACK,  /* Nothing was copied, copying should be done via streams. */
+	CR_CANCELLED, /* Copying was cancelled by the user. */
+	CR_FAILED,    /* Copying failed midway, error is recorded. */
+}
+CopyResult;
+
+/* State shared by reader and writer of pipelined copying.  The buffers form a
+ * ring, reader fills them after the last filled one and writer empties them
+ * starting from the first one. */
+typedef struct
+{
+	int in;                      /* Source file descriptor. */
+	uint64_t len;                /* Number of bytes left to read. */
+	char *bufs[RING_NBUFFERS];   /* The buffers. */
+	size_t sizes[RING_NBUFFERS]; /* Amount of data in each buffer. */
+	pthread_mutex_t lock;        /* Protects fields below. */
+	pthread_cond_t changed;      /* Signaled on any change of fields below. */
+
+	int first;                   /* Index of the first filled buffer. */
+	int nfilled;                 /* Number of filled buffers. */
+	int eof;                     /* Reader has finished. */
+	int error;                   /* errno of failed read or zero. */
+	int stop;                    /* Reader should quit. */
+}
+ring_t;
+
+static int is_sparse(const struct stat *st);
+static CopyResult copy_contents(io_args_t *args, int in, int out,
+		int whole_file, int sparse, uint64_t size);
+static CopyResult copy_data_regions(io_args_t *args, int in, int out,
+		uint64_t size);
+static CopyResult copy_range(io_args_t *args, int in, int out, uint64_t len);
+static CopyResult read_write_chunks(io_args_t *args, int in, int out,
+		uint64_t len);
+static int write_sparse(FILE *out, const char block[], size_t len,
+		size_t *skipped);
+static int is_all_zeroes(const char block[], size_t len);
+static CopyResult pipelined_copy(io_args_t *args, int in, int out,
+		uint64_t len);
+static int ring_init(ring_t *ring);
+static void ring_free(ring_t *ring);
+static void * ring_reader(void *arg);
+static ssize_t read_fully(int fd, char buf[], size_t len);
+static void advise(int fd, off_t offset, off_t len, int drop);
+#ifdef __linux__
+static CopyResult kernel_copy_chunks(io_args_t *args, int in, int out,
+		IoCpMethod method, uint64_t len);
+static ssize_t kernel_copy_chunk(int in, int out, IoCpMethod method,
+		size_t len);
+#endif
+
+#endif
 
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
@@ -60,6 +162,8 @@ static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		HANDLE src_file, HANDLE dst_file, LPVOID param);
 #endif
 
+int iop_cp_methods = IO_CP_DEFAULT;
+
 int
 iop_mkfile(io_args_t *const args)
 {
@@ -237,10 +341,12 @@ iop_cp(io_args_t *const args)
 	const int cancellable = args->cancellable;
 	struct stat st;
 
-	char block[BLOCK_SIZE];
+	char *block;
 	FILE *in, *out;
 	size_t nread;
 	int error;
+	int in_user_space;
+	int skip_zeros;
 	struct stat src_st;
 	const char *open_mode = "wb";
 
@@ -464,9 +570,47 @@ iop_cp(io_args_t *const args)
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
+	in_user_space = 1;
+	skip_zeros = 0;
+
+#ifndef _WIN32
+	/* Files of zero size might be generated on reading (like those in /proc), so
+	 * read them in the regular way. */
+	if(!error && S_ISREG(st.st_mode) && st.st_size > 0)
+	{
+		const int whole_file = (crs != IO_CRS_APPEND_TO_FILES);
+
+		/* Holes are recreated in new files, but not when appending. */
+		skip_zeros = whole_file && is_sparse(&st);
+
+		switch(copy_contents(args, fileno(in), fileno(out), whole_file, skip_zeros,
+					st.st_size))
+		{
+			case CR_DONE:
+				in_user_space = 0;
+				break;
+			case CR_FALLBACK:
+				break;
+			case CR_CANCELLED:
+			case CR_FAILED:
+				in_user_space = 0;
+				error = 1;
+				break;
+		}
+	}
+#endif
+
+	block = in_user_space ? malloc(BLOCK_SIZE) : NULL;
+	if(in_user_space && block == NULL)
+	{
+		(void)ioe_errlst_append(&args->result.errors, src, ENOMEM,
+				strerror(ENOMEM));
+		in_user_space = 0;
+		error = 1;
+	}
 
-	while((nread = fread(&block, 1, sizeof(block), in)) != 0U)
+	nread = 0U;
+	while(in_user_space && (nread = fread(block, 1, BLOCK_SIZE, in)) != 0U)
 	{
 		if(cancellable && ui_cancellation_requested())
 		{
@@ -474,7 +618,25 @@ iop_cp(io_args_t *const args)
 			break;
 		}
 
-		if(fwrite(&block, 1, nread, out) != nread)
+#ifndef _WIN32
+		if(skip_zeros)
+		{
+			size_t skipped;
+			if(write_sparse(out, block, nread, &skipped) != 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, dst, errno,
+						strerror(errno));
+				error = 1;
+				break;
+			}
+
+			ioeta_skip(args->estim, skipped);
+			ioeta_update(args->estim, NULL, NULL, 0, nread - skipped);
+			continue;
+		}
+#endif
+
+		if(fwrite(block, 1, nread, out) != nread)
 		{
 			(void)ioe_errlst_append(&args->result.errors, dst, errno,
 					strerror(errno));
@@ -484,10 +646,24 @@ iop_cp(io_args_t *const args)
 
 		ioeta_update(args->estim, NULL, NULL, 0, nread);
 	}
-	if(nread == 0U && !feof(in) && ferror(in))
+	if(in_user_space && nread == 0U && !feof(in) && ferror(in))
 	{
 		(void)ioe_errlst_append(&args->result.errors, src, errno, strerror(errno));
 	}
+	free(block);
+
+#ifndef _WIN32
+	/* Skipping trailing zeroes doesn't extend the file. */
+	if(in_user_space && skip_zeros && !error)
+	{
+		if(fflush(out) != 0 || ftruncate(fileno(out), ftello(out)) != 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, dst, errno,
+					strerror(errno));
+			error = 1;
+		}
+	}
+#endif
 
 	if(fclose(in) != 0)
 	{
@@ -513,6 +689,611 @@ iop_cp(io_args_t *const args)
 	return error;
 }
 
+#ifndef _WIN32
+
+/* Checks whether file has holes, which is the case when less space is
+ * allocated for it than its size.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_sparse(const struct stat *st)
+{
+	return (uint64_t)st->st_blocks*512U < (uint64_t)st->st_size;
+}
+
+/* Copies contents of regular file in into out without using streams.  Cloning
+ * is possible only when whole_file is set (out is empty and in is at its
+ * beginning), sparse requests recreating holes of in.  Returns status of the
+ * operation. */
+static CopyResult
+copy_contents(io_args_t *args, int in, int out, int whole_file, int sparse,
+		uint64_t size)
+{
+	CopyResult result = CR_FALLBACK;
+
+#ifdef __linux__
+	if(whole_file && (iop_cp_methods & IO_CP_CLONE))
+	{
+		if(ioctl(out, FICLONE, in) == 0)
+		{
+			ioeta_update(args->estim, NULL, NULL, 0, size);
+			return CR_DONE;
+		}
+	}
+#endif
+
+	if(sparse)
+	{
+		/* Data can't be copied in the kernel till the end as it would fill holes
+		 * with zeroes. */
+		return copy_data_regions(args, in, out, size);
+	}
+
+#ifdef __linux__
+	if(iop_cp_methods & IO_CP_RANGE)
+	{
+		result = kernel_copy_chunks(args, in, out, IO_CP_RANGE, UINT64_MAX);
+	}
+	if(result == CR_FALLBACK && (iop_cp_methods & IO_CP_SENDFILE))
+	{
+		result = kernel_copy_chunks(args, in, out, IO_CP_SENDFILE, UINT64_MAX);
+	}
+#endif
+
+	if(result == CR_FALLBACK && (iop_cp_methods & IO_CP_PIPELINE) &&
+			size >= PIPELINE_MIN_FILE_SIZE)
+	{
+		result = pipelined_copy(args, in, out, size);
+	}
+
+	return result;
+}
+
+/* Copies only regions of in that contain data leaving holes in out.  Falls back
+ * if holes can't be found by seeking, in which case blocks of zeroes should be
+ * looked for.  Returns status of the operation. */
+static CopyResult
+copy_data_regions(io_args_t *args, int in, int out, uint64_t size)
+{
+#ifdef SEEK_HOLE
+	const char *const src = args->arg1.src;
+	const char *const dst = args->arg2.dst;
+	off_t data, hole;
+
+	/* File systems that don't track holes report the whole file as data. */
+	hole = lseek(in, 0, SEEK_HOLE);
+	if(lseek(in, 0, SEEK_SET) != 0 || hole < 0 || (uint64_t)hole >= size)
+	{
+		return CR_FALLBACK;
+	}
+
+	hole = 0;
+	while((uint64_t)hole < size)
+	{
+		CopyResult result;
+
+		data = lseek(in, hole, SEEK_DATA);
+		if(data < 0)
+		{
+			if(errno != ENXIO)
+			{
+				(void)ioe_errlst_append(&args->result.errors, src, errno,
+						strerror(errno));
+				return CR_FAILED;
+			}
+			/* The rest of the file is a hole. */
+			data = size;
+		}
+
+		ioeta_skip(args->estim, MIN((uint64_t)data, size) - hole);
+		if((uint64_t)data >= size)
+		{
+			break;
+		}
+
+		hole = lseek(in, data, SEEK_HOLE);
+		if(hole < 0 || lseek(in, data, SEEK_SET) < 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, src, errno,
+					strerror(errno));
+			return CR_FAILED;
+		}
+		if(lseek(out, data, SEEK_SET) < 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, dst, errno,
+					strerror(errno));
+			return CR_FAILED;
+		}
+
+		hole = MIN((uint64_t)hole, size);
+		result = copy_range(args, in, out, hole - data);
+		if(result != CR_DONE)
+		{
+			return result;
+		}
+	}
+
+	/* Trailing hole doesn't extend the file. */
+	if(ftruncate(out, size) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, dst, errno, strerror(errno));
+		return CR_FAILED;
+	}
+
+	return CR_DONE;
+#else
+	return CR_FALLBACK;
+#endif
+}
+
+/* Copies len bytes (or less if in ends earlier) from current position of in to
+ * current position of out.  Returns status of the operation, which is never
+ * CR_FALLBACK. */
+static CopyResult
+copy_range(io_args_t *args, int in, int out, uint64_t len)
+{
+	CopyResult result = CR_FALLBACK;
+
+#ifdef __linux__
+	if(iop_cp_methods & IO_CP_RANGE)
+	{
+		result = kernel_copy_chunks(args, in, out, IO_CP_RANGE, len);
+	}
+	if(result == CR_FALLBACK && (iop_cp_methods & IO_CP_SENDFILE))
+	{
+		result = kernel_copy_chunks(args, in, out, IO_CP_SENDFILE, len);
+	}
+#endif
+
+	if(result == CR_FALLBACK)
+	{
+		result = read_write_chunks(args, in, out, len);
+	}
+
+	return result;
+}
+
+/* Copies len bytes (or less if in ends earlier) from current position of in to
+ * current position of out through a buffer.  Returns status of the operation,
+ * which is never CR_FALLBACK. */
+static CopyResult
+read_write_chunks(io_args_t *args, int in, int out, uint64_t len)
+{
+	uint64_t copied = 0U;
+	char *const block = malloc(BLOCK_SIZE);
+
+	if(block == NULL)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.src, ENOMEM,
+				strerror(ENOMEM));
+		return CR_FAILED;
+	}
+
+	while(copied < len)
+	{
+		ssize_t nread;
+		size_t nwritten;
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			free(block);
+			return CR_CANCELLED;
+		}
+
+		nread = read(in, block, MIN(len - copied, (uint64_t)BLOCK_SIZE));
+		if(nread < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(nread < 0)
+		{
+			(void)ioe_errlst_append(&args->result.errors, args->arg1.src, errno,
+					strerror(errno));
+			free(block);
+			return CR_FAILED;
+		}
+		if(nread == 0)
+		{
+			break;
+		}
+
+		nwritten = 0U;
+		while(nwritten < (size_t)nread)
+		{
+			const ssize_t n = write(out, block + nwritten, nread - nwritten);
+			if(n < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if(n < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+						strerror(errno));
+				free(block);
+				return CR_FAILED;
+			}
+			nwritten += n;
+		}
+
+		copied += nread;
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+	}
+
+	free(block);
+	return CR_DONE;
+}
+
+/* Writes block to out seeking over blocks of zeroes instead of writing them.
+ * Sets *skipped to number of bytes that weren't written.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+write_sparse(FILE *out, const char block[], size_t len, size_t *skipped)
+{
+	size_t i;
+
+	*skipped = 0U;
+	for(i = 0U; i < len; i += ZERO_BLOCK_SIZE)
+	{
+		const size_t n = MIN((size_t)ZERO_BLOCK_SIZE, len - i);
+		if(is_all_zeroes(block + i, n))
+		{
+			if(fseeko(out, n, SEEK_CUR) != 0)
+			{
+				return 1;
+			}
+			*skipped += n;
+		}
+		else if(fwrite(block + i, 1, n, out) != n)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Checks whether block consists of zero bytes only.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+is_all_zeroes(const char block[], size_t len)
+{
+	return len == 0U
+	    || (block[0] == '\0' && memcmp(block, block + 1, len - 1) == 0);
+}
+
+/* Copies len bytes (or less if in ends earlier) from current position of in to
+ * current position of out reading next buffers on a separate thread while
+ * current ones are written.  Falls back if the thread can't be started.
+ * Returns status of the operation. */
+static CopyResult
+pipelined_copy(io_args_t *args, int in, int out, uint64_t len)
+{
+	pthread_t reader;
+	ring_t ring = { .in = in, .len = len };
+	CopyResult result = CR_DONE;
+	off_t out_offset = lseek(out, 0, SEEK_CUR);
+
+	if(out_offset < 0 || ring_init(&ring) != 0)
+	{
+		return CR_FALLBACK;
+	}
+
+	if(pthread_create(&reader, NULL, &ring_reader, &ring) != 0)
+	{
+		ring_free(&ring);
+		return CR_FALLBACK;
+	}
+
+	while(1)
+	{
+		const char *buf;
+		size_t size, nwritten;
+
+		pthread_mutex_lock(&ring.lock);
+		while(ring.nfilled == 0 && !ring.eof)
+		{
+			pthread_cond_wait(&ring.changed, &ring.lock);
+		}
+		if(ring.nfilled == 0)
+		{
+			pthread_mutex_unlock(&ring.lock);
+			break;
+		}
+		buf = ring.bufs[ring.first];
+		size = ring.sizes[ring.first];
+		pthread_mutex_unlock(&ring.lock);
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			result = CR_CANCELLED;
+			break;
+		}
+
+		nwritten = 0U;
+		while(nwritten < size)
+		{
+			const ssize_t n = write(out, buf + nwritten, size - nwritten);
+			if(n < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if(n < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+						strerror(errno));
+				result = CR_FAILED;
+				break;
+			}
+			nwritten += n;
+		}
+		if(result != CR_DONE)
+		{
+			break;
+		}
+
+		/* Start writing data back and don't keep it in the cache afterwards. */
+		advise(out, out_offset, size, 1);
+		out_offset += size;
+
+		ioeta_update(args->estim, NULL, NULL, 0, size);
+
+		pthread_mutex_lock(&ring.lock);
+		ring.first = (ring.first + 1)%RING_NBUFFERS;
+		--ring.nfilled;
+		pthread_cond_signal(&ring.changed);
+		pthread_mutex_unlock(&ring.lock);
+	}
+
+	pthread_mutex_lock(&ring.lock);
+	ring.stop = 1;
+	pthread_cond_signal(&ring.changed);
+	pthread_mutex_unlock(&ring.lock);
+	(void)pthread_join(reader, NULL);
+
+	if(result == CR_DONE && ring.error != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, args->arg1.src, ring.error,
+				strerror(ring.error));
+		result = CR_FAILED;
+	}
+
+	ring_free(&ring);
+	return result;
+}
+
+/* Allocates buffers and synchronization primitives of the ring.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+ring_init(ring_t *ring)
+{
+	int i;
+
+	for(i = 0; i < RING_NBUFFERS; ++i)
+	{
+		ring->bufs[i] = malloc(RING_BUFFER_SIZE);
+		if(ring->bufs[i] == NULL)
+		{
+			while(i-- > 0)
+			{
+				free(ring->bufs[i]);
+			}
+			return 1;
+		}
+	}
+
+	if(pthread_mutex_init(&ring->lock, NULL) != 0)
+	{
+		for(i = 0; i < RING_NBUFFERS; ++i)
+		{
+			free(ring->bufs[i]);
+		}
+		return 1;
+	}
+
+	if(pthread_cond_init(&ring->changed, NULL) != 0)
+	{
+		pthread_mutex_destroy(&ring->lock);
+		for(i = 0; i < RING_NBUFFERS; ++i)
+		{
+			free(ring->bufs[i]);
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Frees resources of the ring. */
+static void
+ring_free(ring_t *ring)
+{
+	int i;
+
+	pthread_cond_destroy(&ring->changed);
+	pthread_mutex_destroy(&ring->lock);
+	for(i = 0; i < RING_NBUFFERS; ++i)
+	{
+		free(ring->bufs[i]);
+	}
+}
+
+/* Entry point of the thread that fills buffers of the ring until end of input,
+ * an error or a request to stop.  Returns NULL. */
+static void *
+ring_reader(void *arg)
+{
+	ring_t *const ring = arg;
+	off_t offset = lseek(ring->in, 0, SEEK_CUR);
+
+	advise(ring->in, 0, 0, 0);
+
+	while(1)
+	{
+		ssize_t n;
+		int i;
+
+		pthread_mutex_lock(&ring->lock);
+		while(ring->nfilled == RING_NBUFFERS && !ring->stop)
+		{
+			pthread_cond_wait(&ring->changed, &ring->lock);
+		}
+		if(ring->stop)
+		{
+			pthread_mutex_unlock(&ring->lock);
+			break;
+		}
+		i = (ring->first + ring->nfilled)%RING_NBUFFERS;
+		pthread_mutex_unlock(&ring->lock);
+
+		n = read_fully(ring->in, ring->bufs[i],
+				MIN(ring->len, (uint64_t)RING_BUFFER_SIZE));
+
+		pthread_mutex_lock(&ring->lock);
+		if(n > 0)
+		{
+			ring->sizes[i] = n;
+			++ring->nfilled;
+			ring->len -= n;
+		}
+		if(n < 0)
+		{
+			ring->error = errno;
+		}
+		if(n <= 0 || ring->len == 0U)
+		{
+			ring->eof = 1;
+		}
+		pthread_cond_signal(&ring->changed);
+		pthread_mutex_unlock(&ring->lock);
+
+		if(n <= 0 || ring->len == 0U)
+		{
+			break;
+		}
+
+		/* Data that was read won't be needed again. */
+		if(offset >= 0)
+		{
+			advise(ring->in, offset, n, 1);
+			offset += n;
+		}
+	}
+
+	return NULL;
+}
+
+/* Reads up to len bytes from the file stopping only at its end.  Returns
+ * number of bytes read or negative number on error. */
+static ssize_t
+read_fully(int fd, char buf[], size_t len)
+{
+	size_t total = 0U;
+	while(total < len)
+	{
+		const ssize_t n = read(fd, buf + total, len - total);
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n < 0)
+		{
+			return -1;
+		}
+		if(n == 0)
+		{
+			break;
+		}
+		total += n;
+	}
+	return total;
+}
+
+/* Hints the system that specified range of the file (len of zero means till the
+ * end of it) is going to be accessed sequentially or, if drop is set, won't be
+ * accessed again. */
+static void
+advise(int fd, off_t offset, off_t len, int drop)
+{
+#ifdef POSIX_FADV_DONTNEED
+	(void)posix_fadvise(fd, offset, len,
+			drop ? POSIX_FADV_DONTNEED : POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+#ifdef __linux__
+
+/* Copies up to len bytes from current position of in to current position of out
+ * chunk by chunk in the kernel reporting progress and checking for
+ * cancellation.  Falls back (e.g., for different file systems or append mode)
+ * only if nothing was copied, so that positions in files stay intact.  Returns
+ * status of the operation. */
+static CopyResult
+kernel_copy_chunks(io_args_t *args, int in, int out, IoCpMethod method,
+		uint64_t len)
+{
+	uint64_t copied = 0U;
+
+	while(copied < len)
+	{
+		ssize_t n;
+
+		if(args->cancellable && ui_cancellation_requested())
+		{
+			return CR_CANCELLED;
+		}
+
+		n = kernel_copy_chunk(in, out, method,
+				MIN(len - copied, (uint64_t)KERNEL_CHUNK_SIZE));
+		if(n < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			if(copied == 0U)
+			{
+				return CR_FALLBACK;
+			}
+			(void)ioe_errlst_append(&args->result.errors, args->arg2.dst, errno,
+					strerror(errno));
+			return CR_FAILED;
+		}
+
+		/* Some special files report non-zero size, but aren't copied this way, in
+		 * which case end of file is reported right away. */
+		if(n == 0)
+		{
+			return (copied == 0U ? CR_FALLBACK : CR_DONE);
+		}
+
+		copied += n;
+		ioeta_update(args->estim, NULL, NULL, 0, n);
+	}
+
+	return CR_DONE;
+}
+
+/* Transfers next chunk of data of at most len bytes from in to out.  Returns
+ * number of bytes copied, zero at the end of in or negative number on
+ * error. */
+static ssize_t
+kernel_copy_chunk(int in, int out, IoCpMethod method, size_t len)
+{
+	if(method == IO_CP_RANGE)
+	{
+#ifdef SYS_copy_file_range
+		return syscall(SYS_copy_file_range, in, NULL, out, NULL, len, 0U);
+#else
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+
+	return sendfile(out, in, NULL, len);
+}
+
+#endif
+
+#endif
+
 #ifdef _WIN32
 
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
@@ -23,6 +23,26 @@
 
 /* iop - I/O primitive - Input/Output primitive */
 
+/* Ways of copying contents of regular files that are tried by iop_cp() in the
+ * order of their declaration.  Reading and writing data in user space is always
+ * available as the last resort. */
+typedef enum
+{
+	IO_CP_CLONE    = 1 << 0, /* Sharing data blocks of the file (FICLONE). */
+	IO_CP_RANGE    = 1 << 1, /* Copying in the kernel (copy_file_range()). */
+	IO_CP_SENDFILE = 1 << 2, /* Transferring data in the kernel (sendfile()). */
+	IO_CP_PIPELINE = 1 << 3, /* Reading and writing by two threads at once. */
+	IO_CP_ALL = IO_CP_CLONE | IO_CP_RANGE | IO_CP_SENDFILE | IO_CP_PIPELINE,
+	/* Pipelining is left out as it wasn't measured to be faster than the plain
+	 * loop of reading and writing (see tests/iop/cp.c for a benchmark). */
+	IO_CP_DEFAULT = IO_CP_CLONE | IO_CP_RANGE | IO_CP_SENDFILE
+}
+IoCpMethod;
+
+/* Set of IoCpMethod values that iop_cp() is allowed to use.  IO_CP_DEFAULT by
+ * default, can be changed to exercise particular way of copying. */
+extern int iop_cp_methods;
+
 /* All functions return zero on success and non-zero on error. */
 
 /* Creates file.  Expects path in arg1.  Fails if one already exists. */
@@ -19,13 +19,14 @@
 #include "ior.h"
 
 #include <sys/stat.h> /* stat */
+#include <sys/types.h> /* dev_t mode_t */
 #include <unistd.h> /* unlink() */
 
-#include <errno.h> /* EEXIST EISDIR ENOTEMPTY EXDEV errno */
-#include <stddef.h> /* NULL */
+#include <errno.h> /* EEXIST EISDIR ENOMEM ENOTEMPTY EXDEV errno */
+#include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* removee() snprintf() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strerror() strlen() */
+#include <stdlib.h> /* free() realloc() */
+#include <string.h> /* strcmp() strdup() strerror() strlen() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
@@ -35,12 +36,38 @@
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../background.h"
+#include "private/cp_pool.h"
 #include "private/ioe.h"
 #include "private/ioeta.h"
 #include "private/traverser.h"
 #include "ioc.h"
 #include "iop.h"
 
+/* Files larger than this are copied on the calling thread, which reports
+ * progress for them as copying goes.  Parallel copying doesn't speed up copying
+ * of large files much. */
+#define MAX_POOLED_FILE_SIZE (1024*1024)
+
+/* Permissions of a directory to be set after copying its files. */
+typedef struct
+{
+	char *path; /* Path to the directory. */
+	mode_t mode; /* Its permissions. */
+}
+dir_mode_t;
+
+/* State of subtree copying. */
+typedef struct
+{
+	io_args_t *args;         /* Arguments of the operation. */
+	cp_pool_t *pool;         /* Pool of threads copying files or NULL. */
+	char dev_dir[PATH_MAX];  /* Last directory whose device was queried. */
+	dev_t dev;               /* Device of the dev_dir. */
+	dir_mode_t *dir_modes;   /* Postponed changes of permissions. */
+	size_t ndir_modes;       /* Number of elements in dir_modes. */
+}
+cp_state_t;
+
 static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		void *param);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
@@ -49,7 +76,10 @@ static int is_file(const char path[]);
 static VisitResult mv_visitor(const char full_path[], VisitAction action,
 		void *param);
 static VisitResult cp_mv_visitor(const char full_path[], VisitAction action,
-		void *param, int cp);
+		io_args_t *cp_args, cp_state_t *cp);
+static int copy_in_pool(cp_state_t *cp, const char src[], const char dst[]);
+static int postpone_chmod(cp_state_t *cp, const char path[], mode_t mode);
+static int finish_pooled_cp(cp_state_t *cp);
 
 int
 ior_rm(io_args_t *const args)
@@ -149,7 +179,20 @@ ior_cp(io_args_t *const args)
 		}
 	}
 
-	return traverse(src, &cp_visitor, args);
+	{
+		int result;
+		cp_state_t cp = {
+			.args = args,
+			.pool = cp_pool_create(args, args->max_jobs),
+		};
+
+		result = traverse(src, &cp_visitor, &cp);
+		if(cp.pool != NULL && finish_pooled_cp(&cp) != 0 && result == 0)
+		{
+			result = 1;
+		}
+		return result;
+	}
 }
 
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
@@ -157,7 +200,8 @@ ior_cp(io_args_t *const args)
 static VisitResult
 cp_visitor(const char full_path[], VisitAction action, void *param)
 {
-	return cp_mv_visitor(full_path, action, param, 1);
+	cp_state_t *const cp = param;
+	return cp_mv_visitor(full_path, action, cp->args, cp);
 }
 
 int
@@ -322,15 +366,16 @@ is_file(const char path[])
 static VisitResult
 mv_visitor(const char full_path[], VisitAction action, void *param)
 {
-	return cp_mv_visitor(full_path, action, param, 0);
+	return cp_mv_visitor(full_path, action, param, NULL);
 }
 
-/* Generic implementation of traverse() visitor for subtree copying/moving.
- * Returns 0 on success, otherwise non-zero is returned. */
+/* Generic implementation of traverse() visitor for subtree copying/moving.  cp
+ * is NULL for moving.  Returns 0 on success, otherwise non-zero is
+ * returned. */
 static VisitResult
-cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
+cp_mv_visitor(const char full_path[], VisitAction action, io_args_t *cp_args,
+		cp_state_t *cp)
 {
-	io_args_t *const cp_args = param;
 	const char *dst_full_path;
 	char *free_me = NULL;
 	VisitResult result = VR_OK;
@@ -367,12 +412,21 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 				result = (iop_mkdir(&args) == 0) ? VR_OK : VR_ERROR;
 				cp_args->result = args.result;
 			}
-			else if(cp)
+			else if(cp != NULL)
 			{
 				result = VR_SKIP_DIR_LEAVE;
 			}
 			break;
 		case VA_FILE:
+			if(cp != NULL && cp->pool != NULL &&
+					copy_in_pool(cp, full_path, dst_full_path))
+			{
+				result = (cp_pool_add(cp->pool, full_path, dst_full_path, cp->dev) == 0)
+				       ? VR_OK
+				       : VR_ERROR;
+				break;
+			}
+
 			{
 				io_args_t args = {
 					.arg1.src = full_path,
@@ -386,7 +440,9 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 					.result = cp_args->result,
 				};
 
-				result = ((cp ? iop_cp(&args) : ior_mv(&args)) == 0) ? VR_OK : VR_ERROR;
+				result = ((cp != NULL ? iop_cp(&args) : ior_mv(&args)) == 0)
+				       ? VR_OK
+				       : VR_ERROR;
 				cp_args->result = args.result;
 				break;
 			}
@@ -394,7 +450,7 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 			{
 				struct stat st;
 
-				if(cp_args->arg3.crs == IO_CRS_REPLACE_FILES && !cp)
+				if(cp_args->arg3.crs == IO_CRS_REPLACE_FILES && cp == NULL)
 				{
 					io_args_t rm_args = {
 						.arg1.path = full_path,
@@ -409,6 +465,14 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 				}
 				else if(os_stat(full_path, &st) == 0)
 				{
+					/* Files might still be being copied into the directory. */
+					if(cp != NULL && cp->pool != NULL &&
+							postpone_chmod(cp, dst_full_path, st.st_mode & 07777) == 0)
+					{
+						result = VR_OK;
+						break;
+					}
+
 					result = (os_chmod(dst_full_path, st.st_mode & 07777) == 0)
 									? VR_OK
 									: VR_ERROR;
@@ -433,5 +497,89 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 	return result;
 }
 
+/* Checks whether file should be copied by the pool and updates device of
+ * destination directory in the state.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+copy_in_pool(cp_state_t *cp, const char src[], const char dst[])
+{
+	char dst_dir[PATH_MAX];
+	struct stat st;
+
+	if(os_lstat(src, &st) != 0 ||
+			(S_ISREG(st.st_mode) && st.st_size > MAX_POOLED_FILE_SIZE))
+	{
+		return 0;
+	}
+
+	copy_str(dst_dir, sizeof(dst_dir), dst);
+	remove_last_path_component(dst_dir);
+	if(strcmp(dst_dir, cp->dev_dir) != 0)
+	{
+		if(os_stat(dst_dir, &st) != 0)
+		{
+			cp->dev_dir[0] = '\0';
+			return 0;
+		}
+		copy_str(cp->dev_dir, sizeof(cp->dev_dir), dst_dir);
+		cp->dev = st.st_dev;
+	}
+
+	return 1;
+}
+
+/* Remembers permissions to be set for the directory after copying of files is
+ * done.  Returns zero on success, otherwise non-zero is returned. */
+static int
+postpone_chmod(cp_state_t *cp, const char path[], mode_t mode)
+{
+	char *const path_copy = strdup(path);
+	dir_mode_t *const dir_modes = realloc(cp->dir_modes,
+			sizeof(*cp->dir_modes)*(cp->ndir_modes + 1U));
+	if(path_copy == NULL || dir_modes == NULL)
+	{
+		free(path_copy);
+		if(dir_modes != NULL)
+		{
+			cp->dir_modes = dir_modes;
+		}
+		return 1;
+	}
+
+	cp->dir_modes = dir_modes;
+	cp->dir_modes[cp->ndir_modes].path = path_copy;
+	cp->dir_modes[cp->ndir_modes].mode = mode;
+	++cp->ndir_modes;
+	return 0;
+}
+
+/* Waits for copying of files by the pool to finish, frees it and sets
+ * permissions of directories.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+finish_pooled_cp(cp_state_t *cp)
+{
+	size_t i;
+	int result = cp_pool_wait(cp->pool);
+
+	cp_pool_free(cp->pool);
+	cp->pool = NULL;
+
+	for(i = 0U; i < cp->ndir_modes; ++i)
+	{
+		const dir_mode_t *const dir_mode = &cp->dir_modes[i];
+		if(os_chmod(dir_mode->path, dir_mode->mode) != 0)
+		{
+			(void)ioe_errlst_append(&cp->args->result.errors, dir_mode->path, errno,
+					strerror(errno));
+			result = 1;
+		}
+		free(dir_mode->path);
+	}
+	free(cp->dir_modes);
+
+	return result;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,456 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "cp_pool.h"
+
+#include <sys/stat.h> /* stat */
+#include <sys/types.h> /* dev_t */
+#include <pthread.h> /* PTHREAD_* pthread_* */
+
+#include <errno.h> /* EEXIST ENOMEM */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() realloc() */
+#include <string.h> /* strdup() strerror() */
+
+#include "../../compat/os.h"
+#include "../../ui/cancellation.h"
+#include "../../utils/fs.h"
+#include "../ioc.h"
+#include "../iop.h"
+#include "ioe.h"
+#include "ioeta.h"
+
+/* Upper limit on number of threads of a single pool. */
+#define MAX_THREADS 32
+
+/* Single file to be copied. */
+typedef struct job_t
+{
+	struct job_t *next;  /* Next job in the list. */
+	char *src;           /* Source path. */
+	char *dst;           /* Destination path. */
+	dev_t dev;           /* Device of the destination. */
+	uint64_t size;       /* Number of bytes to report on success. */
+	int error;           /* Result of iop_cp(). */
+	int confirm;         /* Destination exists and copying should be redone by
+	                        the owner of the pool after confirmation. */
+	ioe_errlst_t errors; /* Errors of this copy. */
+}
+job_t;
+
+/* Number of files being copied to a device. */
+typedef struct
+{
+	dev_t dev;  /* The device. */
+	int active; /* Number of copies in progress. */
+}
+dev_slot_t;
+
+struct cp_pool_t
+{
+	io_args_t *args;           /* Arguments of the whole operation. */
+	int max_jobs;              /* Limit on copies to the same device. */
+	pthread_t threads[MAX_THREADS]; /* Worker threads. */
+	int nthreads;              /* Number of started threads. */
+	int failed;                /* Whether any of the reported copies failed. */
+
+	/* Fields below are protected by the lock. */
+	pthread_cond_t has_work;   /* Signaled on new jobs and on stopping. */
+	job_t *queue;              /* Jobs waiting for a thread. */
+	job_t **queue_tail;        /* Where to append next job. */
+	job_t *done;               /* Finished jobs, which aren't reported yet. */
+	int scheduled;             /* Number of jobs that aren't reported yet. */
+	int stop;                  /* Whether threads should quit. */
+};
+
+static void * worker(void *arg);
+static void run_job(const cp_pool_t *pool, job_t *job);
+static void report_done(cp_pool_t *pool);
+static void report_job(cp_pool_t *pool, job_t *job);
+static dev_slot_t * get_slot(dev_t dev);
+static void free_job(job_t *job);
+
+/* Protects all pools and devs array. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when a copy finishes. */
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+/* Devices that were written to. */
+static dev_slot_t *devs;
+/* Number of elements in devs array. */
+static int ndevs;
+
+cp_pool_t *
+cp_pool_create(io_args_t *args, int max_jobs)
+{
+	cp_pool_t *pool;
+	int i;
+
+	if(max_jobs < 2)
+	{
+		return NULL;
+	}
+
+	pool = calloc(1, sizeof(*pool));
+	if(pool == NULL)
+	{
+		return NULL;
+	}
+
+	pool->args = args;
+	pool->max_jobs = max_jobs;
+	pool->queue_tail = &pool->queue;
+	if(pthread_cond_init(&pool->has_work, NULL) != 0)
+	{
+		free(pool);
+		return NULL;
+	}
+
+	for(i = 0; i < max_jobs && i < MAX_THREADS; ++i)
+	{
+		if(pthread_create(&pool->threads[i], NULL, &worker, pool) != 0)
+		{
+			break;
+		}
+		++pool->nthreads;
+	}
+
+	if(pool->nthreads == 0)
+	{
+		cp_pool_free(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+int
+cp_pool_add(cp_pool_t *pool, const char src[], const char dst[], dev_t dev)
+{
+	dev_slot_t *slot;
+	job_t *const job = calloc(1, sizeof(*job));
+	if(job == NULL)
+	{
+		(void)ioe_errlst_append(&pool->args->result.errors, src, ENOMEM,
+				strerror(ENOMEM));
+		return 1;
+	}
+
+	job->src = strdup(src);
+	job->dst = strdup(dst);
+	job->dev = dev;
+	ioe_errlst_init(&job->errors);
+	if(job->src == NULL || job->dst == NULL)
+	{
+		(void)ioe_errlst_append(&pool->args->result.errors, src, ENOMEM,
+				strerror(ENOMEM));
+		free_job(job);
+		return 1;
+	}
+
+	pthread_mutex_lock(&lock);
+	while(1)
+	{
+		if(pool->done != NULL)
+		{
+			report_done(pool);
+			continue;
+		}
+
+		slot = get_slot(dev);
+		if(slot == NULL || slot->active < pool->max_jobs)
+		{
+			break;
+		}
+
+		pthread_cond_wait(&changed, &lock);
+	}
+
+	if(slot == NULL || pool->failed)
+	{
+		pthread_mutex_unlock(&lock);
+		if(slot == NULL)
+		{
+			(void)ioe_errlst_append(&pool->args->result.errors, src, ENOMEM,
+					strerror(ENOMEM));
+		}
+		free_job(job);
+		return 1;
+	}
+
+	++slot->active;
+	++pool->scheduled;
+	*pool->queue_tail = job;
+	pool->queue_tail = &job->next;
+	pthread_cond_signal(&pool->has_work);
+	pthread_mutex_unlock(&lock);
+
+	return 0;
+}
+
+int
+cp_pool_wait(cp_pool_t *pool)
+{
+	pthread_mutex_lock(&lock);
+	while(pool->scheduled != 0)
+	{
+		if(pool->done != NULL)
+		{
+			report_done(pool);
+		}
+		else
+		{
+			pthread_cond_wait(&changed, &lock);
+		}
+	}
+	pthread_mutex_unlock(&lock);
+
+	return pool->failed;
+}
+
+void
+cp_pool_free(cp_pool_t *pool)
+{
+	int i;
+
+	if(pool == NULL)
+	{
+		return;
+	}
+
+	(void)cp_pool_wait(pool);
+
+	pthread_mutex_lock(&lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->has_work);
+	pthread_mutex_unlock(&lock);
+
+	for(i = 0; i < pool->nthreads; ++i)
+	{
+		(void)pthread_join(pool->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->has_work);
+	free(pool);
+}
+
+/* Entry point of worker threads, which take jobs from the queue until the pool
+ * is stopped.  Returns NULL. */
+static void *
+worker(void *arg)
+{
+	cp_pool_t *const pool = arg;
+
+	pthread_mutex_lock(&lock);
+	while(1)
+	{
+		job_t *job;
+
+		while(pool->queue == NULL && !pool->stop)
+		{
+			pthread_cond_wait(&pool->has_work, &lock);
+		}
+
+		job = pool->queue;
+		if(job == NULL)
+		{
+			break;
+		}
+
+		pool->queue = job->next;
+		if(pool->queue == NULL)
+		{
+			pool->queue_tail = &pool->queue;
+		}
+		pthread_mutex_unlock(&lock);
+
+		run_job(pool, job);
+
+		pthread_mutex_lock(&lock);
+		--get_slot(job->dev)->active;
+		job->next = pool->done;
+		pool->done = job;
+		pthread_cond_broadcast(&changed);
+	}
+	pthread_mutex_unlock(&lock);
+
+	return NULL;
+}
+
+/* Copies single file without reporting progress or asking for
+ * confirmations. */
+static void
+run_job(const cp_pool_t *pool, job_t *job)
+{
+	const io_args_t *const args = pool->args;
+	/* Replacing files can require confirmation, which can't be asked for here,
+	 * so fail instead of overwriting and let owner of the pool redo the copy. */
+	const int needs_confirm = args->confirm != NULL
+	                       && args->arg3.crs != IO_CRS_FAIL
+	                       && args->arg3.crs != IO_CRS_APPEND_TO_FILES;
+	struct stat st;
+
+	io_args_t cp_args = {
+		.arg1.src = job->src,
+		.arg2.dst = job->dst,
+		.arg3.crs = needs_confirm ? IO_CRS_FAIL : args->arg3.crs,
+
+		.cancellable = args->cancellable,
+
+		.result.errors = job->errors,
+	};
+
+	if(args->cancellable && ui_cancellation_requested())
+	{
+		job->error = 1;
+		return;
+	}
+
+	if(os_lstat(job->src, &st) == 0 && S_ISREG(st.st_mode))
+	{
+		job->size = st.st_size;
+	}
+
+	job->error = iop_cp(&cp_args);
+	job->errors = cp_args.result.errors;
+
+	if(needs_confirm && job->error && job->errors.error_count == 1U &&
+			job->errors.errors[0].error_code == EEXIST)
+	{
+		job->confirm = 1;
+	}
+}
+
+/* Reports results of finished jobs of the pool.  Must be called with the lock
+ * held, which is released for the time of reporting. */
+static void
+report_done(cp_pool_t *pool)
+{
+	job_t *done = NULL;
+	int nreported = 0;
+
+	/* Reverse the list to report jobs in the order of their completion. */
+	while(pool->done != NULL)
+	{
+		job_t *const job = pool->done;
+		pool->done = job->next;
+		job->next = done;
+		done = job;
+	}
+
+	pthread_mutex_unlock(&lock);
+	while(done != NULL)
+	{
+		job_t *const job = done;
+		done = job->next;
+		report_job(pool, job);
+		free_job(job);
+		++nreported;
+	}
+	pthread_mutex_lock(&lock);
+
+	pool->scheduled -= nreported;
+}
+
+/* Updates progress and list of errors of the operation with results of the
+ * job, redoing it if confirmation is needed. */
+static void
+report_job(cp_pool_t *pool, job_t *job)
+{
+	io_args_t *const args = pool->args;
+	size_t i;
+
+	if(job->confirm)
+	{
+		io_args_t cp_args = {
+			.arg1.src = job->src,
+			.arg2.dst = job->dst,
+			.arg3.crs = args->arg3.crs,
+
+			.cancellable = args->cancellable,
+			.confirm = args->confirm,
+			.estim = args->estim,
+
+			.result = args->result,
+		};
+
+		if(iop_cp(&cp_args) != 0)
+		{
+			pool->failed = 1;
+		}
+		args->result = cp_args.result;
+		return;
+	}
+
+	for(i = 0U; i < job->errors.error_count; ++i)
+	{
+		const ioe_err_t *const err = &job->errors.errors[i];
+		(void)ioe_errlst_append(&args->result.errors, err->path, err->error_code,
+				err->msg);
+	}
+
+	if(job->error)
+	{
+		pool->failed = 1;
+	}
+
+	ioeta_update(args->estim, job->src, job->dst, 0, job->error ? 0 : job->size);
+	ioeta_update(args->estim, NULL, NULL, 1, 0);
+}
+
+/* Finds or adds entry of the devs array for the device.  Must be called with
+ * the lock held.  Returns pointer to the entry, which is valid until the lock
+ * is released, or NULL on memory allocation error. */
+static dev_slot_t *
+get_slot(dev_t dev)
+{
+	dev_slot_t *new_devs;
+	int i;
+
+	for(i = 0; i < ndevs; ++i)
+	{
+		if(devs[i].dev == dev)
+		{
+			return &devs[i];
+		}
+	}
+
+	new_devs = realloc(devs, sizeof(*devs)*(ndevs + 1));
+	if(new_devs == NULL)
+	{
+		return NULL;
+	}
+
+	devs = new_devs;
+	devs[ndevs].dev = dev;
+	devs[ndevs].active = 0;
+	return &devs[ndevs++];
+}
+
+/* Frees the job. */
+static void
+free_job(job_t *job)
+{
+	ioe_errlst_free(&job->errors);
+	free(job->src);
+	free(job->dst);
+	free(job);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
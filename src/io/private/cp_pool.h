@@ -0,0 +1,60 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__CP_POOL_H__
+#define VIFM__IO__PRIVATE__CP_POOL_H__
+
+#include <sys/types.h> /* dev_t */
+
+#include "../ioc.h"
+
+/* cp_pool - pool of threads copying files in parallel */
+
+/* Files are copied by iop_cp() on worker threads, while progress, errors and
+ * overwrite confirmations are processed only on the thread that owns the pool
+ * (inside cp_pool_add() and cp_pool_wait()).  Number of files that are being
+ * copied to the same device at the same time is limited across all pools. */
+
+/* Opaque declaration of the pool. */
+typedef struct cp_pool_t cp_pool_t;
+
+/* Creates pool for copying files on behalf of the operation described by the
+ * args (its crs, confirm, cancellable, estim and result fields are used).  Up
+ * to max_jobs files are copied to the same device at once.  Returns NULL if
+ * parallel copying isn't possible or isn't requested. */
+cp_pool_t * cp_pool_create(io_args_t *args, int max_jobs);
+
+/* Schedules copying of src file to dst, which is located on the dev device.
+ * Blocks while the device is busy reporting results of finished copies.
+ * Returns zero on success, otherwise non-zero is returned (including the case
+ * when one of previous copies has failed). */
+int cp_pool_add(cp_pool_t *pool, const char src[], const char dst[],
+		dev_t dev);
+
+/* Waits for all scheduled copies to finish and reports their results.  Returns
+ * zero if all of them succeeded, otherwise non-zero is returned. */
+int cp_pool_wait(cp_pool_t *pool);
+
+/* Waits for scheduled copies and frees resources of the pool.  The pool can be
+ * NULL. */
+void cp_pool_free(cp_pool_t *pool);
+
+#endif /* VIFM__IO__PRIVATE__CP_POOL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -22,6 +22,7 @@
 #include <stdint.h> /* uint64_t */
 
 #include "../../utils/fs.h"
+#include "../../utils/macros.h"
 #include "../../utils/str.h"
 #include "../ioeta.h"
 #include "ionotif.h"
@@ -102,6 +103,21 @@ ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 	ionotif_notify(IO_PS_IN_PROGRESS, estim);
 }
 
+void
+ioeta_skip(ioeta_estim_t *estim, uint64_t bytes)
+{
+	if(estim == NULL || estim->silent)
+	{
+		return;
+	}
+
+	/* Estimations can be out of date, so don't go below processed amount. */
+	estim->total_bytes -= MIN(bytes, estim->total_bytes - estim->current_byte);
+	estim->total_file_bytes -= MIN(bytes,
+			estim->total_file_bytes - MIN(estim->current_file_byte,
+				estim->total_file_bytes));
+}
+
 int
 ioeta_silent_on(ioeta_estim_t *estim)
 {
@@ -44,6 +44,11 @@ void ioeta_add_dir(ioeta_estim_t *estim, const char path[]);
 void ioeta_update(ioeta_estim_t *estim, const char path[], const char target[],
 		int finished, uint64_t bytes);
 
+/* Excludes bytes of current item that don't need to be processed (like holes of
+ * sparse files) from the estimation.  When estim is NULL, the function just
+ * returns. */
+void ioeta_skip(ioeta_estim_t *estim, uint64_t bytes);
+
 /* Silence future progress reports.  Returns previous state to be passed to
  * ioeta_silent_set() later.  If estim is NULL, returns zero. */
 int ioeta_silent_on(ioeta_estim_t *estim);
@@ -18,22 +18,64 @@
 
 #include "traverser.h"
 
-#include <stddef.h> /* NULL */
-#include <stdlib.h> /* free() */
+#ifndef _WIN32
+#include <sys/stat.h> /* S_ISDIR() fstatat() stat */
+#include <dirent.h> /* DT_DIR DT_UNKNOWN */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW O_* open() openat() */
+#include <unistd.h> /* close() */
+#endif
 
-#include "../../compat/os.h"
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() realloc() */
+#include <string.h> /* memcpy() strlen() */
+
+#include "../../compat/reallocarray.h"
 #include "../../utils/fs.h"
-#include "../../utils/path.h"
-#include "../../utils/str.h"
+
+/* Directory that is being read. */
+typedef struct
+{
+	dir_batch_reader_t *reader;       /* Reader of the directory. */
+	const dir_batch_entry_t *entries; /* Last batch of entries. */
+	int count;                        /* Number of entries in the batch. */
+	int next;                         /* Index of the next entry to visit. */
+#ifndef _WIN32
+	int fd;                           /* Descriptor of the directory. */
+#endif
+	size_t path_len;                  /* Length of path to the directory. */
+	int report_leave;                 /* Whether to report VA_DIR_LEAVE. */
+}
+dir_frame_t;
+
+/* State of traversing a subtree. */
+typedef struct
+{
+	subtree_visitor visitor; /* Client's callback. */
+	void *param;             /* Parameter of the callback. */
+	char *path;              /* Path to current entry. */
+	size_t path_cap;         /* Capacity of the path buffer. */
+	dir_frame_t *dirs;       /* Stack of directories from root to current one. */
+	int ndirs;               /* Number of directories in the stack. */
+	int dirs_cap;            /* Capacity of the stack. */
+}
+traversal_t;
 
 static int traverse_subtree(const char path[], subtree_visitor visitor,
 		void *param);
+static int visit_next(traversal_t *t);
+static int enter_dir(traversal_t *t, dir_frame_t *dir);
+static int set_path(traversal_t *t, size_t pos, const char name[]);
+static int is_dir_entry(const traversal_t *t, const dir_frame_t *parent,
+		const dir_batch_entry_t *entry);
+static int open_dir(const traversal_t *t, const dir_frame_t *parent,
+		const char name[], dir_frame_t *dir);
+static void close_dir(dir_frame_t *dir);
 
 int
 traverse(const char path[], subtree_visitor visitor, void *param)
 {
 	/* Duplication with traverse_subtree(), but this way traverse_subtree() can
-	 * use information from dirent structure to save some operations. */
+	 * use information from directory entries to save some operations. */
 
 	if(is_symlink(path))
 	{
@@ -50,69 +92,237 @@ traverse(const char path[], subtree_visitor visitor, void *param)
 	}
 }
 
-/* A generic subtree traversing.  Returns zero on success, otherwise non-zero is
- * returned. */
+/* A generic subtree traversing.  Directories are opened relative to their
+ * parents, read in batches and kept in a stack instead of recursing, while
+ * paths of entries are formed in a single buffer.  Returns zero on success,
+ * otherwise non-zero is returned. */
 static int
 traverse_subtree(const char path[], subtree_visitor visitor, void *param)
 {
-	DIR *dir;
-	struct dirent *d;
 	int result;
-	VisitResult enter_result;
+	dir_frame_t root;
+	traversal_t t = {
+		.visitor = visitor,
+		.param = param,
+	};
 
-	dir = os_opendir(path);
-	if(dir == NULL)
+	if(set_path(&t, 0U, path) != 0)
 	{
 		return 1;
 	}
 
-	enter_result = visitor(path, VA_DIR_ENTER, param);
-	if(enter_result == VR_ERROR)
+	if(open_dir(&t, NULL, path, &root) != 0)
 	{
-		(void)os_closedir(dir);
+		free(t.path);
 		return 1;
 	}
 
-	result = 0;
-	while((d = os_readdir(dir)) != NULL)
+	result = enter_dir(&t, &root);
+	while(result == 0 && t.ndirs != 0)
 	{
-		char *full_path;
+		result = visit_next(&t);
+	}
 
-		if(is_builtin_dir(d->d_name))
+	/* Close whatever is left open after an error. */
+	while(t.ndirs != 0)
+	{
+		close_dir(&t.dirs[--t.ndirs]);
+	}
+
+	free(t.dirs);
+	free(t.path);
+	return result;
+}
+
+/* Visits next entry of the innermost directory reading next batch of its
+ * entries if needed or leaves the directory if there are no more entries.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+visit_next(traversal_t *t)
+{
+	dir_frame_t *const top = &t->dirs[t->ndirs - 1];
+	const dir_batch_entry_t *entry;
+
+	if(top->next == top->count)
+	{
+		if(dir_batch_reader_next(top->reader, &top->entries, &top->count) != 0)
 		{
-			continue;
+			return 1;
 		}
+		top->next = 0;
 
-		full_path = format_str("%s/%s", path, d->d_name);
-		if(entry_is_link(full_path, d))
+		if(top->count == 0)
 		{
-			/* Treat symbolic links to directories as files as well. */
-			result = visitor(full_path, VA_FILE, param);
+			const int report_leave = top->report_leave;
+
+			t->path[top->path_len] = '\0';
+			close_dir(top);
+			--t->ndirs;
+
+			return report_leave ? t->visitor(t->path, VA_DIR_LEAVE, t->param) : 0;
 		}
-		else if(entry_is_dir(full_path, d))
+	}
+
+	entry = &top->entries[top->next++];
+	if(set_path(t, top->path_len, entry->name) != 0)
+	{
+		return 1;
+	}
+
+	if(is_dir_entry(t, top, entry))
+	{
+		dir_frame_t dir;
+		if(open_dir(t, top, entry->name, &dir) != 0)
 		{
-			result = traverse_subtree(full_path, visitor, param);
+			return 1;
 		}
-		else
+		return enter_dir(t, &dir);
+	}
+
+	/* Symbolic links to directories are treated as files as well. */
+	return t->visitor(t->path, VA_FILE, t->param);
+}
+
+/* Notifies visitor about entering directory that is in the path buffer and
+ * pushes it onto the stack.  Takes ownership of the dir.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+enter_dir(traversal_t *t, dir_frame_t *dir)
+{
+	VisitResult result;
+
+	if(t->ndirs == t->dirs_cap)
+	{
+		const int new_cap = (t->dirs_cap == 0) ? 16 : t->dirs_cap*2;
+		dir_frame_t *const new_dirs = reallocarray(t->dirs, new_cap,
+				sizeof(*new_dirs));
+		if(new_dirs == NULL)
 		{
-			result = visitor(full_path, VA_FILE, param);
+			close_dir(dir);
+			return 1;
 		}
-		free(full_path);
+		t->dirs = new_dirs;
+		t->dirs_cap = new_cap;
+	}
+
+	result = t->visitor(t->path, VA_DIR_ENTER, t->param);
+	if(result == VR_ERROR)
+	{
+		close_dir(dir);
+		return 1;
+	}
 
-		if(result != 0)
+	dir->path_len = strlen(t->path);
+	dir->report_leave = (result != VR_SKIP_DIR_LEAVE)
+	                 && (result != VR_CANCELLED);
+	t->dirs[t->ndirs++] = *dir;
+	return 0;
+}
+
+/* Puts name into the path buffer at position pos, separating it with a slash
+ * unless pos is zero.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+set_path(traversal_t *t, size_t pos, const char name[])
+{
+	const size_t sep_len = (pos == 0U) ? 0U : 1U;
+	const size_t name_len = strlen(name);
+	const size_t len = pos + sep_len + name_len;
+
+	if(len + 1U > t->path_cap)
+	{
+		const size_t new_cap = (len + 1U)*2U;
+		char *const new_path = realloc(t->path, new_cap);
+		if(new_path == NULL)
 		{
-			break;
+			return 1;
 		}
+		t->path = new_path;
+		t->path_cap = new_cap;
 	}
-	(void)os_closedir(dir);
 
-	if(result == 0 && enter_result != VR_SKIP_DIR_LEAVE &&
-			enter_result != VR_CANCELLED)
+	if(sep_len != 0U)
 	{
-		result = visitor(path, VA_DIR_LEAVE, param);
+		t->path[pos] = '/';
 	}
+	memcpy(t->path + pos + sep_len, name, name_len + 1U);
+	return 0;
+}
 
-	return result;
+/* Checks whether directory entry, which is in the path buffer, is a directory
+ * without resolving symbolic links.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_dir_entry(const traversal_t *t, const dir_frame_t *parent,
+		const dir_batch_entry_t *entry)
+{
+#ifndef _WIN32
+	struct stat st;
+
+	if(entry->type != DT_UNKNOWN)
+	{
+		return entry->type == DT_DIR;
+	}
+
+	return fstatat(parent->fd, entry->name, &st, AT_SYMLINK_NOFOLLOW) == 0
+	    && S_ISDIR(st.st_mode);
+#else
+	return !batch_entry_is_link(t->path, entry)
+	    && batch_entry_is_dir(t->path, entry);
+#endif
+}
+
+/* Opens directory named name inside of the parent or the root directory if
+ * parent is NULL.  The directory is also in the path buffer.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+open_dir(const traversal_t *t, const dir_frame_t *parent, const char name[],
+		dir_frame_t *dir)
+{
+	dir->entries = NULL;
+	dir->count = 0;
+	dir->next = 0;
+
+#ifndef _WIN32
+	if(parent == NULL)
+	{
+		dir->fd = open(t->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	}
+	else
+	{
+		dir->fd = openat(parent->fd, name,
+				O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	}
+	if(dir->fd == -1)
+	{
+		return 1;
+	}
+
+	dir->reader = dir_batch_reader_open_fd(dir->fd, 0U);
+	if(dir->reader == NULL)
+	{
+		(void)close(dir->fd);
+		return 1;
+	}
+#else
+	dir->reader = dir_batch_reader_open(t->path, 0U);
+	if(dir->reader == NULL)
+	{
+		return 1;
+	}
+#endif
+
+	return 0;
+}
+
+/* Frees resources of the directory. */
+static void
+close_dir(dir_frame_t *dir)
+{
+	dir_batch_reader_free(dir->reader);
+#ifndef _WIN32
+	(void)close(dir->fd);
+#endif
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -32,6 +32,7 @@
 #include <time.h> /* tm localtime() strftime() */
 
 #include "../cfg/config.h"
+#include "../cfg/dirsizes.h"
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
 #include "../engine/keys.h"
@@ -42,11 +43,9 @@
 #include "../utils/fs.h"
 #include "../utils/macros.h"
 #include "../utils/str.h"
-#include "../utils/tree.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "../filelist.h"
-#include "../status.h"
 #include "../types.h"
 #include "modes.h"
 
@@ -123,6 +122,7 @@ redraw_file_info_dialog(void)
 	int curr_y;
 	uint64_t size;
 	int size_not_precise;
+	int size_exact;
 
 	assert(view != NULL);
 
@@ -136,11 +136,12 @@ redraw_file_info_dialog(void)
 	entry = &view->dir_entry[view->list_pos];
 
 	size = 0;
+	size_exact = 1;
 	if(entry->type == FT_DIR)
 	{
 		char full_path[PATH_MAX];
 		get_current_full_path(view, sizeof(full_path), full_path);
-		tree_get_data(curr_stats.dirsize_cache, full_path, &size);
+		dirsizes_get(full_path, &size, &size_exact);
 	}
 
 	if(size == 0)
@@ -162,6 +163,10 @@ redraw_file_info_dialog(void)
 		snprintf(size_buf, sizeof(size_buf), " (%" PRId64 " bytes)", size);
 		waddstr(menu_win, size_buf);
 	}
+	if(!size_exact)
+	{
+		waddstr(menu_win, " (estimate)");
+	}
 	curr_y += 2;
 
 	curr_y += show_file_type(view, curr_y);
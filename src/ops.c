@@ -27,15 +27,17 @@
 
 #include <curses.h> /* noraw() raw() */
 
-#include <sys/stat.h> /* gid_t uid_t */
+#include <sys/stat.h> /* S_ISDIR() gid_t stat uid_t */
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* int64_t uint64_t */
 #include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* calloc() free() */
 #include <string.h> /* strdup() */
 
 #include "cfg/config.h"
+#include "cfg/dirsizes.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "io/ioeta.h"
@@ -50,6 +52,7 @@
 #include "utils/str.h"
 #include "utils/utils.h"
 #include "background.h"
+#include "flist_cache.h"
 #include "status.h"
 #include "trash.h"
 #include "undo.h"
@@ -75,6 +78,18 @@ typedef enum
 }
 ConflictAction;
 
+/* Sizes of files affected by an operation measured before performing it. */
+typedef struct
+{
+	uint64_t src_size; /* Size of the source. */
+	int src_exact;     /* Whether src_size is precise. */
+	int src_is_dir;    /* Whether source is a directory. */
+	uint64_t dst_size; /* Size of the destination. */
+	int dst_exact;     /* Whether dst_size is precise. */
+	int dst_is_dir;    /* Whether destination is an existing directory. */
+}
+op_sizes_t;
+
 /* Type of function that implements single operation. */
 typedef int (*op_func)(ops_t *ops, void *data, const char *src, const char *dst);
 
@@ -106,6 +121,15 @@ static int op_symlink(ops_t *ops, void *data, const char *src, const char *dst);
 static int op_mkdir(ops_t *ops, void *data, const char *src, const char *dst);
 static int op_rmdir(ops_t *ops, void *data, const char *src, const char *dst);
 static int op_mkfile(ops_t *ops, void *data, const char *src, const char *dst);
+static void measure_op_sizes(OPS op, const char src[], const char dst[],
+		op_sizes_t *sizes);
+static void update_dir_sizes(OPS op, const char src[], const char dst[],
+		const op_sizes_t *sizes, int succeeded);
+static int op_removes_src(OPS op);
+static int op_copies_src(OPS op);
+static int op_writes_dst(OPS op);
+static uint64_t get_item_size(const char path[], int *exact, int *is_dir);
+static int get_parent_dir(const char path[], char buf[], size_t buf_len);
 static int exec_io_op(ops_t *ops, int (*func)(io_args_t *const),
 		io_args_t *const args);
 static int confirm_overwrite(io_args_t *args, const char src[],
@@ -247,7 +271,236 @@ int
 perform_operation(OPS op, ops_t *ops, void *data, const char src[],
 		const char dst[])
 {
-	return op_funcs[op](ops, data, src, dst);
+	op_sizes_t sizes;
+	int result;
+
+	/* Cached lists can't be validated for changes of meta-data of files, so drop
+	 * all lists that might get outdated. */
+	if(src != NULL)
+	{
+		flist_cache_invalidate(src);
+	}
+	if(dst != NULL)
+	{
+		flist_cache_invalidate(dst);
+	}
+
+	measure_op_sizes(op, src, dst, &sizes);
+	result = op_funcs[op](ops, data, src, dst);
+	if(result != SKIP_UNDO_REDO_OPERATION)
+	{
+		update_dir_sizes(op, src, dst, &sizes, result == 0);
+	}
+	return result;
+}
+
+/* Collects sizes of files that are going to be affected by the operation. */
+static void
+measure_op_sizes(OPS op, const char src[], const char dst[], op_sizes_t *sizes)
+{
+	sizes->src_size = 0U;
+	sizes->src_exact = 1;
+	sizes->src_is_dir = 0;
+	sizes->dst_size = 0U;
+	sizes->dst_exact = 1;
+	sizes->dst_is_dir = 0;
+
+	if(src != NULL && (op_removes_src(op) || op_copies_src(op)))
+	{
+		sizes->src_size = get_item_size(src, &sizes->src_exact,
+				&sizes->src_is_dir);
+	}
+	if(dst != NULL && op_writes_dst(op))
+	{
+		sizes->dst_size = get_item_size(dst, &sizes->dst_exact,
+				&sizes->dst_is_dir);
+	}
+}
+
+/* Applies changes in sizes of files made by the operation to cached sizes of
+ * directories that contain them, so that they don't need to be recalculated. */
+static void
+update_dir_sizes(OPS op, const char src[], const char dst[],
+		const op_sizes_t *sizes, int succeeded)
+{
+	char src_dir[PATH_MAX];
+	char dst_dir[PATH_MAX];
+	const int removes = src != NULL && op_removes_src(op)
+	                 && get_parent_dir(src, src_dir, sizeof(src_dir)) == 0;
+	const int writes = dst != NULL && op_writes_dst(op)
+	                && get_parent_dir(dst, dst_dir, sizeof(dst_dir)) == 0;
+
+	if(!succeeded)
+	{
+		/* The operation might have been done partially. */
+		if(removes)
+		{
+			dirsizes_update(src_dir, 0, 0, NULL);
+		}
+		if(writes)
+		{
+			dirsizes_update(dst_dir, 0, 0, NULL);
+		}
+		return;
+	}
+
+	if(writes)
+	{
+		uint64_t new_size = sizes->src_size;
+		int new_exact = sizes->src_exact;
+
+		if(!op_copies_src(op))
+		{
+			int dst_is_dir;
+			new_size = get_item_size(dst, &new_exact, &dst_is_dir);
+		}
+		else if(cfg.disk_usage && !op_removes_src(op))
+		{
+			/* Copy can occupy different amount of space than the original. */
+			new_exact = 0;
+		}
+
+		if(sizes->dst_is_dir)
+		{
+			/* Directories are merged and we can't know how much they overlap. */
+			new_exact = 0;
+		}
+		else if(sizes->dst_size != 0U || !sizes->dst_exact)
+		{
+			dirsizes_update(dst_dir, -(int64_t)sizes->dst_size, sizes->dst_exact,
+					NULL);
+		}
+
+		/* Parts of the tree that contain both source and destination are updated
+		 * below. */
+		dirsizes_update(dst_dir, new_size, new_exact, removes ? src_dir : NULL);
+
+		/* New directory is a copy of the source one. */
+		if(sizes->src_is_dir && new_exact)
+		{
+			dirsizes_set(dst, new_size, 1, NULL);
+		}
+	}
+
+	if(removes)
+	{
+		dirsizes_update(src_dir, -(int64_t)sizes->src_size, sizes->src_exact,
+				writes ? dst_dir : NULL);
+	}
+}
+
+/* Checks whether operation removes its source.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+op_removes_src(OPS op)
+{
+	switch(op)
+	{
+		case OP_REMOVE:
+		case OP_REMOVESL:
+		case OP_MOVE:
+		case OP_MOVEF:
+		case OP_MOVEA:
+		case OP_MOVETMP1:
+		case OP_MOVETMP2:
+		case OP_MOVETMP3:
+		case OP_MOVETMP4:
+		case OP_RMDIR:
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/* Checks whether operation makes its destination a copy of its source.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+op_copies_src(OPS op)
+{
+	switch(op)
+	{
+		case OP_COPY:
+		case OP_COPYF:
+		case OP_COPYA:
+		case OP_MOVE:
+		case OP_MOVEF:
+		case OP_MOVEA:
+		case OP_MOVETMP1:
+		case OP_MOVETMP2:
+		case OP_MOVETMP3:
+		case OP_MOVETMP4:
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/* Checks whether operation creates or replaces its destination.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+op_writes_dst(OPS op)
+{
+	return op_copies_src(op) || op == OP_SYMLINK || op == OP_SYMLINK2;
+}
+
+/* Determines size of a file or a directory, which is zero if it doesn't exist.
+ * *exact is set to zero if size of a directory isn't known precisely or if
+ * space taken by a hard-linked file might be still in use.  Returns the
+ * size. */
+static uint64_t
+get_item_size(const char path[], int *exact, int *is_dir)
+{
+	struct stat st;
+	uint64_t size;
+
+	*exact = 1;
+	*is_dir = 0;
+
+	if(os_lstat(path, &st) != 0)
+	{
+		return 0U;
+	}
+
+	if(!S_ISDIR(st.st_mode))
+	{
+#ifndef _WIN32
+		if(cfg.disk_usage)
+		{
+			*exact = (st.st_nlink <= 1);
+			return (uint64_t)st.st_blocks*512U;
+		}
+#endif
+		return st.st_size;
+	}
+
+	*is_dir = 1;
+	if(dirsizes_get(path, &size, exact) != 0)
+	{
+		*exact = 0;
+		return 0U;
+	}
+	return size;
+}
+
+/* Gets path of directory that contains the path.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+get_parent_dir(const char path[], char buf[], size_t buf_len)
+{
+	if(strchr(path, '/') == NULL || is_root_dir(path))
+	{
+		return 1;
+	}
+
+	copy_str(buf, buf_len, path);
+	remove_last_path_component(buf);
+	if(buf[0] == '\0')
+	{
+		copy_str(buf, buf_len, "/");
+	}
+	return 0;
 }
 
 static int
@@ -443,6 +696,7 @@ op_cp(ops_t *ops, void *data, const char src[], const char dst[],
 		.arg3.crs = ca_to_crs(conflict_action),
 
 		.cancellable = data == NULL,
+		.max_jobs = cfg.copy_jobs,
 	};
 	return exec_io_op(ops, &ior_cp, &args);
 }
@@ -543,6 +797,7 @@ op_mv(ops_t *ops, void *data, const char src[], const char dst[],
 			.arg3.crs = ca_to_crs(conflict_action),
 
 			.cancellable = data == NULL,
+			.max_jobs = cfg.copy_jobs,
 		};
 		result = exec_io_op(ops, &ior_mv, &args);
 	}
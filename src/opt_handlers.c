@@ -30,6 +30,7 @@
                        strstr() */
 
 #include "cfg/config.h"
+#include "cfg/dirsizes.h"
 #include "engine/options.h"
 #include "engine/text_buffer.h"
 #include "modes/view.h"
@@ -44,6 +45,8 @@
 #include "utils/string_array.h"
 #include "utils/utils.h"
 #include "filelist.h"
+#include "flist_cache.h"
+#include "flist_prefetch.h"
 #include "search.h"
 #include "sort.h"
 #include "status.h"
@@ -95,6 +98,7 @@ static void add_options(void);
 static void load_sort_option_inner(FileView *view, char sort_keys[]);
 static void aproposprg_handler(OPT_OP op, optval_t val);
 static void autochpos_handler(OPT_OP op, optval_t val);
+static void calcdirsizes_handler(OPT_OP op, optval_t val);
 static void cdpath_handler(OPT_OP op, optval_t val);
 static void chaselinks_handler(OPT_OP op, optval_t val);
 static void classify_handler(OPT_OP op, optval_t val);
@@ -103,7 +107,9 @@ static const char * pick_out_decoration(const char classify_item[],
 		FileType *type);
 static void columns_handler(OPT_OP op, optval_t val);
 static void confirm_handler(OPT_OP op, optval_t val);
+static void copyjobs_handler(OPT_OP op, optval_t val);
 static void cpoptions_handler(OPT_OP op, optval_t val);
+static void diskusage_handler(OPT_OP op, optval_t val);
 static void dotdirs_handler(OPT_OP op, optval_t val);
 static void fastrun_handler(OPT_OP op, optval_t val);
 static void fillchars_handler(OPT_OP op, optval_t val);
@@ -122,8 +128,10 @@ static int parse_range(const char range[], int *from, int *to);
 static int parse_endpoint(const char **str, int *endpoint);
 static void laststatus_handler(OPT_OP op, optval_t val);
 static void lines_handler(OPT_OP op, optval_t val);
+static void listcache_handler(OPT_OP op, optval_t val);
 static void locateprg_handler(OPT_OP op, optval_t val);
 static void mintimeoutlen_handler(OPT_OP op, optval_t val);
+static void prefetch_handler(OPT_OP op, optval_t val);
 static void scroll_line_down(FileView *view);
 static void rulerformat_handler(OPT_OP op, optval_t val);
 static void runexec_handler(OPT_OP op, optval_t val);
@@ -168,6 +176,7 @@ static void timefmt_handler(OPT_OP op, optval_t val);
 static void timeoutlen_handler(OPT_OP op, optval_t val);
 static void trash_handler(OPT_OP op, optval_t val);
 static void trashdir_handler(OPT_OP op, optval_t val);
+static void trustnotify_handler(OPT_OP op, optval_t val);
 static void tuioptions_handler(OPT_OP op, optval_t val);
 static void undolevels_handler(OPT_OP op, optval_t val);
 static void vicmd_handler(OPT_OP op, optval_t val);
@@ -278,6 +287,7 @@ static const char *vifminfo_set[] = {
 	"registers",
 	"phistory",
 	"fhistory",
+	"dirsizes",
 };
 
 /* Empty value to satisfy default initializer. */
@@ -306,6 +316,10 @@ options[] = {
 	  OPT_BOOL, 0, NULL, &autochpos_handler, NULL,
 	  { .ref.bool_val = &cfg.auto_ch_pos },
 	},
+	{ "calcdirsizes", "",
+	  OPT_BOOL, 0, NULL, &calcdirsizes_handler, NULL,
+	  { .ref.bool_val = &cfg.calc_dir_sizes },
+	},
 	{ "cdpath", "cd",
 	  OPT_STRLIST, 0, NULL, &cdpath_handler, NULL,
 	  { .ref.str_val = &cfg.cd_path },
@@ -326,10 +340,18 @@ options[] = {
 	  OPT_BOOL, 0, NULL, &confirm_handler, NULL,
 	  { .ref.bool_val = &cfg.confirm },
 	},
+	{ "copyjobs", "",
+	  OPT_INT, 0, NULL, &copyjobs_handler, NULL,
+	  { .ref.int_val = &cfg.copy_jobs },
+	},
 	{ "cpoptions", "cpo",
 	  OPT_CHARSET, cpoptions_count, &cpoptions_vals, &cpoptions_handler, NULL,
 	  { .init = &init_cpoptions },
 	},
+	{ "diskusage", "",
+	  OPT_BOOL, 0, NULL, &diskusage_handler, NULL,
+	  { .ref.bool_val = &cfg.disk_usage },
+	},
 	{ "dotdirs", "",
 	  OPT_SET, ARRAY_LEN(dotdirs_vals), dotdirs_vals, &dotdirs_handler, NULL,
 	  { .ref.set_items = &cfg.dot_dirs },
@@ -391,6 +413,10 @@ options[] = {
 	  OPT_INT, 0, NULL, &lines_handler, NULL,
 	  { .ref.int_val = &cfg.lines },
 	},
+	{ "listcache", "",
+	  OPT_INT, 0, NULL, &listcache_handler, NULL,
+	  { .ref.int_val = &cfg.list_cache_size },
+	},
 	{ "locateprg", "",
 	  OPT_STR, 0, NULL, &locateprg_handler, NULL,
 	  { .ref.str_val = &cfg.locate_prg },
@@ -399,6 +425,10 @@ options[] = {
 	  OPT_INT, 0, NULL, &mintimeoutlen_handler, NULL,
 	  { .ref.int_val = &cfg.min_timeout_len },
 	},
+	{ "prefetch", "",
+	  OPT_BOOL, 0, NULL, &prefetch_handler, NULL,
+	  { .ref.bool_val = &cfg.prefetch_dirs },
+	},
 	{ "rulerformat", "ruf",
 	  OPT_STR, 0, NULL, &rulerformat_handler, NULL,
 	  { .ref.str_val = &cfg.ruler_format },
@@ -465,6 +495,10 @@ options[] = {
 	  OPT_STRLIST, 0, NULL, &trashdir_handler, NULL,
 	  { .init = &init_trash_dir },
 	},
+	{ "trustnotify", "",
+	  OPT_BOOL, 0, NULL, &trustnotify_handler, NULL,
+	  { .ref.bool_val = &cfg.trust_notify },
+	},
 	{ "tuioptions", "to",
 	  OPT_CHARSET, tuioptions_count, &tuioptions_vals, &tuioptions_handler, NULL,
 	  { .init = &init_tuioptions },
@@ -954,6 +988,14 @@ autochpos_handler(OPT_OP op, optval_t val)
 	}
 }
 
+/* Makes sorting by size calculate sizes of directories that aren't known
+ * yet. */
+static void
+calcdirsizes_handler(OPT_OP op, optval_t val)
+{
+	cfg.calc_dir_sizes = val.bool_val;
+}
+
 /* Specifies directories to check on cding by relative path. */
 static void
 cdpath_handler(OPT_OP op, optval_t val)
@@ -1112,6 +1154,22 @@ confirm_handler(OPT_OP op, optval_t val)
 	cfg.confirm = val.bool_val;
 }
 
+/* Checks and applies limit on number of files copied in parallel. */
+static void
+copyjobs_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 1)
+	{
+		vle_tb_append_linef(vle_err, "Invalid number of copy jobs: %d",
+				val.int_val);
+		error = 1;
+		reset_option_to_default("copyjobs", OPT_GLOBAL);
+		return;
+	}
+
+	cfg.copy_jobs = val.int_val;
+}
+
 /* Parses set of compatibility flags and changes configuration accordingly. */
 static void
 cpoptions_handler(OPT_OP op, optval_t val)
@@ -1147,6 +1205,23 @@ cpoptions_handler(OPT_OP op, optval_t val)
 	}
 }
 
+/* Switches between apparent sizes of directories and space they occupy on
+ * disk.  Sizes of the two kinds are cached separately. */
+static void
+diskusage_handler(OPT_OP op, optval_t val)
+{
+	if(cfg.disk_usage == val.bool_val)
+	{
+		return;
+	}
+
+	dirsizes_write();
+	cfg.disk_usage = val.bool_val;
+	(void)dirsizes_reset();
+
+	update_screen(UT_FULL);
+}
+
 static void
 dotdirs_handler(OPT_OP op, optval_t val)
 {
@@ -1404,6 +1479,23 @@ lines_handler(OPT_OP op, optval_t val)
 	set_option("lines", val, OPT_GLOBAL);
 }
 
+/* Sets size limit of cache of file lists dropping lists that don't fit into it
+ * anymore. */
+static void
+listcache_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be >= 0: %d", val.int_val);
+		error = 1;
+		reset_option_to_default("listcache", OPT_GLOBAL);
+		return;
+	}
+
+	cfg.list_cache_size = val.int_val;
+	flist_cache_trim();
+}
+
 static void
 locateprg_handler(OPT_OP op, optval_t val)
 {
@@ -1426,6 +1518,17 @@ mintimeoutlen_handler(OPT_OP op, optval_t val)
 	cfg.min_timeout_len = val.int_val;
 }
 
+/* Enables or disables reading of directory under cursor in background. */
+static void
+prefetch_handler(OPT_OP op, optval_t val)
+{
+	cfg.prefetch_dirs = val.bool_val;
+	if(!cfg.prefetch_dirs)
+	{
+		flist_prefetch_cancel();
+	}
+}
+
 static void
 scroll_line_down(FileView *view)
 {
@@ -1981,6 +2084,14 @@ trashdir_handler(OPT_OP op, optval_t val)
 	free(expanded_path);
 }
 
+/* Makes reloading of file lists rely on notifications about changes of files
+ * instead of querying meta-data of every file. */
+static void
+trustnotify_handler(OPT_OP op, optval_t val)
+{
+	cfg.trust_notify = val.bool_val;
+}
+
 /* Parses set of TUI flags and changes appearance configuration accordingly. */
 static void
 tuioptions_handler(OPT_OP op, optval_t val)
@@ -21,42 +21,86 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() qsort() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* abs() free() qsort() */
+#include <string.h> /* memcpy() strcmp() strlen() strrchr() */
 
 #include "cfg/config.h"
+#include "cfg/dirsizes.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
+#include "modes/dialogs/msg_dialog.h"
 #include "ui/ui.h"
+#include "utils/dynarray.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/test_helpers.h"
-#include "utils/tree.h"
 #include "utils/utils.h"
+#include "fileops.h"
 #include "filelist.h"
-#include "status.h"
 #include "types.h"
 
+/* Minimal number of entries per thread for sorting to be done by several
+ * threads. */
+#define SORT_CHUNK 16384
+
 /* View which is being sorted. */
 static FileView* view;
 /* Whether the view displays custom file list. */
 static int custom_view;
-static int sort_descending;
-/* Key used to sort entries in current sorting round. */
-static SortingKey sort_type;
-
-static void sort_by_key(char key);
+/* Sorting keys in order of decreasing priority (negative values mean
+ * descending order). */
+static signed char sort_keys[SK_COUNT + 1];
+/* Number of elements in sort_keys array. */
+static int nsort_keys;
+
+/* Data of an entry that is computed once before sorting instead of on every
+ * comparison. */
+typedef struct
+{
+	int name;   /* Offset of name to compare in the pool (short path for custom
+	               views) or -1 to use name of the entry. */
+	int lower;  /* Offset of case-folded name in the pool or -1 if case isn't
+	               ignored. */
+	int ext;    /* Offset of the last dot in name of the entry or -1. */
+	int is_dir; /* Whether entry is a directory. */
+	uint64_t size; /* Size of the entry (from the cache for directories). */
+}
+sort_data_t;
+
+/* Sorting data of entries indexed by their list_num. */
+static sort_data_t *sort_data;
+/* Storage of strings referenced by sort_data. */
+static char *sort_pool;
+
+static void setup_sorting(FileView *v);
+static void calc_dir_sizes(void);
+static int has_sort_key(SortingKey key);
+static int prepare_sort_data(void);
+static int fill_sort_data(const dir_entry_t *entry, sort_data_t *data,
+		size_t *pool_len);
+static int add_to_pool(size_t *len, const char str[]);
 static int sort_dir_list(const void *one, const void *two);
+static int compare_entries(dir_entry_t *first, dir_entry_t *second,
+		const sort_data_t *first_data, const sort_data_t *second_data);
+static int compare_by_key(dir_entry_t *first, dir_entry_t *second,
+		const sort_data_t *first_data, const sort_data_t *second_data,
+		SortingKey sort_type);
+static const char * get_sort_name(const dir_entry_t *entry,
+		const sort_data_t *data);
+static const char * get_sort_lower(const sort_data_t *data);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
 static int vercmp(const char s[], const char t[]);
 #else
 static char * skip_leading_zeros(const char str[]);
 #endif
-static int compare_entry_names(const dir_entry_t *a, const dir_entry_t *b,
-		int ignore_case);
-static int compare_full_file_names(const char s[], const char t[],
-		int ignore_case);
-static int compare_file_names(const char s[], const char t[], int ignore_case);
+static int compare_full_file_names(const char s[], const char s_lower[],
+		const char t[], const char t_lower[]);
+static int compare_file_names(const char s[], const char s_lower[],
+		const char t[], const char t_lower[]);
 
 void
 sort_view(FileView *v)
@@ -69,43 +113,257 @@ sort_view(FileView *v)
 		return;
 	}
 
+	setup_sorting(v);
+
+	/* Sorting is performed in a single pass by comparing entries by all keys at
+	 * once, list_num makes it stable. */
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		view->dir_entry[i].list_num = i;
+	}
+
+	if(cfg.calc_dir_sizes && has_sort_key(SK_BY_SIZE))
+	{
+		calc_dir_sizes();
+	}
+
+	if(prepare_sort_data() != 0)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+	}
+	else
+	{
+		parallel_sort(view->dir_entry, view->list_rows, sizeof(dir_entry_t),
+				&sort_dir_list, SORT_CHUNK);
+	}
+
+	free(sort_data);
+	sort_data = NULL;
+	dynarray_free(sort_pool);
+	sort_pool = NULL;
+}
+
+int
+sort_find_insert_pos(FileView *v, dir_entry_t entries[], int count,
+		const dir_entry_t *entry)
+{
+	sort_data_t entry_data, probe_data;
+	size_t pool_len = 0U;
+	size_t entry_pool_len;
+	int lo, hi;
+
+	if(v->sort[0] > SK_LAST)
+	{
+		/* Unsorted list, so the order is the order of addition. */
+		return count;
+	}
+
+	setup_sorting(v);
+
+	lo = 0;
+	hi = count;
+	if(fill_sort_data(entry, &entry_data, &pool_len) == 0)
+	{
+		entry_pool_len = pool_len;
+
+		/* Find the first entry that is greater than the new one. */
+		while(lo < hi)
+		{
+			const int mid = lo + (hi - lo)/2;
+			dir_entry_t *const probe = &entries[mid];
+
+			pool_len = entry_pool_len;
+			if(fill_sort_data(probe, &probe_data, &pool_len) != 0)
+			{
+				lo = count;
+				break;
+			}
+
+			if(compare_entries(probe, (dir_entry_t *)entry, &probe_data,
+						&entry_data) <= 0)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+	}
+	else
+	{
+		lo = count;
+	}
+
+	dynarray_free(sort_pool);
+	sort_pool = NULL;
+	return lo;
+}
+
+/* Initializes state of the unit for sorting or searching in the view. */
+static void
+setup_sorting(FileView *v)
+{
+	int i;
+
 	view = v;
 	custom_view = flist_custom_active(v);
 
-	i = SK_COUNT;
-	while(--i >= 0)
+	/* Directories always go first unless user specified their position
+	 * explicitly. */
+	nsort_keys = 0;
+	if(!ui_view_sort_list_contains(v->sort, SK_BY_DIR))
+	{
+		sort_keys[nsort_keys++] = SK_BY_DIR;
+	}
+	for(i = 0; i < SK_COUNT; ++i)
 	{
-		const char sorting_key = view->sort[i];
+		if(abs(v->sort[i]) <= SK_LAST)
+		{
+			sort_keys[nsort_keys++] = v->sort[i];
+		}
+	}
+}
 
-		if(abs(sorting_key) > SK_LAST)
+/* Calculates sizes of directories of the view unless they are known already.
+ * Directories are processed one by one as calculation of each of them is
+ * already spread over several threads. */
+static void
+calc_dir_sizes(void)
+{
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		const dir_entry_t *const entry = &view->dir_entry[i];
+		char full_path[PATH_MAX];
+		uint64_t size;
+
+		if(is_parent_dir(entry->name) || !is_directory_entry(entry))
 		{
 			continue;
 		}
 
-		sort_by_key(sorting_key);
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		if(dirsizes_get(full_path, &size, NULL) != 0)
+		{
+			(void)calculate_dir_size(full_path, 0);
+		}
 	}
+}
 
-	if(!ui_view_sort_list_contains(v->sort, SK_BY_DIR))
+/* Checks whether key is among current sorting keys (in any direction).
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+has_sort_key(SortingKey key)
+{
+	int i;
+	for(i = 0; i < nsort_keys; ++i)
 	{
-		sort_by_key(SK_BY_DIR);
+		if(abs(sort_keys[i]) == (int)key)
+		{
+			return 1;
+		}
 	}
+	return 0;
 }
 
-/* Sorts view by the key in a stable way. */
-static void
-sort_by_key(char key)
+/* Computes data of all entries of the view that is needed by comparisons, so
+ * that comparer doesn't need to build paths, fold case or query file system.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+prepare_sort_data(void)
 {
-	int j;
+	size_t pool_len = 0U;
+	int i;
 
-	sort_descending = (key < 0);
-	sort_type = (SortingKey)abs(key);
+	sort_data = reallocarray(NULL, view->list_rows, sizeof(*sort_data));
+	if(sort_data == NULL && view->list_rows != 0)
+	{
+		return 1;
+	}
 
-	for(j = 0; j < view->list_rows; j++)
+	for(i = 0; i < view->list_rows; ++i)
 	{
-		view->dir_entry[j].list_num = j;
+		if(fill_sort_data(&view->dir_entry[i], &sort_data[i], &pool_len) != 0)
+		{
+			return 1;
+		}
 	}
 
-	qsort(view->dir_entry, view->list_rows, sizeof(dir_entry_t), sort_dir_list);
+	return 0;
+}
+
+/* Computes comparison data of a single entry appending strings to the pool,
+ * which is *pool_len bytes long.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+fill_sort_data(const dir_entry_t *entry, sort_data_t *data, size_t *pool_len)
+{
+	const int ignore_case = has_sort_key(SK_BY_INAME);
+	const int short_paths = custom_view &&
+		(ignore_case || has_sort_key(SK_BY_NAME));
+	const char *const dot = strrchr(entry->name, '.');
+	char short_path[PATH_MAX];
+	const char *name = entry->name;
+
+	data->is_dir = is_directory_entry(entry);
+	data->ext = (dot == NULL) ? -1 : (int)(dot - entry->name);
+	data->name = -1;
+	data->lower = -1;
+	data->size = entry->size;
+
+	if(data->is_dir && has_sort_key(SK_BY_SIZE))
+	{
+		char full_path[PATH_MAX];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		dirsizes_get(full_path, &data->size, NULL);
+	}
+
+	if(short_paths)
+	{
+		get_short_path_of(view, entry, 0, sizeof(short_path), short_path);
+		name = short_path;
+
+		data->name = (int)*pool_len;
+		if(add_to_pool(pool_len, name) != 0)
+		{
+			return 1;
+		}
+	}
+
+	if(ignore_case)
+	{
+		/* Ignore too small buffer errors by not caring about part that didn't
+		 * fit. */
+		char lower[NAME_MAX];
+		(void)str_to_lower(name, lower, sizeof(lower));
+
+		data->lower = (int)*pool_len;
+		if(add_to_pool(pool_len, lower) != 0)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Appends string to sort_pool.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+add_to_pool(size_t *len, const char str[])
+{
+	const size_t str_len = strlen(str) + 1U;
+	char *const pool = dynarray_extend(sort_pool, str_len);
+	if(pool == NULL)
+	{
+		return 1;
+	}
+
+	memcpy(pool + *len, str, str_len);
+	sort_pool = pool;
+	*len += str_len;
+	return 0;
 }
 
 /* Compares file names containing numbers correctly. */
@@ -169,15 +427,27 @@ skip_leading_zeros(const char str[])
 }
 #endif
 
+/* qsort() comparer that compares entries by all sorting keys.  Returns
+ * positive value if one is greater than two, zero if they are equal, otherwise
+ * negative value is returned. */
 static int
 sort_dir_list(const void *one, const void *two)
 {
-	int retval;
-	char *pfirst, *psecond;
 	dir_entry_t *const first = (dir_entry_t *)one;
 	dir_entry_t *const second = (dir_entry_t *)two;
-	int first_is_dir;
-	int second_is_dir;
+	const int result = compare_entries(first, second,
+			&sort_data[first->list_num], &sort_data[second->list_num]);
+	return (result != 0) ? result : first->list_num - second->list_num;
+}
+
+/* Compares entries by all sorting keys.  Returns positive value if first is
+ * greater than second, zero if they are equal, otherwise negative value is
+ * returned. */
+static int
+compare_entries(dir_entry_t *first, dir_entry_t *second,
+		const sort_data_t *first_data, const sort_data_t *second_data)
+{
+	int i;
 
 	if(is_parent_dir(first->name))
 	{
@@ -188,23 +458,45 @@ sort_dir_list(const void *one, const void *two)
 		return 1;
 	}
 
-	first_is_dir = is_directory_entry(first);
-	second_is_dir = is_directory_entry(second);
+	for(i = 0; i < nsort_keys; ++i)
+	{
+		const int key = sort_keys[i];
+		const int retval = compare_by_key(first, second, first_data, second_data,
+				(SortingKey)abs(key));
+		if(retval != 0)
+		{
+			return (key < 0) ? -retval : retval;
+		}
+	}
+
+	return 0;
+}
+
+/* Compares two entries by a single sorting key.  Returns positive value if
+ * first is greater than second, zero if they are equal, otherwise negative
+ * value is returned. */
+static int
+compare_by_key(dir_entry_t *first, dir_entry_t *second,
+		const sort_data_t *first_data, const sort_data_t *second_data,
+		SortingKey sort_type)
+{
+	const int first_is_dir = first_data->is_dir;
+	const int second_is_dir = second_data->is_dir;
+	int retval;
+	const char *pfirst, *psecond;
 
 	retval = 0;
 	switch(sort_type)
 	{
 		case SK_BY_NAME:
+			retval = compare_full_file_names(get_sort_name(first, first_data), NULL,
+					get_sort_name(second, second_data), NULL);
+			break;
+
 		case SK_BY_INAME:
-			if(custom_view)
-			{
-				retval = compare_entry_names(first, second, sort_type == SK_BY_INAME);
-			}
-			else
-			{
-				retval = compare_full_file_names(first->name, second->name,
-						sort_type == SK_BY_INAME);
-			}
+			retval = compare_full_file_names(get_sort_name(first, first_data),
+					get_sort_lower(first_data), get_sort_name(second, second_data),
+					get_sort_lower(second_data));
 			break;
 
 		case SK_BY_DIR:
@@ -220,12 +512,12 @@ sort_dir_list(const void *one, const void *two)
 
 		case SK_BY_FILEEXT:
 		case SK_BY_EXTENSION:
-			pfirst = strrchr(first->name,  '.');
-			psecond = strrchr(second->name, '.');
+			pfirst = (first_data->ext < 0) ? NULL : first->name + first_data->ext;
+			psecond = (second_data->ext < 0) ? NULL : second->name + second_data->ext;
 
 			if(first_is_dir && second_is_dir && sort_type == SK_BY_FILEEXT)
 			{
-				retval = compare_file_names(first->name, second->name, 0);
+				retval = compare_file_names(first->name, NULL, second->name, NULL);
 			}
 			else if(first_is_dir != second_is_dir && sort_type == SK_BY_FILEEXT)
 			{
@@ -243,35 +535,19 @@ sort_dir_list(const void *one, const void *two)
 				}
 				else
 				{
-					retval = compare_file_names(++pfirst, ++psecond, 0);
+					retval = compare_file_names(pfirst + 1, NULL, psecond + 1, NULL);
 				}
 			}
 			else if(pfirst || psecond)
 				retval = pfirst ? -1 : 1;
 			else
-				retval = compare_file_names(first->name, second->name, 0);
+				retval = compare_file_names(first->name, NULL, second->name, NULL);
 			break;
 
 		case SK_BY_SIZE:
-			{
-				if(first_is_dir)
-				{
-					char full_path[PATH_MAX];
-					get_full_path_of(first, sizeof(full_path), full_path);
-					tree_get_data(curr_stats.dirsize_cache, full_path, &first->size);
-				}
-
-				if(second_is_dir)
-				{
-					char full_path[PATH_MAX];
-					get_full_path_of(second, sizeof(full_path), full_path);
-					tree_get_data(curr_stats.dirsize_cache, full_path, &second->size);
-				}
-
-				retval = (first->size < second->size)
-				       ? -1
-				       : (first->size > second->size);
-			}
+			retval = (first_data->size < second_data->size)
+			       ? -1
+			       : (first_data->size > second_data->size);
 			break;
 
 		case SK_BY_TIME_MODIFIED:
@@ -311,37 +587,105 @@ sort_dir_list(const void *one, const void *two)
 #endif
 	}
 
-	if(retval == 0)
+	return retval;
+}
+
+/* Retrieves name of the entry that is used for comparison.  Returns the
+ * name. */
+static const char *
+get_sort_name(const dir_entry_t *entry, const sort_data_t *data)
+{
+	return (data->name < 0) ? entry->name : &sort_pool[data->name];
+}
+
+/* Retrieves case-folded name of the entry.  Returns the name or NULL if it
+ * wasn't computed. */
+static const char *
+get_sort_lower(const sort_data_t *data)
+{
+	return (data->lower < 0) ? NULL : &sort_pool[data->lower];
+}
+
+int
+sort_is_affected(const FileView *view, const dir_entry_t *was,
+		const dir_entry_t *now)
+{
+	int i;
+
+	/* Type determines whether entry is a directory, which is always a sorting
+	 * key.  Same for mode of symbolic links, which refers to their targets. */
+	if(was->type != now->type)
 	{
-		retval = first->list_num - second->list_num;
+		return 1;
 	}
-	else if(sort_descending)
+#ifndef _WIN32
+	if(now->type == FT_LINK && was->mode != now->mode)
 	{
-		retval = -retval;
+		return 1;
 	}
+#endif
 
-	return retval;
-}
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		int changed = 0;
 
-/* Compares names of two file entries.  Returns positive value if a is greater
- * than b, zero if they are equal, otherwise negative value is returned. */
-static int
-compare_entry_names(const dir_entry_t *a, const dir_entry_t *b, int ignore_case)
-{
-	char a_short_path[PATH_MAX];
-	char b_short_path[PATH_MAX];
+		if(abs(view->sort[i]) > SK_LAST)
+		{
+			continue;
+		}
+
+		switch((SortingKey)abs(view->sort[i]))
+		{
+			case SK_BY_SIZE:
+				/* Size of directories comes from the cache, not from the entry. */
+				changed = was->size != now->size || now->type == FT_DIR ||
+				          now->type == FT_LINK;
+				break;
+			case SK_BY_TIME_MODIFIED:
+				changed = was->mtime != now->mtime;
+				break;
+			case SK_BY_TIME_ACCESSED:
+				changed = was->atime != now->atime;
+				break;
+			case SK_BY_TIME_CHANGED:
+				changed = was->ctime != now->ctime;
+				break;
+#ifndef _WIN32
+			case SK_BY_MODE:
+			case SK_BY_PERMISSIONS:
+				changed = was->mode != now->mode;
+				break;
+			case SK_BY_OWNER_NAME:
+			case SK_BY_OWNER_ID:
+				changed = was->uid != now->uid;
+				break;
+			case SK_BY_GROUP_NAME:
+			case SK_BY_GROUP_ID:
+				changed = was->gid != now->gid;
+				break;
+#endif
+
+			default:
+				/* The rest of keys depend only on name and type. */
+				break;
+		}
 
-	get_short_path_of(view, a, 0, sizeof(a_short_path), a_short_path);
-	get_short_path_of(view, b, 0, sizeof(b_short_path), b_short_path);
+		if(changed)
+		{
+			return 1;
+		}
+	}
 
-	return compare_full_file_names(a_short_path, b_short_path, ignore_case);
+	return 0;
 }
 
 /* Compares two full filenames and assumes that dot character is smaller than
- * any other character.  Returns positive value if s is greater than t, zero if
- * they are equal, otherwise negative value is returned. */
+ * any other character.  Case-folded versions of names are used when they are
+ * not NULL.  Returns positive value if s is greater than t, zero if they are
+ * equal, otherwise negative value is returned. */
 static int
-compare_full_file_names(const char s[], const char t[], int ignore_case)
+compare_full_file_names(const char s[], const char s_lower[], const char t[],
+		const char t_lower[])
 {
 	if(s[0] == '.' && t[0] != '.')
 	{
@@ -353,32 +697,23 @@ compare_full_file_names(const char s[], const char t[], int ignore_case)
 	}
 	else
 	{
-		return compare_file_names(s, t, ignore_case);
+		return compare_file_names(s, s_lower, t, t_lower);
 	}
 }
 
-/* Compares two file names or their parts (e.g. extensions).  Returns positive
+/* Compares two file names or their parts (e.g. extensions).  Case-folded
+ * versions of names are compared first if they are not NULL.  Returns positive
  * value if s is greater than t, zero if they are equal, otherwise negative
  * value is returned. */
 static int
-compare_file_names(const char s[], const char t[], int ignore_case)
+compare_file_names(const char s[], const char s_lower[], const char t[],
+		const char t_lower[])
 {
-	const char *s_val = s, *t_val = t;
-	char s_buf[NAME_MAX];
-	char t_buf[NAME_MAX];
+	const int ignore_case = (s_lower != NULL && t_lower != NULL);
+	const char *const s_val = ignore_case ? s_lower : s;
+	const char *const t_val = ignore_case ? t_lower : t;
 	int result;
 
-	if(ignore_case)
-	{
-		/* Ignore too small buffer errors by not caring about part that didn't
-		 * fit. */
-		(void)str_to_lower(s, s_buf, sizeof(s_buf));
-		(void)str_to_lower(t, t_buf, sizeof(t_buf));
-
-		s_val = s_buf;
-		t_val = t_buf;
-	}
-
 	result = cfg.sort_numbers ? strnumcmp(s_val, t_val) : strcmp(s_val, t_val);
 	if(result == 0 && ignore_case)
 	{
@@ -25,10 +25,23 @@
 
 void sort_view(FileView *view);
 
+/* Finds position in sorted array of count entries of the view at which the
+ * entry should be inserted to keep the array sorted.  Entry is placed after
+ * entries that are equal to it.  Doesn't need the entry to be in the list.
+ * Returns the position, which is in [0; count] range. */
+int sort_find_insert_pos(FileView *view, dir_entry_t entries[], int count,
+		const dir_entry_t *entry);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
 
+/* Checks whether change of meta-data of an entry from the was state to the now
+ * state can change its position in the sorted list of the view.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int sort_is_affected(const FileView *view, const dir_entry_t *was,
+		const dir_entry_t *now);
+
 TSTATIC_DEFS(
 	int strnumcmp(const char s[], const char t[]);
 )
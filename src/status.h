@@ -24,7 +24,6 @@
 
 #include "compat/fs_limits.h"
 #include "ui/color_scheme.h"
-#include "utils/tree.h"
 
 struct config_t;
 
@@ -108,8 +107,6 @@ typedef struct
 	/* Describes terminal state with regard to its dimensions. */
 	TermState term_state;
 
-	tree_t dirsize_cache; /* ga command results */
-
 	int last_search_backward;
 
 	int ch_pos; /* for :cd, :pushd and 'letter */
@@ -31,6 +31,7 @@ const char *tags[] = {
 	"vifm-'",
 	"vifm-'aproposprg'",
 	"vifm-'autochpos'",
+	"vifm-'calcdirsizes'",
 	"vifm-'cd'",
 	"vifm-'cdpath'",
 	"vifm-'cf'",
@@ -39,8 +40,10 @@ const char *tags[] = {
 	"vifm-'co'",
 	"vifm-'columns'",
 	"vifm-'confirm'",
+	"vifm-'copyjobs'",
 	"vifm-'cpo'",
 	"vifm-'cpoptions'",
+	"vifm-'diskusage'",
 	"vifm-'dotdirs'",
 	"vifm-'fastrun'",
 	"vifm-'fcs'",
@@ -62,6 +65,7 @@ const char *tags[] = {
 	"vifm-'is'",
 	"vifm-'laststatus'",
 	"vifm-'lines'",
+	"vifm-'listcache'",
 	"vifm-'locateprg'",
 	"vifm-'ls'",
 	"vifm-'lsview'",
@@ -70,6 +74,7 @@ const char *tags[] = {
 	"vifm-'number'",
 	"vifm-'numberwidth'",
 	"vifm-'nuw'",
+	"vifm-'prefetch'",
 	"vifm-'relativenumber'",
 	"vifm-'rnu'",
 	"vifm-'ruf'",
@@ -99,6 +104,7 @@ const char *tags[] = {
 	"vifm-'to'",
 	"vifm-'trash'",
 	"vifm-'trashdir'",
+	"vifm-'trustnotify'",
 	"vifm-'ts'",
 	"vifm-'tuioptions'",
 	"vifm-'ul'",
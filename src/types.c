@@ -21,7 +21,7 @@
 
 #include <sys/stat.h> /* S_*() */
 #include <sys/types.h> /* mode_t */
-#include <dirent.h> /* struct dirent, DT_* */
+#include <dirent.h> /* DT_* */
 
 #include <assert.h> /* assert() */
 
@@ -76,9 +76,9 @@ get_type_from_mode(mode_t mode)
 #ifndef _WIN32
 
 FileType
-type_from_dir_entry(const struct dirent *d)
+type_from_dir_entry(unsigned char type)
 {
-	switch(d->d_type)
+	switch(type)
 	{
 		case DT_LNK:  return FT_LINK;
 		case DT_DIR:  return FT_DIR;
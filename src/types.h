@@ -22,9 +22,6 @@
 
 #include <sys/types.h> /* mode_t */
 
-/* Forward declaration of dirent structure to omit inclusion of <dirent.h>. */
-struct dirent;
-
 /* List of types of file system objects. */
 typedef enum
 {
@@ -53,9 +50,9 @@ FileType get_type_from_mode(mode_t mode);
 
 #ifndef _WIN32
 
-/* Converts dirent structure returned by call to readdir() to type from FileType
- * enumeration.  Returns item of the enumeration. */
-FileType type_from_dir_entry(const struct dirent *d);
+/* Converts type of directory entry (DT_* value of d_type field) to type from
+ * FileType enumeration.  Returns item of the enumeration. */
+FileType type_from_dir_entry(unsigned char type);
 
 #endif
 
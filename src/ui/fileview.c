@@ -68,6 +68,7 @@ static void calculate_number_width(FileView *view);
 static int count_digits(int num);
 static int calculate_top_position(FileView *view, int top);
 static int get_line_color(const FileView *view, int pos);
+static LinkTargetState get_link_state(const FileView *view, int pos);
 static size_t calculate_print_width(const FileView *view, int i,
 		size_t max_width);
 static void draw_cell(const FileView *view, const column_data_t *cdt,
@@ -367,25 +368,14 @@ get_line_color(const FileView *view, int pos)
 			{
 				return LINK_COLOR;
 			}
-			else
+			if(view->dir_entry[pos].link_state == LTS_UNKNOWN)
 			{
-				char full[PATH_MAX];
-				get_full_path_at(view, pos, sizeof(full), full);
-				if(get_link_target_abs(full, view->dir_entry[pos].origin, full,
-							sizeof(full)) != 0)
-				{
-					return BROKEN_LINK_COLOR;
-				}
-
-				/* Assume that targets on slow file system are not broken as actual
-				 * check might take long time. */
-				if(is_on_slow_fs(full))
-				{
-					return LINK_COLOR;
-				}
-
-				return path_exists(full, DEREF) ? LINK_COLOR : BROKEN_LINK_COLOR;
+				/* Remember the result to not query file system on every redraw. */
+				view->dir_entry[pos].link_state = get_link_state(view, pos);
 			}
+			return (view->dir_entry[pos].link_state == LTS_BROKEN)
+			     ? BROKEN_LINK_COLOR
+			     : LINK_COLOR;
 #ifndef _WIN32
 		case FT_SOCK:
 			return SOCKET_COLOR;
@@ -401,6 +391,29 @@ get_line_color(const FileView *view, int pos)
 	}
 }
 
+/* Checks whether symbolic link at specified position is broken.  Returns
+ * state of its target. */
+static LinkTargetState
+get_link_state(const FileView *view, int pos)
+{
+	char full[PATH_MAX];
+	get_full_path_at(view, pos, sizeof(full), full);
+	if(get_link_target_abs(full, view->dir_entry[pos].origin, full,
+				sizeof(full)) != 0)
+	{
+		return LTS_BROKEN;
+	}
+
+	/* Assume that targets on slow file system are not broken as actual check
+	 * might take long time. */
+	if(is_on_slow_fs(full))
+	{
+		return LTS_VALID;
+	}
+
+	return path_exists(full, DEREF) ? LTS_VALID : LTS_BROKEN;
+}
+
 /* Calculates width of the column using entry and maximum width. */
 static size_t
 calculate_print_width(const FileView *view, int i, size_t max_width)
@@ -1045,11 +1058,13 @@ format_size(int id, const void *data, size_t buf_len, char buf[])
 {
 	char str[24];
 	const column_data_t *cdt = data;
-	uint64_t size = get_file_size_by_entry(cdt->view, cdt->line_pos);
+	int exact;
+	uint64_t size = get_file_size_by_entry(cdt->view, cdt->line_pos, &exact);
 
 	str[0] = '\0';
 	friendly_size_notation(size, sizeof(str), str);
-	snprintf(buf, buf_len + 1, " %s", str);
+	/* Estimated sizes of directories are prefixed with a tilde. */
+	snprintf(buf, buf_len + 1, " %s%s", exact ? "" : "~", str);
 }
 
 /* File type (dir/reg/exe/link/...) format callback for column_view unit. */
@@ -24,8 +24,8 @@
 
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* FILE fclose() fdopen() feof() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* memmove() strlen() strncat() */
+#include <stdlib.h> /* free() qsort() */
+#include <string.h> /* memmove() strcmp() strlen() strncat() */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
@@ -35,13 +35,16 @@
 #include "../modes/modes.h"
 #include "../modes/view.h"
 #include "../utils/file_streams.h"
+#include "../utils/filemon.h"
 #include "../utils/fs.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "../filelist.h"
 #include "../filetype.h"
+#include "../flist_cache.h"
 #include "../macros.h"
 #include "../status.h"
 #include "../types.h"
@@ -61,6 +64,8 @@
 #define PREVIEW_LINE_BUF_LEN 4096
 
 static void view_file(const char path[]);
+static int view_cached_dir(const char path[]);
+static int name_sorter(const void *first, const void *second);
 static void view_stream(FILE *fp, int wrapped);
 static int shift_line(char line[], size_t len, size_t offset);
 static size_t add_to_line(FILE *fp, size_t max, char line[], size_t len);
@@ -168,7 +173,10 @@ view_file(const char path[])
 
 	if(viewer == NULL && is_dir(path))
 	{
-		write_message("File is a Directory");
+		if(view_cached_dir(path) != 0)
+		{
+			write_message("File is a Directory");
+		}
 		return;
 	}
 
@@ -215,6 +223,76 @@ view_file(const char path[])
 	fclose(fp);
 }
 
+/* Displays list of files of the directory in the other pane if the list was
+ * read in advance and is still valid.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+view_cached_dir(const char path[])
+{
+	const size_t max_width = other_view->window_width - 1;
+	const size_t max_y = other_view->window_rows - 1;
+
+	const col_scheme_t *cs = ui_view_get_cs(other_view);
+	char dir[PATH_MAX];
+	filemon_t mon;
+	char **names;
+	int count;
+	int i;
+	size_t y;
+
+	copy_str(dir, sizeof(dir), path);
+	if(!is_root_dir(dir))
+	{
+		chosp(dir);
+	}
+
+	if(filemon_from_file(dir, &mon) != 0)
+	{
+		return 1;
+	}
+
+	count = flist_cache_get_names(dir, &mon, &names);
+	if(count < 0)
+	{
+		return 1;
+	}
+
+	qsort(names, count, sizeof(*names), &name_sorter);
+
+	cleanup_for_text();
+	wattrset(other_view->win, 0);
+
+	y = LINE;
+	for(i = 0; i < count && y <= max_y; ++i)
+	{
+		esc_state state;
+		int printed;
+
+		if(curr_view->hide_dot && names[i][0] == '.')
+		{
+			continue;
+		}
+
+		esc_state_init(&state, &cs->color[WIN_COLOR]);
+		(void)esc_print_line(names[i], other_view->win, COL, y, max_width, 0,
+				&state, &printed);
+		++y;
+	}
+
+	free_string_array(names, count);
+	return 0;
+}
+
+/* Sorting function for qsort() that orders file names.  Returns negative
+ * number, zero or positive number for less, equal and greater respectively. */
+static int
+name_sorter(const void *first, const void *second)
+{
+	const char *const *const a = first;
+	const char *const *const b = second;
+	return strcmp(*a, *b);
+}
+
 /* Displays contents read from the fp in the other pane starting from the second
  * line and second column.  The wrapped parameter determines whether lines
  * should be wrapped. */
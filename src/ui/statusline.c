@@ -262,7 +262,7 @@ parse_view_macros(FileView *view, const char **format, const char macros[],
 						{
 							if(view->dir_entry[i].selected)
 							{
-								size += get_file_size_by_entry(view, i);
+								size += get_file_size_by_entry(view, i, NULL);
 							}
 						}
 					}
@@ -270,7 +270,7 @@ parse_view_macros(FileView *view, const char **format, const char macros[],
 					 * selection when cursor is on ../ directory. */
 					else if(!vle_mode_is(VISUAL_MODE))
 					{
-						size = get_file_size_by_entry(view, view->list_pos);
+						size = get_file_size_by_entry(view, view->list_pos, NULL);
 					}
 					friendly_size_notation(size, sizeof(buf), buf);
 				}
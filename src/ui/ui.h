@@ -36,6 +36,8 @@
 #include "../compat/fs_limits.h"
 #include "../utils/filemon.h"
 #include "../utils/filter.h"
+#include "../utils/fswatch.h"
+#include "../utils/str_arena.h"
 #include "../utils/trie.h"
 #include "../status.h"
 #include "../types.h"
@@ -134,11 +136,26 @@ typedef struct
 }
 history_t;
 
+/* State of target of a symbolic link, which is resolved once on loading the
+ * entry to avoid querying file system on every redraw. */
+typedef enum
+{
+	LTS_UNKNOWN, /* Wasn't checked yet. */
+	LTS_VALID,   /* Target exists or is on slow file system and assumed to. */
+	LTS_BROKEN,  /* Target doesn't exist. */
+}
+LinkTargetState;
+
+/* Fields are ordered to avoid padding, because there might be millions of
+ * entries. */
 typedef struct
 {
 	char *name;
 	char *origin;     /* Location where this file comes from. */
 	uint64_t size;
+	time_t mtime;
+	time_t atime;
+	time_t ctime;
 #ifndef _WIN32
 	uid_t uid;
 	gid_t gid;
@@ -146,23 +163,21 @@ typedef struct
 #else
 	DWORD attrs;
 #endif
-	time_t mtime;
-	time_t atime;
-	time_t ctime;
 	FileType type;
 
-	int selected;
-	int was_selected; /* Stores previous selection state in Visual mode. */
+	int list_num;     /* Used by sorting comparer to perform stable sort. */
+
+	int hi_num;       /* File highlighting parameters cache (initially -1). */
 
-	int search_match;      /* Whether the item matches last search. */
 	short int match_left;  /* Starting position of the match. */
 	short int match_right; /* Ending position of the match. */
 
-	int list_num;     /* Used by sorting comparer to perform stable sort. */
-
-	int marked;       /* Whether file should be processed. */
-
-	int hi_num;       /* File highlighting parameters cache (initially -1). */
+	/* Number of the match of last search (starting at one) or zero. */
+	signed int search_match : 27;
+	unsigned int selected : 1;
+	unsigned int was_selected : 1; /* Previous selection state in Visual mode. */
+	unsigned int marked : 1;       /* Whether file should be processed. */
+	unsigned int link_state : 2;   /* LinkTargetState for symbolic links. */
 }
 dir_entry_t;
 
@@ -201,11 +216,17 @@ typedef struct
 #ifndef _WIN32
 	/* Monitor that checks for directory changes. */
 	filemon_t mon;
+	/* Reports changes of entries of watched_dir, NULL if not available. */
+	fswatch_t *watch;
+	/* Whether watch was active since the list was read, so that all changes of
+	 * the list since then are reported by it. */
+	int watch_covers_list;
 #else
 	FILETIME dir_mtime;
 	HANDLE dir_watcher;
-	char watched_dir[PATH_MAX];
 #endif
+	/* Directory for which change notifications are set up. */
+	char watched_dir[PATH_MAX];
 	char last_dir[PATH_MAX];
 
 	/* Number of files that match current search pattern. */
@@ -226,6 +247,9 @@ typedef struct
 	int selected_files;
 	int local_cs; /* Whether directory-specific color scheme is in use. */
 	dir_entry_t *dir_entry;
+	/* Storage of names and origins of entries of all file lists of the view
+	 * (NULL means that they are allocated on the heap). */
+	str_arena_t *names;
 	char ** selected_filelist;
 	int nsaved_selection;
 	char ** saved_selection;
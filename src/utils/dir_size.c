@@ -0,0 +1,864 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dir_size.h"
+
+#include <sys/stat.h> /* S_ISDIR() fstat() fstatat() stat */
+#include <dirent.h> /* DT_DIR DT_UNKNOWN */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW O_* open() */
+#include <pthread.h> /* pthread_* */
+#include <unistd.h> /* close() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memmove() strdup() */
+
+#include "../compat/reallocarray.h"
+#include "fs.h"
+#include "parallel.h"
+#include "path.h"
+#include "str.h"
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* Number of finished directories a thread accumulates before passing them to
+ * store callback. */
+#define STORE_BATCH 64
+
+/* Number of processed directories between two progress reports. */
+#define PROGRESS_STEP 256
+
+/* Units of st_blocks field of stat structure. */
+#define STAT_BLOCK_SIZE 512U
+
+/* Initial and maximal number of slots in the set of hard-linked files.  The
+ * limit bounds memory used by a single calculation to 32 MiB, which is enough
+ * to remember about three million files. */
+#define LINKS_MIN_SLOTS 1024U
+#define LINKS_MAX_SLOTS (1U << 22)
+
+/* How hard-linked files affected accuracy of directory size. */
+typedef enum
+{
+	LF_SKIPPED = 1 << 0, /* Some files were skipped as already counted. */
+	LF_LOST    = 1 << 1, /* Some files couldn't be remembered. */
+}
+LinkFlags;
+
+/* Result of adding file to the set of hard-linked files. */
+typedef enum
+{
+	LA_ADDED,   /* File wasn't seen before. */
+	LA_PRESENT, /* File was already counted. */
+	LA_FULL,    /* There is no room to remember the file. */
+}
+LinkAddResult;
+
+/* Directory, whose size is being calculated. */
+typedef struct dir_node_t
+{
+	struct dir_node_t *parent; /* Directory this one is in or NULL for root. */
+	char *path;                /* Full path to the directory. */
+	uint64_t size;             /* Size accumulated so far. */
+	dir_stamp_t stamp;         /* State of the directory before reading it. */
+	int pending;               /* Own scan plus number of unfinished subdirs. */
+	int failed;                /* Whether the directory couldn't be read. */
+	int link_flags;            /* LinkFlags of the subtree. */
+}
+dir_node_t;
+
+/* Hard-linked file found during a scan, which is yet to be accounted for. */
+typedef struct
+{
+	uint64_t key;  /* Fingerprint of device and inode numbers. */
+	uint64_t size; /* Space allocated for the file. */
+}
+link_t;
+
+/* Set of fingerprints of files with several hard links that were counted
+ * already.  Open addressing with linear probing, zero marks empty slot.  Load
+ * factor is kept below 3/4. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects fields below. */
+	uint64_t *slots;      /* Hash table. */
+	size_t capacity;      /* Number of slots (power of two). */
+	size_t count;         /* Number of used slots. */
+}
+link_set_t;
+
+/* Double-ended queue of directories waiting to be scanned.  Owner takes items
+ * from the back, other threads steal them from the front. */
+typedef struct
+{
+	dir_node_t **items; /* Storage of items. */
+	int first;          /* Index of the first item. */
+	int count;          /* Number of items. */
+	int capacity;       /* Number of allocated items. */
+}
+deque_t;
+
+/* State shared by all threads of a single calculation. */
+typedef struct
+{
+	const dir_size_client_t *client; /* Callbacks. */
+	pthread_mutex_t lock;  /* Protects fields below and nodes in the tree. */
+	pthread_cond_t cond;   /* Signaled on new work and on end of work. */
+	deque_t *deques;       /* Deque per thread. */
+	int ndeques;           /* Number of deques. */
+	int active;            /* Number of queued and currently scanned dirs. */
+	int idle;              /* Number of threads waiting for work. */
+	uint64_t ndirs;        /* Number of scanned directories. */
+	uint64_t total;        /* Total size found so far. */
+	uint64_t root_size;    /* Size of the root once it's finished. */
+	int root_failed;       /* Whether root couldn't be read. */
+	link_set_t links;      /* Hard-linked files, used in disk usage mode. */
+}
+walk_t;
+
+/* State of a single thread. */
+typedef struct
+{
+	walk_t *walk;                 /* Shared state. */
+	int index;                    /* Index of thread's own deque. */
+	dir_size_result_t *results;   /* Results, which weren't reported yet. */
+	int nresults;                 /* Number of results. */
+	int results_cap;              /* Number of allocated results. */
+}
+worker_t;
+
+/* State of scanning a single directory. */
+typedef struct
+{
+	worker_t *worker;    /* Thread that does the scanning. */
+	dir_node_t *node;    /* Directory being scanned. */
+	int fd;              /* Opened directory. */
+	uint64_t size;       /* Size of files and of known subdirectories. */
+	dir_node_t **subdirs; /* Subdirectories found in current batch. */
+	int nsubdirs;        /* Number of subdirectories. */
+	int subdirs_cap;     /* Number of allocated subdirectories. */
+	link_t *links;       /* Hard-linked files found in current batch. */
+	int nlinks;          /* Number of hard-linked files. */
+	int links_cap;       /* Number of allocated hard-linked files. */
+	int link_flags;      /* LinkFlags of the directory. */
+}
+scan_t;
+
+static void run_workers(size_t from, size_t to, void *arg);
+static void work(worker_t *w);
+static dir_node_t * take_node(walk_t *walk, int index);
+static uint64_t scan_dir(worker_t *w, dir_node_t *node, int *link_flags);
+static int scan_batch(const dir_batch_entry_t entries[], int count,
+		void *param);
+static void add_file(scan_t *scan, const struct stat *st);
+static void account_links(scan_t *scan);
+static void add_subdir(scan_t *scan, const char name[]);
+static void push_subdirs(scan_t *scan);
+static void finish_node(worker_t *w, dir_node_t *node, uint64_t size,
+		int link_flags);
+static void add_result(worker_t *w, dir_node_t *node);
+static void flush_results(worker_t *w);
+static dir_node_t * make_node(dir_node_t *parent, char path[]);
+static void free_node(dir_node_t *node);
+static LinkAddResult links_add(link_set_t *set, uint64_t key);
+static int links_grow(link_set_t *set);
+static uint64_t make_link_key(uint64_t dev, uint64_t ino);
+static uint64_t mix_bits(uint64_t x);
+static int deque_push(deque_t *deque, dir_node_t *node);
+static dir_node_t * deque_pop_back(deque_t *deque);
+static dir_node_t * deque_pop_front(deque_t *deque);
+
+int
+dir_size_calc(const char path[], const dir_size_client_t *client,
+		uint64_t *size)
+{
+	walk_t walk = { .client = client, .root_failed = 1 };
+	dir_node_t *root;
+	int i;
+
+	*size = 0U;
+
+	walk.ndeques = parallel_cpu_count();
+	walk.deques = calloc(walk.ndeques, sizeof(*walk.deques));
+	if(walk.deques == NULL)
+	{
+		return 1;
+	}
+
+	root = make_node(NULL, strdup(path));
+	if(root == NULL || deque_push(&walk.deques[0], root) != 0)
+	{
+		free_node(root);
+		free(walk.deques);
+		return 1;
+	}
+	walk.active = 1;
+
+	pthread_mutex_init(&walk.lock, NULL);
+	pthread_cond_init(&walk.cond, NULL);
+	pthread_mutex_init(&walk.links.lock, NULL);
+
+	parallel_for(walk.ndeques, 1U, &run_workers, &walk);
+
+	pthread_mutex_destroy(&walk.links.lock);
+	pthread_cond_destroy(&walk.cond);
+	pthread_mutex_destroy(&walk.lock);
+
+	free(walk.links.slots);
+
+	for(i = 0; i < walk.ndeques; ++i)
+	{
+		free(walk.deques[i].items);
+	}
+	free(walk.deques);
+
+	*size = walk.root_size;
+	return walk.root_failed;
+}
+
+/* Runs workers for the range of deque indexes. */
+static void
+run_workers(size_t from, size_t to, void *arg)
+{
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		worker_t w = { .walk = arg, .index = i };
+		work(&w);
+	}
+}
+
+/* Processes directories until there are none left. */
+static void
+work(worker_t *w)
+{
+	walk_t *const walk = w->walk;
+	const dir_size_client_t *const client = walk->client;
+
+	pthread_mutex_lock(&walk->lock);
+	while(walk->active != 0)
+	{
+		dir_node_t *const node = take_node(walk, w->index);
+		uint64_t size;
+		int link_flags;
+		int report;
+		uint64_t ndirs, total;
+
+		if(node == NULL)
+		{
+			++walk->idle;
+			pthread_cond_wait(&walk->cond, &walk->lock);
+			--walk->idle;
+			continue;
+		}
+
+		pthread_mutex_unlock(&walk->lock);
+		size = scan_dir(w, node, &link_flags);
+		pthread_mutex_lock(&walk->lock);
+
+		finish_node(w, node, size, link_flags);
+		if(--walk->active == 0)
+		{
+			pthread_cond_broadcast(&walk->cond);
+		}
+
+		report = (client->progress != NULL && walk->ndirs%PROGRESS_STEP == 0U);
+		ndirs = walk->ndirs;
+		total = walk->total;
+
+		if(report || w->nresults >= STORE_BATCH)
+		{
+			pthread_mutex_unlock(&walk->lock);
+			if(report)
+			{
+				client->progress(ndirs, total, client->arg);
+			}
+			if(w->nresults >= STORE_BATCH)
+			{
+				flush_results(w);
+			}
+			pthread_mutex_lock(&walk->lock);
+		}
+	}
+	pthread_mutex_unlock(&walk->lock);
+
+	flush_results(w);
+	free(w->results);
+}
+
+/* Picks next directory to scan, own deque is tried first.  Must be called with
+ * the lock held.  Returns the directory or NULL if there is nothing to do at
+ * the moment. */
+static dir_node_t *
+take_node(walk_t *walk, int index)
+{
+	dir_node_t *node;
+	int i;
+
+	node = deque_pop_back(&walk->deques[index]);
+	for(i = 1; node == NULL && i < walk->ndeques; ++i)
+	{
+		node = deque_pop_front(&walk->deques[(index + i)%walk->ndeques]);
+	}
+	return node;
+}
+
+/* Reads directory and queues its subdirectories.  Sets *link_flags to how
+ * hard links affected the result.  Returns size of files in the directory and
+ * of its subdirectories known to lookup callback. */
+static uint64_t
+scan_dir(worker_t *w, dir_node_t *node, int *link_flags)
+{
+	scan_t scan = { .worker = w, .node = node };
+	struct stat st;
+
+	*link_flags = 0;
+
+	scan.fd = open(node->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(scan.fd == -1 || fstat(scan.fd, &st) != 0)
+	{
+		if(scan.fd != -1)
+		{
+			close(scan.fd);
+		}
+		node->failed = 1;
+		return 0U;
+	}
+
+	node->stamp.dev = st.st_dev;
+	node->stamp.ino = st.st_ino;
+	node->stamp.mtime = st.st_mtime;
+
+	if(w->walk->client->disk_usage)
+	{
+		scan.size += (uint64_t)st.st_blocks*STAT_BLOCK_SIZE;
+	}
+
+	if(enum_dir_fd_batches(scan.fd, 0U, &scan_batch, &scan) != 0)
+	{
+		node->failed = 1;
+	}
+
+	close(scan.fd);
+	free(scan.subdirs);
+	free(scan.links);
+	*link_flags = scan.link_flags;
+	return scan.size;
+}
+
+/* Accounts for a batch of directory entries.  Returns zero. */
+static int
+scan_batch(const dir_batch_entry_t entries[], int count, void *param)
+{
+	scan_t *const scan = param;
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		const dir_batch_entry_t *const entry = &entries[i];
+		struct stat st;
+
+		if(entry->type == DT_DIR)
+		{
+			add_subdir(scan, entry->name);
+			continue;
+		}
+
+		if(fstatat(scan->fd, entry->name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			continue;
+		}
+
+		if(S_ISDIR(st.st_mode))
+		{
+			add_subdir(scan, entry->name);
+		}
+		else
+		{
+			add_file(scan, &st);
+		}
+	}
+
+	account_links(scan);
+	push_subdirs(scan);
+	return 0;
+}
+
+/* Accounts for size of a file.  In disk usage mode hard-linked files are
+ * postponed until the end of the batch. */
+static void
+add_file(scan_t *scan, const struct stat *st)
+{
+	uint64_t size;
+
+	if(!scan->worker->walk->client->disk_usage)
+	{
+		scan->size += st->st_size;
+		return;
+	}
+
+	size = (uint64_t)st->st_blocks*STAT_BLOCK_SIZE;
+	if(st->st_nlink <= 1)
+	{
+		scan->size += size;
+		return;
+	}
+
+	if(scan->nlinks == scan->links_cap)
+	{
+		const int new_cap = (scan->links_cap == 0) ? 16 : scan->links_cap*2;
+		link_t *const links = reallocarray(scan->links, new_cap, sizeof(*links));
+		if(links == NULL)
+		{
+			/* Might be counted twice. */
+			scan->size += size;
+			scan->link_flags |= LF_LOST;
+			return;
+		}
+		scan->links = links;
+		scan->links_cap = new_cap;
+	}
+
+	scan->links[scan->nlinks].key = make_link_key(st->st_dev, st->st_ino);
+	scan->links[scan->nlinks].size = size;
+	++scan->nlinks;
+}
+
+/* Counts hard-linked files of the batch that weren't seen before.  The set is
+ * locked once per batch to reduce contention. */
+static void
+account_links(scan_t *scan)
+{
+	link_set_t *const set = &scan->worker->walk->links;
+	int i;
+
+	if(scan->nlinks == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&set->lock);
+	for(i = 0; i < scan->nlinks; ++i)
+	{
+		switch(links_add(set, scan->links[i].key))
+		{
+			case LA_ADDED:
+				scan->size += scan->links[i].size;
+				break;
+			case LA_PRESENT:
+				scan->link_flags |= LF_SKIPPED;
+				break;
+			case LA_FULL:
+				scan->size += scan->links[i].size;
+				scan->link_flags |= LF_LOST;
+				break;
+		}
+	}
+	pthread_mutex_unlock(&set->lock);
+
+	scan->nlinks = 0;
+}
+
+/* Either accounts for size of known subdirectory or remembers it for
+ * scanning. */
+static void
+add_subdir(scan_t *scan, const char name[])
+{
+	const dir_size_client_t *const client = scan->worker->walk->client;
+	const char *const sep = ends_with_slash(scan->node->path) ? "" : "/";
+	char *const path = format_str("%s%s%s", scan->node->path, sep, name);
+	dir_node_t *node;
+	uint64_t size;
+
+	if(path == NULL)
+	{
+		return;
+	}
+
+	if(client->lookup != NULL && !client->disk_usage &&
+			client->lookup(path, &size, client->arg) == 0)
+	{
+		scan->size += size;
+		free(path);
+		return;
+	}
+
+	if(scan->nsubdirs == scan->subdirs_cap)
+	{
+		const int new_cap = (scan->subdirs_cap == 0) ? 16 : scan->subdirs_cap*2;
+		dir_node_t **const subdirs = reallocarray(scan->subdirs, new_cap,
+				sizeof(*subdirs));
+		if(subdirs == NULL)
+		{
+			free(path);
+			return;
+		}
+		scan->subdirs = subdirs;
+		scan->subdirs_cap = new_cap;
+	}
+
+	node = make_node(scan->node, path);
+	if(node != NULL)
+	{
+		scan->subdirs[scan->nsubdirs++] = node;
+	}
+}
+
+/* Makes subdirectories found by the scan available to all threads. */
+static void
+push_subdirs(scan_t *scan)
+{
+	walk_t *const walk = scan->worker->walk;
+	deque_t *const deque = &walk->deques[scan->worker->index];
+	int i;
+
+	if(scan->nsubdirs == 0)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&walk->lock);
+	for(i = 0; i < scan->nsubdirs; ++i)
+	{
+		if(deque_push(deque, scan->subdirs[i]) != 0)
+		{
+			free_node(scan->subdirs[i]);
+			continue;
+		}
+		++scan->node->pending;
+		++walk->active;
+	}
+	if(walk->idle != 0)
+	{
+		pthread_cond_broadcast(&walk->cond);
+	}
+	pthread_mutex_unlock(&walk->lock);
+
+	scan->nsubdirs = 0;
+}
+
+/* Accounts for the end of directory scan and propagates sizes of finished
+ * directories up the tree.  Must be called with the lock held. */
+static void
+finish_node(worker_t *w, dir_node_t *node, uint64_t size, int link_flags)
+{
+	walk_t *const walk = w->walk;
+
+	node->size += size;
+	node->link_flags |= link_flags;
+	walk->total += size;
+	++walk->ndirs;
+
+	while(--node->pending == 0)
+	{
+		dir_node_t *const parent = node->parent;
+
+		if(parent == NULL)
+		{
+			walk->root_size = node->failed ? 0U : node->size;
+			walk->root_failed = node->failed;
+			add_result(w, node);
+			break;
+		}
+
+		/* Unreadable directories don't contribute to size of their parents. */
+		if(!node->failed)
+		{
+			parent->size += node->size;
+			parent->link_flags |= node->link_flags;
+		}
+		add_result(w, node);
+		node = parent;
+	}
+}
+
+/* Turns finished directory into a result and frees the node. */
+static void
+add_result(worker_t *w, dir_node_t *node)
+{
+	if(!node->failed && w->walk->client->store != NULL)
+	{
+		if(w->nresults == w->results_cap)
+		{
+			const int new_cap = (w->results_cap == 0)
+			                  ? STORE_BATCH
+			                  : w->results_cap*2;
+			dir_size_result_t *const results = reallocarray(w->results, new_cap,
+					sizeof(*results));
+			if(results != NULL)
+			{
+				w->results = results;
+				w->results_cap = new_cap;
+			}
+		}
+
+		if(w->nresults != w->results_cap)
+		{
+			w->results[w->nresults].path = node->path;
+			w->results[w->nresults].size = node->size;
+			w->results[w->nresults].stamp = node->stamp;
+			/* Files are counted once within the root, so skipping them doesn't
+			 * affect its size. */
+			w->results[w->nresults].exact = !(node->link_flags & LF_LOST)
+			    && (node->parent == NULL || !(node->link_flags & LF_SKIPPED));
+			++w->nresults;
+			node->path = NULL;
+		}
+	}
+
+	free_node(node);
+}
+
+/* Passes accumulated results to store callback. */
+static void
+flush_results(worker_t *w)
+{
+	const dir_size_client_t *const client = w->walk->client;
+	int i;
+
+	if(w->nresults == 0)
+	{
+		return;
+	}
+
+	client->store(w->results, w->nresults, client->arg);
+
+	for(i = 0; i < w->nresults; ++i)
+	{
+		free((char *)w->results[i].path);
+	}
+	w->nresults = 0;
+}
+
+/* Allocates node, which takes ownership of the path.  Returns the node or NULL
+ * on error (the path is freed in this case). */
+static dir_node_t *
+make_node(dir_node_t *parent, char path[])
+{
+	dir_node_t *node;
+
+	if(path == NULL)
+	{
+		return NULL;
+	}
+
+	node = malloc(sizeof(*node));
+	if(node == NULL)
+	{
+		free(path);
+		return NULL;
+	}
+
+	node->parent = parent;
+	node->path = path;
+	node->size = 0U;
+	node->pending = 1;
+	node->failed = 0;
+	node->link_flags = 0;
+	return node;
+}
+
+/* Frees the node and its path.  The node can be NULL. */
+static void
+free_node(dir_node_t *node)
+{
+	if(node != NULL)
+	{
+		free(node->path);
+		free(node);
+	}
+}
+
+/* Remembers file in the set unless it's there already.  Returns result of the
+ * operation. */
+static LinkAddResult
+links_add(link_set_t *set, uint64_t key)
+{
+	size_t i;
+
+	if(set->count >= set->capacity/4U*3U)
+	{
+		(void)links_grow(set);
+	}
+
+	if(set->capacity == 0U)
+	{
+		return LA_FULL;
+	}
+
+	i = key & (set->capacity - 1U);
+	while(set->slots[i] != 0U)
+	{
+		if(set->slots[i] == key)
+		{
+			return LA_PRESENT;
+		}
+		i = (i + 1U) & (set->capacity - 1U);
+	}
+
+	/* Lookups still work after the limit is reached. */
+	if(set->count >= set->capacity/4U*3U)
+	{
+		return LA_FULL;
+	}
+
+	set->slots[i] = key;
+	++set->count;
+	return LA_ADDED;
+}
+
+/* Doubles capacity of the set unless it reached the limit.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+links_grow(link_set_t *set)
+{
+	const size_t new_cap = (set->capacity == 0U)
+	                     ? LINKS_MIN_SLOTS
+	                     : set->capacity*2U;
+	uint64_t *slots;
+	size_t i;
+
+	if(new_cap > LINKS_MAX_SLOTS)
+	{
+		return 1;
+	}
+
+	slots = calloc(new_cap, sizeof(*slots));
+	if(slots == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < set->capacity; ++i)
+	{
+		const uint64_t key = set->slots[i];
+		size_t j;
+
+		if(key == 0U)
+		{
+			continue;
+		}
+
+		j = key & (new_cap - 1U);
+		while(slots[j] != 0U)
+		{
+			j = (j + 1U) & (new_cap - 1U);
+		}
+		slots[j] = key;
+	}
+
+	free(set->slots);
+	set->slots = slots;
+	set->capacity = new_cap;
+	return 0;
+}
+
+/* Makes fingerprint of a file identified by device and inode numbers.  It's a
+ * 64-bit hash, so false matches are possible in theory, but are unlikely to
+ * happen for the number of files the set can hold.  Returns non-zero
+ * fingerprint. */
+static uint64_t
+make_link_key(uint64_t dev, uint64_t ino)
+{
+	const uint64_t key = mix_bits(mix_bits(dev) ^ ino);
+	return (key == 0U) ? 1U : key;
+}
+
+/* Spreads bits of the value (finalizer of splitmix64).  Returns the result. */
+static uint64_t
+mix_bits(uint64_t x)
+{
+	x = (x ^ (x >> 30))*UINT64_C(0xbf58476d1ce4e5b9);
+	x = (x ^ (x >> 27))*UINT64_C(0x94d049bb133111eb);
+	return x ^ (x >> 31);
+}
+
+/* Appends the node to the back of the deque.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+deque_push(deque_t *deque, dir_node_t *node)
+{
+	if(deque->first + deque->count == deque->capacity)
+	{
+		if(deque->first != 0)
+		{
+			memmove(deque->items, deque->items + deque->first,
+					sizeof(*deque->items)*deque->count);
+			deque->first = 0;
+		}
+		else
+		{
+			const int new_cap = (deque->capacity == 0) ? 64 : deque->capacity*2;
+			dir_node_t **const items = reallocarray(deque->items, new_cap,
+					sizeof(*items));
+			if(items == NULL)
+			{
+				return 1;
+			}
+			deque->items = items;
+			deque->capacity = new_cap;
+		}
+	}
+
+	deque->items[deque->first + deque->count++] = node;
+	return 0;
+}
+
+/* Removes item from the back of the deque.  Returns the item or NULL if the
+ * deque is empty. */
+static dir_node_t *
+deque_pop_back(deque_t *deque)
+{
+	dir_node_t *node;
+
+	if(deque->count == 0)
+	{
+		return NULL;
+	}
+	node = deque->items[deque->first + --deque->count];
+	if(deque->count == 0)
+	{
+		deque->first = 0;
+	}
+	return node;
+}
+
+/* Removes item from the front of the deque.  Returns the item or NULL if the
+ * deque is empty. */
+static dir_node_t *
+deque_pop_front(deque_t *deque)
+{
+	dir_node_t *node;
+
+	if(deque->count == 0)
+	{
+		return NULL;
+	}
+	node = deque->items[deque->first++];
+	if(--deque->count == 0)
+	{
+		deque->first = 0;
+	}
+	return node;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,92 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DIR_SIZE_H__
+#define VIFM__UTILS__DIR_SIZE_H__
+
+#include <stdint.h> /* uint64_t */
+
+/* Parallel calculation of sizes of directory trees.  Each thread has a deque of
+ * directories to process and takes directories from others when it runs out of
+ * them.  *nix only. */
+
+/* State of a directory, which allows detecting its changes. */
+typedef struct
+{
+	uint64_t dev;  /* Device the directory is located on. */
+	uint64_t ino;  /* Inode number of the directory. */
+	int64_t mtime; /* Time of the last modification of the directory. */
+}
+dir_stamp_t;
+
+/* Size of a single directory. */
+typedef struct
+{
+	const char *path;  /* Full path to the directory. */
+	uint64_t size;     /* Sum of sizes of all files in its subtree. */
+	dir_stamp_t stamp; /* State of the directory before it was read. */
+	int exact;         /* Whether hard links didn't make the size inaccurate. */
+}
+dir_size_result_t;
+
+/* Queries size of a directory calculated previously.  Returns zero and sets
+ * *size if it's known, otherwise non-zero is returned. */
+typedef int (*dir_size_lookup_func)(const char path[], uint64_t *size,
+		void *arg);
+
+/* Receives sizes of a batch of directories, whose calculation has finished.
+ * Might be called from several threads at the same time. */
+typedef void (*dir_size_store_func)(const dir_size_result_t results[],
+		int count, void *arg);
+
+/* Reports number of directories processed so far and total size of files found
+ * in them.  Might be called from several threads at the same time. */
+typedef void (*dir_size_progress_func)(uint64_t ndirs, uint64_t size,
+		void *arg);
+
+/* Parameters of dir_size_calc().  Any of the callbacks can be NULL. */
+typedef struct
+{
+	dir_size_lookup_func lookup;     /* Sizes of known subdirectories. */
+	dir_size_store_func store;       /* Sizes of processed directories. */
+	dir_size_progress_func progress; /* Progress reports. */
+	void *arg;                       /* Argument for the callbacks. */
+	int disk_usage;                  /* Count allocated space like du does. */
+}
+dir_size_client_t;
+
+/* Calculates size of directory at the path as sum of sizes of files in its
+ * subtree (symbolic links aren't followed) on up to parallel_cpu_count()
+ * threads.  Subdirectories whose sizes are known to lookup callback aren't
+ * traversed.  Sizes of all traversed directories including the root one are
+ * reported to store callback.
+ *
+ * In disk usage mode, allocated blocks of files and directories are summed
+ * instead and files with several hard links are counted once per calculation.
+ * Lookup callback isn't used in this mode, because hard links can't be matched
+ * against subtrees that weren't traversed.  Directory sizes become inexact
+ * when some of their files were skipped as already counted elsewhere (except
+ * for the root) or when too many hard-linked files were met to remember all of
+ * them.  Returns zero on success, otherwise non-zero is returned. */
+int dir_size_calc(const char path[], const dir_size_client_t *client,
+		uint64_t *size);
+
+#endif /* VIFM__UTILS__DIR_SIZE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -95,10 +95,12 @@ dynarray_shrink(void *darray)
 	dynarray_t *dynarray = CAST(darray);
 	if(dynarray->capacity > dynarray->size)
 	{
-		dynarray = realloc(dynarray, sizeof(*dynarray) + dynarray->size);
-		if(dynarray != NULL)
+		dynarray_t *const shrunk = realloc(dynarray,
+				sizeof(*dynarray) + dynarray->size);
+		if(shrunk != NULL)
 		{
-			return dynarray->data;
+			shrunk->capacity = shrunk->size;
+			return shrunk->data;
 		}
 	}
 	return darray;
@@ -29,18 +29,24 @@
 #include "utf8.h"
 #endif
 
+#ifdef __linux__
+#include <sys/syscall.h> /* SYS_getdents64 */
+#endif
 #include <sys/stat.h> /* S_* statbuf */
 #include <sys/types.h> /* size_t mode_t */
-#include <unistd.h> /* getcwd() readlink() */
+#include <fcntl.h> /* O_* open() */
+#include <unistd.h> /* close() getcwd() readlink() syscall() */
 
 #include <errno.h> /* errno */
-#include <stddef.h> /* NULL */
+#include <stddef.h> /* NULL offsetof() */
+#include <stdint.h> /* int64_t uint64_t */
 #include <stdio.h> /* snprintf() remove() */
-#include <stdlib.h> /* free() realpath() */
-#include <string.h> /* strcpy() strdup() strlen() strncmp() strncpy() */
+#include <stdlib.h> /* calloc() free() malloc() realpath() */
+#include <string.h> /* memcpy() strcpy() strdup() strlen() strncmp() strncpy() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/reallocarray.h"
 #include "../io/iop.h"
 #include "log.h"
 #include "path.h"
@@ -48,10 +54,49 @@
 #include "string_array.h"
 #include "utils.h"
 
+/* State of reading a directory in batches. */
+struct dir_batch_reader_t
+{
+	char *buf;                  /* Buffer for data of entries. */
+	size_t buf_size;            /* Size of the buffer. */
+	dir_batch_entry_t *entries; /* Entries of the last batch. */
+#if defined(__linux__) && defined(SYS_getdents64)
+	int fd;                     /* Descriptor of the directory. */
+	int owns_fd;                /* Whether descriptor should be closed. */
+#else
+	DIR *dir;                   /* Stream of the directory. */
+	struct dirent *pending;     /* Entry that didn't fit into last batch. */
+	int capacity;               /* Capacity of the entries array. */
+#endif
+};
+
+#if defined(__linux__) && defined(SYS_getdents64)
+
+/* Layout of records returned by getdents64() system call. */
+struct linux_dirent64
+{
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+/* Smallest possible record: header, one character and terminating null
+ * character, rounded up to alignment of records. */
+#define MIN_DIRENT64_RECLEN \
+	((offsetof(struct linux_dirent64, d_name) + 2U + 7U) & ~(size_t)7U)
+
+#endif
+
 static int is_dir_fast(const char path[]);
 static int path_exists_internal(const char path[], const char filename[],
 		int deref);
 
+static int read_batches(dir_batch_reader_t *reader,
+		dir_batch_client_func client, void *param);
+static size_t normalize_batch_buf_size(size_t buf_size);
+static dir_batch_reader_t * alloc_reader(size_t buf_size);
 #ifndef _WIN32
 static int is_directory(const char path[], int dereference_links);
 #else
@@ -642,6 +687,53 @@ is_dirent_targets_dir(const struct dirent *d)
 #endif
 }
 
+int
+batch_entry_is_link(const char path[], const dir_batch_entry_t *entry)
+{
+#ifndef _WIN32
+	if(entry->type == DT_LNK)
+	{
+		return 1;
+	}
+	if(entry->type != DT_UNKNOWN)
+	{
+		return 0;
+	}
+#endif
+	return is_symlink(path);
+}
+
+int
+batch_entry_is_dir(const char full_path[], const dir_batch_entry_t *entry)
+{
+#ifndef _WIN32
+	return (entry->type == DT_UNKNOWN)
+	     ? is_directory(full_path, 0)
+	     : entry->type == DT_DIR;
+#else
+	const DWORD MASK = FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_DIRECTORY;
+	const DWORD attrs = win_get_file_attrs(full_path);
+	return attrs != INVALID_FILE_ATTRIBUTES
+	    && (attrs & MASK) == FILE_ATTRIBUTE_DIRECTORY;
+#endif
+}
+
+int
+batch_entry_targets_dir(const dir_batch_entry_t *entry)
+{
+#ifdef _WIN32
+	return is_dir(entry->name);
+#else
+	if(entry->type == DT_UNKNOWN)
+	{
+		return is_dir(entry->name);
+	}
+
+	return  entry->type == DT_DIR
+	    || (entry->type == DT_LNK && get_symlink_type(entry->name) != SLT_UNKNOWN);
+#endif
+}
+
 int
 is_in_subtree(const char path[], const char root[])
 {
@@ -739,6 +831,332 @@ enum_dir_content(const char path[], dir_content_client_func client, void *param)
 #endif
 }
 
+int
+enum_dir_batches(const char path[], size_t buf_size,
+		dir_batch_client_func client, void *param)
+{
+	return read_batches(dir_batch_reader_open(path, buf_size), client, param);
+}
+
+#ifndef _WIN32
+
+int
+enum_dir_fd_batches(int dir_fd, size_t buf_size, dir_batch_client_func client,
+		void *param)
+{
+	return read_batches(dir_batch_reader_open_fd(dir_fd, buf_size), client,
+			param);
+}
+
+#endif
+
+/* Passes all batches of the reader to the client and frees the reader, which
+ * can be NULL.  Returns zero on success, otherwise non-zero is returned. */
+static int
+read_batches(dir_batch_reader_t *reader, dir_batch_client_func client,
+		void *param)
+{
+	int result = (reader == NULL);
+
+	while(result == 0)
+	{
+		const dir_batch_entry_t *entries;
+		int count;
+
+		if(dir_batch_reader_next(reader, &entries, &count) != 0)
+		{
+			result = 1;
+		}
+		else if(count == 0)
+		{
+			break;
+		}
+		else if(client(entries, count, param) != 0)
+		{
+			result = 1;
+		}
+	}
+
+	dir_batch_reader_free(reader);
+	return result;
+}
+
+/* Turns buffer size requested for enumeration of directory into the one that
+ * should be used.  Returns the size. */
+static size_t
+normalize_batch_buf_size(size_t buf_size)
+{
+	if(buf_size == 0U)
+	{
+		return DIR_BATCH_BUF_SIZE;
+	}
+	/* Make sure that there is enough space for the longest name. */
+	return MAX(buf_size, (size_t)DIR_BATCH_MIN_BUF_SIZE);
+}
+
+/* Allocates reader with a buffer of buf_size bytes, which isn't associated
+ * with any directory yet.  Returns the reader or NULL on error. */
+static dir_batch_reader_t *
+alloc_reader(size_t buf_size)
+{
+	dir_batch_reader_t *const reader = calloc(1, sizeof(*reader));
+	if(reader == NULL)
+	{
+		return NULL;
+	}
+
+	reader->buf_size = normalize_batch_buf_size(buf_size);
+	reader->buf = malloc(reader->buf_size);
+	if(reader->buf == NULL)
+	{
+		free(reader);
+		return NULL;
+	}
+
+#if defined(__linux__) && defined(SYS_getdents64)
+	reader->fd = -1;
+	/* Each entry takes at least one record. */
+	reader->entries = reallocarray(NULL,
+			reader->buf_size/MIN_DIRENT64_RECLEN + 1U, sizeof(*reader->entries));
+	if(reader->entries == NULL)
+	{
+		free(reader->buf);
+		free(reader);
+		return NULL;
+	}
+#endif
+
+	return reader;
+}
+
+void
+dir_batch_reader_free(dir_batch_reader_t *reader)
+{
+	if(reader == NULL)
+	{
+		return;
+	}
+
+#if defined(__linux__) && defined(SYS_getdents64)
+	if(reader->owns_fd)
+	{
+		(void)close(reader->fd);
+	}
+#else
+	if(reader->dir != NULL)
+	{
+		os_closedir(reader->dir);
+	}
+#endif
+
+	free(reader->entries);
+	free(reader->buf);
+	free(reader);
+}
+
+#if defined(__linux__) && defined(SYS_getdents64)
+
+dir_batch_reader_t *
+dir_batch_reader_open(const char path[], size_t buf_size)
+{
+	dir_batch_reader_t *const reader = alloc_reader(buf_size);
+	if(reader == NULL)
+	{
+		return NULL;
+	}
+
+	reader->fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(reader->fd == -1)
+	{
+		dir_batch_reader_free(reader);
+		return NULL;
+	}
+
+	reader->owns_fd = 1;
+	return reader;
+}
+
+dir_batch_reader_t *
+dir_batch_reader_open_fd(int dir_fd, size_t buf_size)
+{
+	dir_batch_reader_t *const reader = alloc_reader(buf_size);
+	if(reader != NULL)
+	{
+		reader->fd = dir_fd;
+	}
+	return reader;
+}
+
+/* Linux-specific implementation avoids overhead of readdir() by reading many
+ * entries via a single system call. */
+int
+dir_batch_reader_next(dir_batch_reader_t *reader,
+		const dir_batch_entry_t **entries, int *count)
+{
+	*entries = reader->entries;
+	*count = 0;
+
+	/* Batch might consist only of "." and "..". */
+	while(*count == 0)
+	{
+		long pos;
+		const long len = syscall(SYS_getdents64, reader->fd, reader->buf,
+				reader->buf_size);
+		if(len == 0)
+		{
+			break;
+		}
+		if(len < 0)
+		{
+			return 1;
+		}
+
+		for(pos = 0; pos < len; )
+		{
+			const struct linux_dirent64 *const d = (void *)(reader->buf + pos);
+			pos += d->d_reclen;
+
+			if(is_builtin_dir(d->d_name))
+			{
+				continue;
+			}
+
+			reader->entries[*count].name = d->d_name;
+			reader->entries[*count].ino = d->d_ino;
+			reader->entries[*count].type = d->d_type;
+			++*count;
+		}
+	}
+
+	return 0;
+}
+
+#else
+
+dir_batch_reader_t *
+dir_batch_reader_open(const char path[], size_t buf_size)
+{
+	dir_batch_reader_t *const reader = alloc_reader(buf_size);
+	if(reader == NULL)
+	{
+		return NULL;
+	}
+
+	reader->dir = os_opendir(path);
+	if(reader->dir == NULL)
+	{
+		dir_batch_reader_free(reader);
+		return NULL;
+	}
+
+	return reader;
+}
+
+#ifndef _WIN32
+
+dir_batch_reader_t *
+dir_batch_reader_open_fd(int dir_fd, size_t buf_size)
+{
+	int dup_fd;
+	dir_batch_reader_t *const reader = alloc_reader(buf_size);
+	if(reader == NULL)
+	{
+		return NULL;
+	}
+
+	/* Duplicate descriptor as closedir() closes the one it's given. */
+	dup_fd = dup(dir_fd);
+	if(dup_fd == -1)
+	{
+		dir_batch_reader_free(reader);
+		return NULL;
+	}
+
+	reader->dir = fdopendir(dup_fd);
+	if(reader->dir == NULL)
+	{
+		(void)close(dup_fd);
+		dir_batch_reader_free(reader);
+		return NULL;
+	}
+
+	return reader;
+}
+
+#endif
+
+/* Generic implementation packs names of entries read by readdir() into the
+ * buffer. */
+int
+dir_batch_reader_next(dir_batch_reader_t *reader,
+		const dir_batch_entry_t **entries, int *count)
+{
+	size_t used = 0U;
+
+	*count = 0;
+	while(1)
+	{
+		size_t len;
+		struct dirent *d = reader->pending;
+
+		/* Entry that didn't fit into previous batch is still valid as readdir()
+		 * wasn't called since then. */
+		reader->pending = NULL;
+		if(d == NULL && (d = os_readdir(reader->dir)) == NULL)
+		{
+			break;
+		}
+
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		len = strlen(d->d_name) + 1U;
+		if(used + len > reader->buf_size)
+		{
+			if(*count == 0)
+			{
+				return 1;
+			}
+			reader->pending = d;
+			break;
+		}
+
+		if(*count == reader->capacity)
+		{
+			const int new_capacity = (reader->capacity == 0)
+			                       ? 64
+			                       : reader->capacity*2;
+			void *const p = reallocarray(reader->entries, new_capacity,
+					sizeof(*reader->entries));
+			if(p == NULL)
+			{
+				return 1;
+			}
+			reader->entries = p;
+			reader->capacity = new_capacity;
+		}
+
+		memcpy(reader->buf + used, d->d_name, len);
+		reader->entries[*count].name = reader->buf + used;
+#ifndef _WIN32
+		reader->entries[*count].ino = d->d_ino;
+		reader->entries[*count].type = d->d_type;
+#else
+		reader->entries[*count].ino = 0U;
+		reader->entries[*count].type = 0U;
+#endif
+		++*count;
+		used += len;
+	}
+
+	*entries = reader->entries;
+	return 0;
+}
+
+#endif
+
 char *
 get_cwd(char buf[], size_t size)
 {
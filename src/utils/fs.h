@@ -49,6 +49,34 @@ SymLinkType;
 typedef int (*dir_content_client_func)(const char name[], const void *data,
 		void *param);
 
+/* Default size of buffer used by enum_dir_batches() to read directory. */
+#define DIR_BATCH_BUF_SIZE (32*1024)
+
+/* Minimal size of buffer used by enum_dir_batches(), which is enough to hold
+ * entry with the longest possible name. */
+#define DIR_BATCH_MIN_BUF_SIZE 512
+
+/* Single entry of a directory as reported by enum_dir_batches(). */
+typedef struct
+{
+	const char *name; /* Name of the entry. */
+	uint64_t ino;     /* Inode number. */
+	/* One of DT_* constants on *nix, DT_UNKNOWN means that lstat() is needed to
+	 * find out the type.  Always zero on Windows. */
+	unsigned char type;
+}
+dir_batch_entry_t;
+
+/* Per-batch callback type for enum_dir_batches().  Entries (and their names)
+ * are valid only until callback returns.  Should return zero on success or
+ * non-zero to indicate failure which will lead to stopping of directory content
+ * enumeration. */
+typedef int (*dir_batch_client_func)(const dir_batch_entry_t entries[],
+		int count, void *param);
+
+/* Opaque state of reading a directory in batches. */
+typedef struct dir_batch_reader_t dir_batch_reader_t;
+
 /* Checks if path is an existing directory.  Automatically deferences symbolic
  * links. */
 int is_dir(const char path[]);
@@ -155,6 +183,15 @@ int entry_is_dir(const char full_path[], const struct dirent* dentry);
  * is returned.  Symbolic links are dereferenced. */
 int is_dirent_targets_dir(const struct dirent *d);
 
+/* Same as entry_is_link(), but for entries of enum_dir_batches(). */
+int batch_entry_is_link(const char path[], const dir_batch_entry_t *entry);
+
+/* Same as entry_is_dir(), but for entries of enum_dir_batches(). */
+int batch_entry_is_dir(const char full_path[], const dir_batch_entry_t *entry);
+
+/* Same as is_dirent_targets_dir(), but for entries of enum_dir_batches(). */
+int batch_entry_targets_dir(const dir_batch_entry_t *entry);
+
 /* Checks that entity pointed to by the path is located under the root
  * directory.  Returns non-zero if so, otherwise zero is returned. */
 int is_in_subtree(const char path[], const char root[]);
@@ -173,6 +210,50 @@ int is_case_change(const char src[], const char dst[]);
 int enum_dir_content(const char path[], dir_content_client_func client,
 		void *param);
 
+/* Reads directory in big chunks (via getdents64() on Linux) using buffer of
+ * buf_size bytes (zero means DIR_BATCH_BUF_SIZE, values smaller than
+ * DIR_BATCH_MIN_BUF_SIZE are rounded up) and calls the client callback
+ * for each chunk.  "." and ".." entries are not reported.  Returns zero on
+ * success, otherwise non-zero is returned (including the case when callback
+ * stops the enumeration). */
+int enum_dir_batches(const char path[], size_t buf_size,
+		dir_batch_client_func client, void *param);
+
+#ifndef _WIN32
+
+/* Same as enum_dir_batches(), but reads directory that is already opened as
+ * dir_fd, which is left open.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int enum_dir_fd_batches(int dir_fd, size_t buf_size,
+		dir_batch_client_func client, void *param);
+
+#endif
+
+/* Opens directory for reading it in batches as enum_dir_batches() does (see it
+ * for the meaning of buf_size), but lets caller decide when to read next batch.
+ * Returns the reader or NULL on error. */
+dir_batch_reader_t * dir_batch_reader_open(const char path[], size_t buf_size);
+
+#ifndef _WIN32
+
+/* Same as dir_batch_reader_open(), but reads directory that is already opened
+ * as dir_fd, which is left open by the reader.  Returns the reader or NULL on
+ * error. */
+dir_batch_reader_t * dir_batch_reader_open_fd(int dir_fd, size_t buf_size);
+
+#endif
+
+/* Reads next batch of entries of the directory, "." and ".." are skipped.
+ * *count is set to zero at the end of the directory.  Entries (and their names)
+ * are valid until the next call or freeing of the reader.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int dir_batch_reader_next(dir_batch_reader_t *reader,
+		const dir_batch_entry_t **entries, int *count);
+
+/* Frees the reader closing directory if it was opened by the reader.  The
+ * reader can be NULL. */
+void dir_batch_reader_free(dir_batch_reader_t *reader);
+
 /* getcwd() wrapper that always uses forward slashes.  Returns buf on success or
  * NULL on error. */
 char * get_cwd(char buf[], size_t size);
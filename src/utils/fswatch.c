@@ -0,0 +1,195 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "fswatch.h"
+
+#ifdef __linux__
+#include <sys/inotify.h> /* IN_* inotify_add_watch() inotify_event
+                            inotify_init1() */
+#include <unistd.h> /* close() read() */
+#endif
+
+#include <errno.h> /* EINTR errno */
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() malloc() */
+
+#include "../compat/fs_limits.h"
+
+#ifdef __linux__
+
+/* Events of entries of a directory that are of interest. */
+#define ENTRY_EVENTS (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM \
+                    | IN_MODIFY | IN_ATTRIB)
+
+/* Events after which the watcher can't be relied upon. */
+#define FATAL_EVENTS (IN_Q_OVERFLOW | IN_IGNORED | IN_UNMOUNT | IN_DELETE_SELF \
+                    | IN_MOVE_SELF)
+
+/* Watcher implementation. */
+struct fswatch_t
+{
+	int fd;      /* File descriptor of inotify instance. */
+	int errored; /* Whether events might have been lost. */
+};
+
+static FSWatchState process_events(fswatch_t *w, const char buf[],
+		size_t len, fswatch_cb cb, void *arg);
+
+fswatch_t *
+fswatch_create(const char path[])
+{
+	fswatch_t *const w = malloc(sizeof(*w));
+	if(w == NULL)
+	{
+		return NULL;
+	}
+
+	w->errored = 0;
+	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(w->fd == -1)
+	{
+		free(w);
+		return NULL;
+	}
+
+	if(inotify_add_watch(w->fd, path, ENTRY_EVENTS | FATAL_EVENTS | IN_ONLYDIR |
+				IN_EXCL_UNLINK) == -1)
+	{
+		fswatch_free(w);
+		return NULL;
+	}
+
+	return w;
+}
+
+void
+fswatch_free(fswatch_t *w)
+{
+	if(w != NULL)
+	{
+		(void)close(w->fd);
+		free(w);
+	}
+}
+
+FSWatchState
+fswatch_poll(fswatch_t *w, fswatch_cb cb, void *arg)
+{
+	/* The union provides alignment suitable for inotify_event structure. */
+	union
+	{
+		struct inotify_event event;
+		char raw[16*(sizeof(struct inotify_event) + NAME_MAX + 1)];
+	}
+	buf;
+	FSWatchState state = FSWS_UNCHANGED;
+
+	while(!w->errored)
+	{
+		const ssize_t len = read(w->fd, &buf, sizeof(buf));
+		if(len == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if(len == -1 && errno != EAGAIN)
+		{
+			w->errored = 1;
+			break;
+		}
+		if(len <= 0)
+		{
+			return state;
+		}
+
+		if(process_events(w, buf.raw, len, cb, arg) == FSWS_UPDATED)
+		{
+			state = FSWS_UPDATED;
+		}
+	}
+
+	return FSWS_ERRORED;
+}
+
+/* Reports events read from inotify descriptor.  Returns FSWS_UPDATED if at least
+ * one change was reported, otherwise FSWS_UNCHANGED is returned. */
+static FSWatchState
+process_events(fswatch_t *w, const char buf[], size_t len, fswatch_cb cb,
+		void *arg)
+{
+	FSWatchState state = FSWS_UNCHANGED;
+	const char *p = buf;
+	while(p < buf + len && !w->errored)
+	{
+		const struct inotify_event *const e = (const struct inotify_event *)p;
+		p += sizeof(*e) + e->len;
+
+		/* Event without name is about the directory itself, its attributes might
+		 * have changed in a way that affects accessibility of its entries. */
+		if((e->mask & FATAL_EVENTS) || e->len == 0)
+		{
+			w->errored = 1;
+			break;
+		}
+
+		if(e->mask & (IN_CREATE | IN_MOVED_TO))
+		{
+			cb(FSWE_CREATED, e->name, arg);
+		}
+		else if(e->mask & (IN_DELETE | IN_MOVED_FROM))
+		{
+			cb(FSWE_DELETED, e->name, arg);
+		}
+		else if(e->mask & (IN_MODIFY | IN_ATTRIB))
+		{
+			cb(FSWE_MODIFIED, e->name, arg);
+		}
+		else
+		{
+			continue;
+		}
+
+		state = FSWS_UPDATED;
+	}
+	return state;
+}
+
+#else
+
+fswatch_t *
+fswatch_create(const char path[])
+{
+	/* Not supported on this platform, callers fall back to polling. */
+	return NULL;
+}
+
+void
+fswatch_free(fswatch_t *w)
+{
+	/* Nothing to free as nothing can be created. */
+}
+
+FSWatchState
+fswatch_poll(fswatch_t *w, fswatch_cb cb, void *arg)
+{
+	return FSWS_ERRORED;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,66 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FSWATCH_H__
+#define VIFM__UTILS__FSWATCH_H__
+
+/* Watching for changes of entries of a directory.  Complements filemon, which
+ * can only tell that something has changed, by reporting what has changed. */
+
+/* Kind of change of a directory entry. */
+typedef enum
+{
+	FSWE_CREATED,  /* Entry was created or moved into the directory. */
+	FSWE_DELETED,  /* Entry was removed or moved out of the directory. */
+	FSWE_MODIFIED, /* Contents or attributes of the entry were changed. */
+}
+FSWatchEvent;
+
+/* Result of polling a watcher. */
+typedef enum
+{
+	FSWS_UNCHANGED, /* No changes were detected. */
+	FSWS_UPDATED,   /* Changes were reported via callback. */
+	FSWS_ERRORED,   /* Some changes might be lost or directory itself changed,
+	                   the watcher shouldn't be used anymore. */
+}
+FSWatchState;
+
+/* Opaque watcher type. */
+typedef struct fswatch_t fswatch_t;
+
+/* Callback invoked for each change of an entry.  The name is just a name of an
+ * entry inside the watched directory. */
+typedef void (*fswatch_cb)(FSWatchEvent event, const char name[], void *arg);
+
+/* Starts watching the directory.  Returns the watcher or NULL if it can't be
+ * created or the system doesn't support this kind of watching. */
+fswatch_t * fswatch_create(const char path[]);
+
+/* Frees resources of the watcher.  NULL argument is fine. */
+void fswatch_free(fswatch_t *w);
+
+/* Reports changes that happened since the last call (or creation of the
+ * watcher) via callback in the order they happened.  Never blocks.  Returns
+ * state of the watcher. */
+FSWatchState fswatch_poll(fswatch_t *w, fswatch_cb cb, void *arg);
+
+#endif /* VIFM__UTILS__FSWATCH_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,349 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "parallel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h> /* _SC_NPROCESSORS_ONLN sysconf() */
+#endif
+
+#include <pthread.h> /* pthread_t pthread_create() pthread_join() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() qsort() */
+#include <string.h> /* memcpy() */
+
+#include "macros.h"
+#include "test_helpers.h"
+
+/* Upper limit on number of threads used to process single request. */
+#define MAX_THREADS 32
+
+/* Description of a piece of work for a single thread. */
+typedef struct
+{
+	parallel_func func; /* Processing function. */
+	void *arg;          /* Argument for the function. */
+	size_t from;        /* First item of the chunk. */
+	size_t to;          /* Item past the last one of the chunk. */
+}
+chunk_t;
+
+/* State of sorting shared by all threads. */
+typedef struct
+{
+	char *src;               /* Runs to be sorted or merged. */
+	char *dst;               /* Destination of merging. */
+	size_t size;             /* Size of a single item. */
+	parallel_cmp_func cmp;   /* Comparison function. */
+	size_t *bounds;          /* Starts of runs plus the end of the last one. */
+	size_t nruns;            /* Number of runs in src. */
+	size_t nparts;           /* Number of parts each merge is split into. */
+}
+sort_state_t;
+
+static void * chunk_thread(void *arg);
+TSTATIC void parallel_sort_runs(void *base, size_t count, size_t size,
+		parallel_cmp_func cmp, size_t nruns);
+static void sort_runs(size_t from, size_t to, void *arg);
+static void merge_parts(size_t from, size_t to, void *arg);
+static void merge_part(const sort_state_t *state, size_t pair, size_t part);
+static size_t split_point(const sort_state_t *state, const char a[],
+		size_t a_len, const char b[], size_t b_len, size_t part);
+
+int
+parallel_cpu_count(void)
+{
+#ifndef _WIN32
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? (int)MIN(count, (long)MAX_THREADS) : 1;
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0)
+	     ? (int)MIN(info.dwNumberOfProcessors, (DWORD)MAX_THREADS)
+	     : 1;
+#endif
+}
+
+void
+parallel_for(size_t count, size_t min_chunk, parallel_func func, void *arg)
+{
+	chunk_t chunks[MAX_THREADS];
+	pthread_t threads[MAX_THREADS];
+	int started[MAX_THREADS];
+	size_t nchunks;
+	size_t from;
+	size_t i;
+
+	if(min_chunk == 0U)
+	{
+		min_chunk = 1U;
+	}
+
+	nchunks = MIN(count/min_chunk, (size_t)parallel_cpu_count());
+	if(nchunks <= 1U)
+	{
+		if(count != 0U)
+		{
+			func(0U, count, arg);
+		}
+		return;
+	}
+
+	from = 0U;
+	for(i = 0U; i < nchunks; ++i)
+	{
+		/* Spread remainder of the division among first chunks. */
+		const size_t len = count/nchunks + (i < count%nchunks);
+
+		chunks[i].func = func;
+		chunks[i].arg = arg;
+		chunks[i].from = from;
+		chunks[i].to = from + len;
+		from += len;
+	}
+
+	/* The first chunk is processed by the calling thread. */
+	for(i = 1U; i < nchunks; ++i)
+	{
+		started[i] = pthread_create(&threads[i], NULL, &chunk_thread,
+				&chunks[i]) == 0;
+	}
+
+	func(chunks[0].from, chunks[0].to, arg);
+
+	for(i = 1U; i < nchunks; ++i)
+	{
+		if(started[i])
+		{
+			(void)pthread_join(threads[i], NULL);
+		}
+		else
+		{
+			func(chunks[i].from, chunks[i].to, arg);
+		}
+	}
+}
+
+void
+parallel_sort(void *base, size_t count, size_t size, parallel_cmp_func cmp,
+		size_t min_chunk)
+{
+	if(min_chunk == 0U)
+	{
+		min_chunk = 1U;
+	}
+
+	parallel_sort_runs(base, count, size, cmp,
+			MIN(count/min_chunk, (size_t)parallel_cpu_count()));
+}
+
+/* Implementation of parallel_sort() for a given number of runs, which should
+ * be less than or equal to MAX_THREADS. */
+TSTATIC void
+parallel_sort_runs(void *base, size_t count, size_t size, parallel_cmp_func cmp,
+		size_t nruns)
+{
+	size_t bounds[MAX_THREADS + 1];
+	sort_state_t state;
+	char *tmp;
+	size_t i;
+
+	nruns = MIN(nruns, (size_t)MAX_THREADS);
+	if(nruns <= 1U || (tmp = malloc(count*size)) == NULL)
+	{
+		qsort(base, count, size, cmp);
+		return;
+	}
+
+	bounds[0] = 0U;
+	for(i = 0U; i < nruns; ++i)
+	{
+		bounds[i + 1U] = bounds[i] + count/nruns + (i < count%nruns);
+	}
+
+	state.src = base;
+	state.dst = tmp;
+	state.size = size;
+	state.cmp = cmp;
+	state.bounds = bounds;
+	state.nruns = nruns;
+
+	parallel_for(nruns, 1U, &sort_runs, &state);
+
+	/* Each step halves number of runs by merging adjacent pairs of them.  Every
+	 * merge is split into several parts so that all threads have some work even
+	 * when only a couple of runs is left. */
+	while(state.nruns > 1U)
+	{
+		const size_t npairs = state.nruns/2U;
+		const size_t ntasks = npairs*(state.nparts = MAX(1U, nruns/npairs))
+		                    + state.nruns%2U;
+		char *const src = state.src;
+
+		parallel_for(ntasks, 1U, &merge_parts, &state);
+
+		for(i = 0U; i < (state.nruns + 1U)/2U; ++i)
+		{
+			bounds[i] = bounds[i*2U];
+		}
+		bounds[i] = count;
+		state.nruns = i;
+
+		state.src = state.dst;
+		state.dst = src;
+	}
+
+	if(state.src != base)
+	{
+		memcpy(base, state.src, count*size);
+	}
+	free(tmp);
+}
+
+/* parallel_for() callback that sorts a range of runs. */
+static void
+sort_runs(size_t from, size_t to, void *arg)
+{
+	const sort_state_t *const state = arg;
+	size_t i;
+
+	for(i = from; i < to; ++i)
+	{
+		const size_t start = state->bounds[i];
+		qsort(state->src + start*state->size, state->bounds[i + 1U] - start,
+				state->size, state->cmp);
+	}
+}
+
+/* parallel_for() callback that merges a range of parts of pairs of runs.  The
+ * last task copies run that has no pair, if there is one. */
+static void
+merge_parts(size_t from, size_t to, void *arg)
+{
+	const sort_state_t *const state = arg;
+	const size_t npairs = state->nruns/2U;
+	size_t i;
+
+	for(i = from; i < to; ++i)
+	{
+		const size_t pair = i/state->nparts;
+		if(pair < npairs)
+		{
+			merge_part(state, pair, i%state->nparts);
+		}
+		else
+		{
+			const size_t start = state->bounds[state->nruns - 1U];
+			memcpy(state->dst + start*state->size, state->src + start*state->size,
+					(state->bounds[state->nruns] - start)*state->size);
+		}
+	}
+}
+
+/* Merges a part of a pair of runs into destination buffer.  Items of the first
+ * run precede equal items of the second one. */
+static void
+merge_part(const sort_state_t *state, size_t pair, size_t part)
+{
+	const size_t size = state->size;
+	const size_t a_start = state->bounds[pair*2U];
+	const size_t b_start = state->bounds[pair*2U + 1U];
+	const size_t a_len = b_start - a_start;
+	const size_t b_len = state->bounds[pair*2U + 2U] - b_start;
+	const char *const a = state->src + a_start*size;
+	const char *const b = state->src + b_start*size;
+
+	size_t i = a_len*part/state->nparts;
+	size_t j = split_point(state, a, a_len, b, b_len, part);
+	const size_t i_end = a_len*(part + 1U)/state->nparts;
+	const size_t j_end = split_point(state, a, a_len, b, b_len, part + 1U);
+	char *dst = state->dst + (a_start + i + j)*size;
+
+	while(i < i_end && j < j_end)
+	{
+		if(state->cmp(b + j*size, a + i*size) < 0)
+		{
+			memcpy(dst, b + j*size, size);
+			++j;
+		}
+		else
+		{
+			memcpy(dst, a + i*size, size);
+			++i;
+		}
+		dst += size;
+	}
+
+	memcpy(dst, a + i*size, (i_end - i)*size);
+	dst += (i_end - i)*size;
+	memcpy(dst, b + j*size, (j_end - j)*size);
+}
+
+/* Finds where the specified part of a merge starts in the second run.  Returns
+ * number of items of the second run that go before the part. */
+static size_t
+split_point(const sort_state_t *state, const char a[], size_t a_len,
+		const char b[], size_t b_len, size_t part)
+{
+	const char *pivot;
+	size_t lo, hi;
+
+	if(part == 0U)
+	{
+		return 0U;
+	}
+	if(part == state->nparts || a_len == 0U)
+	{
+		return b_len;
+	}
+
+	/* Items of the second run that are less than the first item of the part of
+	 * the first run go before it. */
+	pivot = a + (a_len*part/state->nparts)*state->size;
+	lo = 0U;
+	hi = b_len;
+	while(lo < hi)
+	{
+		const size_t mid = lo + (hi - lo)/2U;
+		if(state->cmp(b + mid*state->size, pivot) < 0)
+		{
+			lo = mid + 1U;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* Entry point of a thread that processes single chunk.  Returns NULL. */
+static void *
+chunk_thread(void *arg)
+{
+	const chunk_t *const chunk = arg;
+	chunk->func(chunk->from, chunk->to, chunk->arg);
+	return NULL;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
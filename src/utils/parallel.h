@@ -0,0 +1,64 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__PARALLEL_H__
+#define VIFM__UTILS__PARALLEL_H__
+
+#include <stddef.h> /* size_t */
+
+#include "test_helpers.h"
+
+/* Helpers for spreading independent pieces of work among several threads. */
+
+/* Processes [from, to) range of items.  Might be called from several threads
+ * at the same time, but never for intersecting ranges. */
+typedef void (*parallel_func)(size_t from, size_t to, void *arg);
+
+/* Compares two items.  Must be safe to call from several threads at the same
+ * time.  Returns positive value if a is greater than b, zero if they are
+ * equal, otherwise negative value is returned. */
+typedef int (*parallel_cmp_func)(const void *a, const void *b);
+
+/* Queries number of processors available to the application.  Returns the
+ * number, which is always positive. */
+int parallel_cpu_count(void);
+
+/* Splits [0, count) range into continuous chunks of at least min_chunk items
+ * and processes them on up to parallel_cpu_count() threads (calling thread is
+ * one of them).  Chunks that can't be given to a new thread are processed by
+ * the calling thread.  Returns after all items are processed. */
+void parallel_for(size_t count, size_t min_chunk, parallel_func func,
+		void *arg);
+
+/* Sorts count items of the specified size.  The array is split into runs of at
+ * least min_chunk items, which are sorted by qsort() and then merged on up to
+ * parallel_cpu_count() threads.  Merging is stable, sorting of runs isn't, so
+ * result matches that of qsort() only for comparers that never consider
+ * different items equal. */
+void parallel_sort(void *base, size_t count, size_t size, parallel_cmp_func cmp,
+		size_t min_chunk);
+
+TSTATIC_DEFS(
+	void parallel_sort_runs(void *base, size_t count, size_t size,
+			parallel_cmp_func cmp, size_t nruns);
+)
+
+#endif /* VIFM__UTILS__PARALLEL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
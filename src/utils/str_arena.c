@@ -0,0 +1,505 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "str_arena.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() memmove() memset() strcmp() strdup()
+                       strlen() */
+
+#include "../compat/reallocarray.h"
+
+/* Size of the first block of a generation. */
+#define MIN_BLOCK_SIZE 4096U
+
+/* Blocks of a generation grow twice each time until they reach this size. */
+#define MAX_BLOCK_SIZE (1024U*1024U)
+
+/* Initial capacity of table of interned strings. */
+#define MIN_INTERN_CAP 16U
+
+/* Initial capacity of index of blocks. */
+#define MIN_INDEX_CAP 16U
+
+/* Block of memory from which strings are allocated. */
+typedef struct block_t
+{
+	struct block_t *next; /* Previously allocated block of the generation. */
+	struct gen_t *gen;    /* Generation to which the block belongs. */
+	size_t size;          /* Size of the data. */
+	size_t used;          /* Number of bytes of the data that are in use. */
+	char data[];          /* Storage of strings. */
+}
+block_t;
+
+/* Group of blocks that is freed at once. */
+typedef struct gen_t
+{
+	struct gen_t *next;  /* Older generation. */
+	block_t *blocks;     /* List of blocks, the newest one comes first. */
+	size_t live;         /* Number of strings that weren't released yet. */
+	char **interned;     /* Open addressing hash table of interned strings. */
+	size_t intern_cap;   /* Capacity of the table (zero or power of two). */
+	size_t intern_count; /* Number of strings in the table. */
+}
+gen_t;
+
+/* Arena itself. */
+struct str_arena_t
+{
+	gen_t *gens;      /* List of generations, the current one comes first. */
+	block_t **index;  /* Blocks of all generations sorted by their addresses. */
+	size_t nblocks;   /* Number of blocks in the index. */
+	size_t index_cap; /* Capacity of the index. */
+	block_t *last;    /* Block of the last released string or NULL. */
+};
+
+static char * alloc_str(str_arena_t *arena, gen_t *gen, const char str[]);
+static int index_block(str_arena_t *arena, block_t *block);
+static char ** find_interned(gen_t *gen, const char str[]);
+static int grow_intern_table(gen_t *gen);
+static size_t hash_str(const char str[]);
+static block_t * find_block(const str_arena_t *arena, const char str[]);
+static int block_owns(const block_t *block, const char str[]);
+static void drop_gen(str_arena_t *arena, gen_t *gen);
+static void free_gen_data(gen_t *gen);
+
+str_arena_t *
+str_arena_create(void)
+{
+	str_arena_t *const arena = calloc(1U, sizeof(*arena));
+	if(arena == NULL)
+	{
+		return NULL;
+	}
+
+	arena->gens = calloc(1U, sizeof(*arena->gens));
+	if(arena->gens == NULL)
+	{
+		free(arena);
+		return NULL;
+	}
+
+	return arena;
+}
+
+void
+str_arena_free(str_arena_t *arena)
+{
+	if(arena == NULL)
+	{
+		return;
+	}
+
+	while(arena->gens != NULL)
+	{
+		gen_t *const next = arena->gens->next;
+		free_gen_data(arena->gens);
+		free(arena->gens);
+		arena->gens = next;
+	}
+	free(arena->index);
+	free(arena);
+}
+
+void
+str_arena_new_gen(str_arena_t *arena)
+{
+	gen_t *gen;
+
+	if(arena == NULL || arena->gens->live == 0U)
+	{
+		return;
+	}
+
+	/* On failure just keep using current generation. */
+	gen = calloc(1U, sizeof(*gen));
+	if(gen != NULL)
+	{
+		gen->next = arena->gens;
+		arena->gens = gen;
+	}
+}
+
+char *
+str_arena_dup(str_arena_t *arena, const char str[])
+{
+	if(arena == NULL)
+	{
+		return strdup(str);
+	}
+
+	return alloc_str(arena, arena->gens, str);
+}
+
+char *
+str_arena_intern(str_arena_t *arena, const char str[])
+{
+	gen_t *gen;
+	char **slot;
+
+	if(arena == NULL)
+	{
+		return strdup(str);
+	}
+
+	gen = arena->gens;
+
+	if(gen->intern_cap != 0U)
+	{
+		slot = find_interned(gen, str);
+		if(*slot != NULL)
+		{
+			++gen->live;
+			return *slot;
+		}
+	}
+
+	if((gen->intern_count + 1U)*2U > gen->intern_cap &&
+			grow_intern_table(gen) != 0)
+	{
+		return NULL;
+	}
+
+	slot = find_interned(gen, str);
+	*slot = alloc_str(arena, gen, str);
+	if(*slot == NULL)
+	{
+		return NULL;
+	}
+
+	++gen->intern_count;
+	return *slot;
+}
+
+/* Allocates copy of the string in the generation of the arena.  Returns the
+ * copy or NULL on error. */
+static char *
+alloc_str(str_arena_t *arena, gen_t *gen, const char str[])
+{
+	const size_t len = strlen(str) + 1U;
+	block_t *block = gen->blocks;
+	char *copy;
+
+	if(block == NULL || block->size - block->used < len)
+	{
+		size_t size = (block == NULL) ? MIN_BLOCK_SIZE : block->size*2U;
+		if(size > MAX_BLOCK_SIZE)
+		{
+			size = MAX_BLOCK_SIZE;
+		}
+		if(size < len)
+		{
+			size = len;
+		}
+
+		block = malloc(sizeof(*block) + size);
+		if(block == NULL)
+		{
+			return NULL;
+		}
+
+		block->next = gen->blocks;
+		block->gen = gen;
+		block->size = size;
+		block->used = 0U;
+
+		if(index_block(arena, block) != 0)
+		{
+			free(block);
+			return NULL;
+		}
+		gen->blocks = block;
+	}
+
+	copy = &block->data[block->used];
+	memcpy(copy, str, len);
+	block->used += len;
+
+	++gen->live;
+	return copy;
+}
+
+/* Adds the block to the index of blocks of the arena.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+index_block(str_arena_t *arena, block_t *block)
+{
+	size_t lo, hi;
+
+	if(arena->nblocks == arena->index_cap)
+	{
+		const size_t cap = (arena->index_cap == 0U)
+		                 ? MIN_INDEX_CAP
+		                 : arena->index_cap*2U;
+		block_t **const index = reallocarray(arena->index, cap, sizeof(*index));
+		if(index == NULL)
+		{
+			return 1;
+		}
+		arena->index = index;
+		arena->index_cap = cap;
+	}
+
+	lo = 0U;
+	hi = arena->nblocks;
+	while(lo < hi)
+	{
+		const size_t mid = lo + (hi - lo)/2U;
+		if(arena->index[mid] < block)
+		{
+			lo = mid + 1U;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	memmove(&arena->index[lo + 1U], &arena->index[lo],
+			sizeof(*arena->index)*(arena->nblocks - lo));
+	arena->index[lo] = block;
+	++arena->nblocks;
+	return 0;
+}
+
+/* Looks up slot of table of interned strings that either holds the string or
+ * should hold it.  The table must have at least one free slot.  Returns
+ * pointer to the slot. */
+static char **
+find_interned(gen_t *gen, const char str[])
+{
+	const size_t mask = gen->intern_cap - 1U;
+	size_t i = hash_str(str) & mask;
+
+	while(gen->interned[i] != NULL && strcmp(gen->interned[i], str) != 0)
+	{
+		i = (i + 1U) & mask;
+	}
+
+	return &gen->interned[i];
+}
+
+/* Doubles capacity of table of interned strings.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+grow_intern_table(gen_t *gen)
+{
+	char **const old = gen->interned;
+	const size_t old_cap = gen->intern_cap;
+	size_t i;
+
+	const size_t cap = (old_cap == 0U) ? MIN_INTERN_CAP : old_cap*2U;
+	char **const interned = calloc(cap, sizeof(*interned));
+	if(interned == NULL)
+	{
+		return 1;
+	}
+
+	gen->interned = interned;
+	gen->intern_cap = cap;
+
+	for(i = 0U; i < old_cap; ++i)
+	{
+		if(old[i] != NULL)
+		{
+			*find_interned(gen, old[i]) = old[i];
+		}
+	}
+
+	free(old);
+	return 0;
+}
+
+/* Computes hash of the string (djb2 algorithm).  Returns the hash. */
+static size_t
+hash_str(const char str[])
+{
+	size_t hash = 5381U;
+	while(*str != '\0')
+	{
+		hash = hash*33U + (unsigned char)*str++;
+	}
+	return hash;
+}
+
+void
+str_arena_release(str_arena_t *arena, char str[])
+{
+	block_t *block;
+	gen_t *gen;
+
+	if(str == NULL)
+	{
+		return;
+	}
+
+	if(arena == NULL)
+	{
+		free(str);
+		return;
+	}
+
+	/* Strings of a list are usually released one after another and most of
+	 * them come from the same block. */
+	block = arena->last;
+	if(block == NULL || !block_owns(block, str))
+	{
+		block = find_block(arena, str);
+		if(block == NULL)
+		{
+			free(str);
+			return;
+		}
+		arena->last = block;
+	}
+
+	gen = block->gen;
+	if(--gen->live == 0U)
+	{
+		drop_gen(arena, gen);
+	}
+}
+
+int
+str_arena_owns(const str_arena_t *arena, const char str[])
+{
+	return arena != NULL && find_block(arena, str) != NULL;
+}
+
+/* Finds block of the arena that contains the string by binary search in the
+ * index of blocks.  Returns the block or NULL if there is no such block. */
+static block_t *
+find_block(const str_arena_t *arena, const char str[])
+{
+	size_t lo = 0U;
+	size_t hi = arena->nblocks;
+
+	/* Find the first block that starts after the string. */
+	while(lo < hi)
+	{
+		const size_t mid = lo + (hi - lo)/2U;
+		if(arena->index[mid]->data <= str)
+		{
+			lo = mid + 1U;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	if(lo == 0U || !block_owns(arena->index[lo - 1U], str))
+	{
+		return NULL;
+	}
+	return arena->index[lo - 1U];
+}
+
+/* Checks whether the string was allocated in the block.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+block_owns(const block_t *block, const char str[])
+{
+	return str >= block->data && str < block->data + block->used;
+}
+
+/* Frees all memory of the generation, which has no live strings left. */
+static void
+drop_gen(str_arena_t *arena, gen_t *gen)
+{
+	size_t i, j;
+
+	/* Remove blocks of the generation from the index preserving the order. */
+	j = 0U;
+	for(i = 0U; i < arena->nblocks; ++i)
+	{
+		if(arena->index[i]->gen != gen)
+		{
+			arena->index[j++] = arena->index[i];
+		}
+	}
+	arena->nblocks = j;
+	if(arena->nblocks == 0U)
+	{
+		free(arena->index);
+		arena->index = NULL;
+		arena->index_cap = 0U;
+	}
+	arena->last = NULL;
+
+	free_gen_data(gen);
+	if(gen == arena->gens)
+	{
+		/* Current generation is kept to serve following allocations. */
+		gen_t *const next = gen->next;
+		memset(gen, 0, sizeof(*gen));
+		gen->next = next;
+	}
+	else
+	{
+		gen_t **link = &arena->gens;
+		while(*link != gen)
+		{
+			link = &(*link)->next;
+		}
+		*link = gen->next;
+		free(gen);
+	}
+}
+
+size_t
+str_arena_mem_usage(const str_arena_t *arena)
+{
+	const gen_t *gen;
+	size_t usage;
+
+	if(arena == NULL)
+	{
+		return 0U;
+	}
+
+	usage = sizeof(*arena) + arena->index_cap*sizeof(*arena->index);
+	for(gen = arena->gens; gen != NULL; gen = gen->next)
+	{
+		const block_t *block;
+		for(block = gen->blocks; block != NULL; block = block->next)
+		{
+			usage += sizeof(*block) + block->size;
+		}
+		usage += sizeof(*gen) + gen->intern_cap*sizeof(*gen->interned);
+	}
+	return usage;
+}
+
+/* Frees blocks and table of interned strings of the generation. */
+static void
+free_gen_data(gen_t *gen)
+{
+	while(gen->blocks != NULL)
+	{
+		block_t *const next = gen->blocks->next;
+		free(gen->blocks);
+		gen->blocks = next;
+	}
+	free(gen->interned);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,70 @@
+/* vifm
+ * Copyright (C) 2015 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STR_ARENA_H__
+#define VIFM__UTILS__STR_ARENA_H__
+
+#include <stddef.h> /* size_t */
+
+/* Arena of strings, which are allocated from big blocks of memory instead of
+ * one by one.  Blocks are grouped into generations, new strings always go to
+ * the newest one.  All memory of a generation is freed at once when the last
+ * of its strings is released.  Blocks are indexed by their addresses, so
+ * finding the owner of a string takes logarithmic time in number of blocks.
+ *
+ * Functions that accept arena also accept NULL, in which case strings are
+ * allocated on the heap. */
+
+/* Declaration of opaque arena type. */
+typedef struct str_arena_t str_arena_t;
+
+/* Creates new empty arena.  Returns NULL on error. */
+str_arena_t * str_arena_create(void);
+
+/* Frees the arena along with all strings allocated in it.  Freeing of NULL
+ * arena is OK. */
+void str_arena_free(str_arena_t *arena);
+
+/* Makes following allocations go to a new generation unless the current one
+ * has no strings in it. */
+void str_arena_new_gen(str_arena_t *arena);
+
+/* Copies the string into the arena.  Returns the copy or NULL on error. */
+char * str_arena_dup(str_arena_t *arena, const char str[]);
+
+/* Same as str_arena_dup(), but reuses equal string of the current generation
+ * if it's already there.  Each returned pointer must be released separately.
+ * Returns the copy or NULL on error. */
+char * str_arena_intern(str_arena_t *arena, const char str[]);
+
+/* Releases string obtained from the arena or frees it if it was allocated
+ * elsewhere on the heap.  Releasing NULL is OK. */
+void str_arena_release(str_arena_t *arena, char str[]);
+
+/* Checks whether the string was allocated in the arena.  Returns non-zero if
+ * so, otherwise zero is returned. */
+int str_arena_owns(const str_arena_t *arena, const char str[]);
+
+/* Computes amount of memory allocated by the arena.  Returns the amount in
+ * bytes. */
+size_t str_arena_mem_usage(const str_arena_t *arena);
+
+#endif /* VIFM__UTILS__STR_ARENA_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
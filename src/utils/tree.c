@@ -18,35 +18,70 @@
 
 #include "tree.h"
 
+#include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h>
+#include <string.h> /* memcpy() memmove() */
 
 #ifdef _WIN32
 #include "fs.h"
 #endif
 #include "../compat/fs_limits.h"
+#include "../compat/reallocarray.h"
+#include "macros.h"
 #include "str.h"
 
+/* Number of nodes in a single block of the pool of nodes. */
+#define NODES_PER_BLOCK 256
+
+/* Minimal size of a single block of the pool of names. */
+#define NAMES_BLOCK_SIZE 4096
+
 typedef struct node_t
 {
 	char *name;
 	size_t name_len;
 	tree_val_t data;
 	int valid;
-	struct node_t *next;
-	struct node_t *child;
+	struct node_t **children; /* Child nodes sorted by their names. */
+	int nchildren;            /* Number of child nodes. */
+	int children_cap;         /* Number of allocated child pointers. */
 }node_t;
 
+/* Block of the pool of nodes.  Nodes are never freed one by one. */
+typedef struct nodes_block_t
+{
+	struct nodes_block_t *prev;    /* Previously allocated block. */
+	int used;                      /* Number of used nodes. */
+	node_t nodes[NODES_PER_BLOCK]; /* Storage of nodes. */
+}nodes_block_t;
+
+/* Block of the pool of names of nodes. */
+typedef struct names_block_t
+{
+	struct names_block_t *prev; /* Previously allocated block. */
+	size_t used;                /* Number of used bytes. */
+	size_t size;                /* Size of the storage. */
+	char data[];                /* Storage of names. */
+}names_block_t;
+
 typedef struct root_t
 {
 	node_t node;
 	int longest;
 	int mem;
+	nodes_block_t *nodes; /* The last block of the pool of nodes. */
+	names_block_t *names; /* The last block of the pool of names. */
 }root_t;
 
-static void nodes_free(node_t *node);
-static node_t * find_node(node_t *root, const char *name, int create,
+static void free_node_data(tree_t tree, node_t *node);
+static node_t * find_node(tree_t tree, const char *name, int create,
 		node_t **last);
+static int find_child(const node_t *node, const char name[], size_t name_len,
+		int *pos);
+static node_t * add_child(tree_t tree, node_t *node, int pos, const char name[],
+		size_t name_len);
+static node_t * alloc_node(tree_t tree);
+static char * alloc_name(tree_t tree, size_t len);
 
 tree_t
 tree_create(int longest, int mem)
@@ -58,35 +93,68 @@ tree_create(int longest, int mem)
 		return NULL_TREE;
 	}
 
-	tree->node.child = NULL;
-	tree->node.next = NULL;
+	tree->node.children = NULL;
+	tree->node.nchildren = 0;
+	tree->node.children_cap = 0;
 	tree->node.name = NULL;
 	tree->node.valid = 0;
 	tree->longest = longest;
 	tree->mem = mem;
+	tree->nodes = NULL;
+	tree->names = NULL;
 	return tree;
 }
 
 void
 tree_free(tree_t tree)
 {
-	if(tree != NULL_TREE)
+	if(tree == NULL_TREE)
+	{
+		return;
+	}
+
+	free_node_data(tree, &tree->node);
+
+	while(tree->nodes != NULL)
 	{
-		nodes_free(&tree->node);
+		nodes_block_t *const prev = tree->nodes->prev;
+		int i;
+		for(i = 0; i < tree->nodes->used; ++i)
+		{
+			free_node_data(tree, &tree->nodes->nodes[i]);
+		}
+		free(tree->nodes);
+		tree->nodes = prev;
 	}
+
+	while(tree->names != NULL)
+	{
+		names_block_t *const prev = tree->names->prev;
+		free(tree->names);
+		tree->names = prev;
+	}
+
+	free(tree);
 }
 
+/* Frees resources owned by the node, but not the node itself. */
 static void
-nodes_free(node_t *node)
+free_node_data(tree_t tree, node_t *node)
 {
-	if(node->child != NULL)
-		nodes_free(node->child);
+	if(node->valid && tree->mem)
+	{
+		union
+		{
+			tree_val_t l;
+			void *p;
+		}u = {
+			.l = node->data,
+		};
 
-	if(node->next != NULL)
-		nodes_free(node->next);
+		free(u.p);
+	}
 
-	free(node->name);
-	free(node);
+	free(node->children);
 }
 
 int
@@ -98,7 +166,10 @@ tree_set_data(tree_t tree, const char *path, tree_val_t data)
 	if(realpath(path, real_path) != real_path)
 		return -1;
 
-	node = find_node(&tree->node, real_path, 1, NULL);
+	node = find_node(tree, real_path, 1, NULL);
+	if(node == NULL)
+		return -1;
+
 	if(node->valid && tree->mem)
 	{
 		union
@@ -123,13 +194,13 @@ tree_get_data(tree_t tree, const char *path, tree_val_t *data)
 	node_t *node;
 	char real_path[PATH_MAX];
 
-	if(tree->node.child == NULL)
+	if(tree->node.nchildren == 0)
 		return -1;
 
 	if(realpath(path, real_path) != real_path)
 		return -1;
 
-	node = find_node(&tree->node, real_path, 0, tree->longest ? &last : NULL);
+	node = find_node(tree, real_path, 0, tree->longest ? &last : NULL);
 	if((node == NULL || !node->valid) && last == NULL)
 		return -1;
 
@@ -140,64 +211,165 @@ tree_get_data(tree_t tree, const char *path, tree_val_t *data)
 	return 0;
 }
 
+/* Walks the tree along the path optionally creating missing nodes.  *last is
+ * set to the deepest valid node on the way.  Returns the node or NULL if it
+ * doesn't exist or can't be created. */
 static node_t *
-find_node(node_t *root, const char *name, int create, node_t **last)
+find_node(tree_t tree, const char *name, int create, node_t **last)
 {
-	const char *end;
-	size_t name_len;
-	node_t *prev = NULL, *curr;
-	node_t *new_node;
+	node_t *node = &tree->node;
+
+	while(1)
+	{
+		const char *end;
+		size_t name_len;
+		int pos;
 
-	name = skip_char(name, '/');
-	if(*name == '\0')
-		return root;
+		name = skip_char(name, '/');
+		if(*name == '\0')
+			return node;
 
-	end = until_first(name, '/');
+		end = until_first(name, '/');
+		name_len = end - name;
 
-	name_len = end - name;
-	curr = root->child;
-	while(curr != NULL)
+		if(find_child(node, name, name_len, &pos) == 0)
+		{
+			node = node->children[pos];
+			if(node->valid && last != NULL)
+				*last = node;
+		}
+		else if(!create)
+		{
+			return NULL;
+		}
+		else if((node = add_child(tree, node, pos, name, name_len)) == NULL)
+		{
+			return NULL;
+		}
+
+		name = end;
+	}
+}
+
+/* Looks up child of the node by name using binary search.  Sets *pos to
+ * position of the child or to position at which it should be inserted.
+ * Returns zero if child is found, otherwise non-zero is returned. */
+static int
+find_child(const node_t *node, const char name[], size_t name_len, int *pos)
+{
+	int l = 0, u = node->nchildren;
+
+	while(l < u)
 	{
-		int comp = strnoscmp(name, curr->name, name_len);
-		if(comp == 0 && curr->name_len == name_len)
+		const int m = l + (u - l)/2;
+		const node_t *const child = node->children[m];
+		int comp = strnoscmp(name, child->name, name_len);
+		if(comp == 0 && name_len != child->name_len)
 		{
-			if(curr->valid && last != NULL)
-				*last = curr;
-			return find_node(curr, end, create, last);
+			/* The name is a prefix of child's name. */
+			comp = -1;
 		}
-		else if(comp < 0)
+
+		if(comp == 0)
 		{
-			break;
+			*pos = m;
+			return 0;
 		}
-		prev = curr;
-		curr = curr->next;
+
+		if(comp < 0)
+			u = m;
+		else
+			l = m + 1;
+	}
+
+	*pos = l;
+	return 1;
+}
+
+/* Inserts new child into the node at specified position.  Returns the child or
+ * NULL on error. */
+static node_t *
+add_child(tree_t tree, node_t *node, int pos, const char name[],
+		size_t name_len)
+{
+	node_t *child;
+
+	if(node->nchildren == node->children_cap)
+	{
+		const int new_cap = (node->children_cap == 0) ? 4 : node->children_cap*2;
+		node_t **const children = reallocarray(node->children, new_cap,
+				sizeof(*children));
+		if(children == NULL)
+			return NULL;
+		node->children = children;
+		node->children_cap = new_cap;
 	}
 
-	if(!create)
+	if((child = alloc_node(tree)) == NULL)
 		return NULL;
 
-	new_node = malloc(sizeof(*new_node));
-	if(new_node == NULL)
+	if((child->name = alloc_name(tree, name_len)) == NULL)
 		return NULL;
+	memcpy(child->name, name, name_len);
+	child->name[name_len] = '\0';
+	child->name_len = name_len;
 
-	if((new_node->name = malloc(name_len + 1)) == NULL)
+	memmove(node->children + pos + 1, node->children + pos,
+			sizeof(*node->children)*(node->nchildren - pos));
+	node->children[pos] = child;
+	++node->nchildren;
+
+	return child;
+}
+
+/* Takes empty node from the pool.  Returns the node or NULL on error. */
+static node_t *
+alloc_node(tree_t tree)
+{
+	node_t *node;
+
+	if(tree->nodes == NULL || tree->nodes->used == NODES_PER_BLOCK)
 	{
-		free(new_node);
-		return NULL;
+		nodes_block_t *const block = malloc(sizeof(*block));
+		if(block == NULL)
+			return NULL;
+		block->prev = tree->nodes;
+		block->used = 0;
+		tree->nodes = block;
+	}
+
+	node = &tree->nodes->nodes[tree->nodes->used++];
+	node->name = NULL;
+	node->name_len = 0;
+	node->valid = 0;
+	node->children = NULL;
+	node->nchildren = 0;
+	node->children_cap = 0;
+	return node;
+}
+
+/* Takes storage for name of specified length plus terminating null character
+ * from the pool.  Returns the storage or NULL on error. */
+static char *
+alloc_name(tree_t tree, size_t len)
+{
+	char *name;
+
+	if(tree->names == NULL || tree->names->size - tree->names->used < len + 1)
+	{
+		const size_t size = MAX(NAMES_BLOCK_SIZE, len + 1);
+		names_block_t *const block = malloc(sizeof(*block) + size);
+		if(block == NULL)
+			return NULL;
+		block->prev = tree->names;
+		block->used = 0;
+		block->size = size;
+		tree->names = block;
 	}
-	strncpy(new_node->name, name, name_len);
-	new_node->name[name_len] = '\0';
-	new_node->name_len = name_len;
-	new_node->valid = 0;
-	new_node->child = NULL;
-	new_node->next = curr;
-
-	if(root->child == curr)
-		root->child = new_node;
-	else
-		prev->next = new_node;
 
-	return find_node(new_node, end, create, last);
+	name = &tree->names->data[tree->names->used];
+	tree->names->used += len + 1;
+	return name;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
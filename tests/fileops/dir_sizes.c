@@ -0,0 +1,122 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() unlink() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() */
+
+#include "../../src/cfg/dirsizes.h"
+#include "../../src/compat/os.h"
+#include "../../src/ops.h"
+
+static void create_file(const char path[], const char contents[]);
+static void assert_size(const char path[], uint64_t size, int exact);
+
+SETUP()
+{
+	assert_success(dirsizes_reset());
+
+	assert_success(os_mkdir(SANDBOX_PATH "/a", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/a/b", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/a/c", 0700));
+	create_file(SANDBOX_PATH "/a/b/f", "0123456789");
+}
+
+TEARDOWN()
+{
+	(void)unlink(SANDBOX_PATH "/a/b/f");
+	(void)unlink(SANDBOX_PATH "/a/c/f");
+	(void)unlink(SANDBOX_PATH "/a/f");
+	(void)rmdir(SANDBOX_PATH "/a/b");
+	assert_success(rmdir(SANDBOX_PATH "/a/c"));
+	assert_success(rmdir(SANDBOX_PATH "/a"));
+
+	assert_success(dirsizes_reset());
+}
+
+TEST(removal_decreases_sizes_of_ancestors)
+{
+	dirsizes_set(SANDBOX_PATH "/a", 100, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/a/b", 50, 1, NULL);
+
+	assert_success(perform_operation(OP_REMOVESL, NULL, NULL,
+				SANDBOX_PATH "/a/b/f", NULL));
+
+	assert_size(SANDBOX_PATH "/a", 90, 1);
+	assert_size(SANDBOX_PATH "/a/b", 40, 1);
+}
+
+TEST(copying_increases_sizes_of_ancestors)
+{
+	dirsizes_set(SANDBOX_PATH "/a", 100, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/a/b", 50, 1, NULL);
+
+	assert_success(perform_operation(OP_COPY, NULL, NULL, SANDBOX_PATH "/a/b/f",
+				SANDBOX_PATH "/a/f"));
+
+	assert_size(SANDBOX_PATH "/a", 110, 1);
+	assert_size(SANDBOX_PATH "/a/b", 50, 1);
+}
+
+TEST(moving_keeps_sizes_of_common_ancestors)
+{
+	dirsizes_set(SANDBOX_PATH "/a", 100, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/a/b", 50, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/a/c", 0, 1, NULL);
+
+	assert_success(perform_operation(OP_MOVE, NULL, NULL, SANDBOX_PATH "/a/b/f",
+				SANDBOX_PATH "/a/c/f"));
+
+	assert_size(SANDBOX_PATH "/a", 100, 1);
+	assert_size(SANDBOX_PATH "/a/b", 40, 1);
+	assert_size(SANDBOX_PATH "/a/c", 10, 1);
+}
+
+TEST(removal_of_directory_of_unknown_size_makes_estimates)
+{
+	dirsizes_set(SANDBOX_PATH "/a", 100, 1, NULL);
+
+	assert_success(perform_operation(OP_REMOVESL, NULL, NULL,
+				SANDBOX_PATH "/a/b", NULL));
+
+	assert_size(SANDBOX_PATH "/a", 100, 0);
+}
+
+TEST(copy_of_directory_of_known_size_gets_the_size)
+{
+	dirsizes_set(SANDBOX_PATH "/a", 100, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/a/b", 10, 1, NULL);
+	assert_success(rmdir(SANDBOX_PATH "/a/c"));
+
+	assert_success(perform_operation(OP_COPY, NULL, NULL, SANDBOX_PATH "/a/b",
+				SANDBOX_PATH "/a/c"));
+
+	assert_size(SANDBOX_PATH "/a", 110, 1);
+	assert_size(SANDBOX_PATH "/a/c", 10, 1);
+}
+
+static void
+create_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+static void
+assert_size(const char path[], uint64_t size, int exact)
+{
+	uint64_t actual_size;
+	int actual_exact;
+
+	assert_success(dirsizes_get(path, &actual_size, &actual_exact));
+	assert_int_equal(size, actual_size);
+	assert_int_equal(exact, actual_exact);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
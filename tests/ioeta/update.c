@@ -60,6 +60,27 @@ TEST(update_increments_current_byte)
 	assert_int_equal(prev + 134, estim->current_byte);
 }
 
+TEST(skip_decrements_total_bytes)
+{
+	ioeta_add_file(estim, TEST_DATA_PATH "/read/binary-data");
+	ioeta_update(estim, TEST_DATA_PATH "/read/binary-data", "x", 0, 24);
+
+	ioeta_skip(estim, 1000);
+	assert_int_equal(24, estim->total_bytes);
+	assert_int_equal(24, estim->total_file_bytes);
+	assert_int_equal(24, estim->current_byte);
+}
+
+TEST(skip_does_not_go_below_processed_bytes)
+{
+	ioeta_add_file(estim, TEST_DATA_PATH "/read/binary-data");
+	ioeta_update(estim, TEST_DATA_PATH "/read/binary-data", "x", 0, 1000);
+
+	ioeta_skip(estim, 1000);
+	assert_int_equal(1000, estim->total_bytes);
+	assert_int_equal(1000, estim->current_byte);
+}
+
 TEST(update_sets_paths)
 {
 	assert_string_equal(NULL, estim->item);
@@ -1,20 +1,40 @@
 #include <stic.h>
 
 #include <sys/stat.h> /* chmod() */
+#include <sys/time.h> /* gettimeofday() timeval */
 
 #include <sys/types.h> /* stat */
 #include <sys/stat.h> /* stat */
-#include <unistd.h> /* lstat() */
+#include <unistd.h> /* ftruncate() lstat() truncate() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE SEEK_SET fclose() fileno() fopen() fputc() fseek()
+                      fwrite() printf() */
+#include <stdlib.h> /* getenv() */
+#include <string.h> /* memset() */
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/iop.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/utils.h"
 
 #include "utils.h"
 
+/* Size of a file that is copied in several chunks by every method. */
+#define LARGE_FILE_SIZE (17*1024*1024 + 1)
+
+/* Size of a file that consists mostly of holes. */
+#define SPARSE_FILE_SIZE (32*1024*1024)
+
 static void file_is_copied(const char original[]);
+static void file_is_copied_by(const char original[], int methods);
+static void create_large_file(const char path[]);
+static void create_sparse_file(const char path[]);
+static uint64_t allocated(const char path[]);
+static double time_copying(const char src[], const char dst[], int methods);
+static double get_time(void);
 
 static int not_windows(void);
 
@@ -152,9 +172,124 @@ TEST(double_block_size_plus_one_file_is_copied)
 			"/various-sizes/double-block-size-plus-one-file");
 }
 
+TEST(large_file_is_copied_with_progress_by_every_method)
+{
+	const int methods[] = {
+		IO_CP_ALL, IO_CP_CLONE, IO_CP_RANGE, IO_CP_SENDFILE, IO_CP_PIPELINE, 0
+	};
+	int i;
+
+	create_large_file(SANDBOX_PATH "/large");
+
+	for(i = 0; i < (int)(sizeof(methods)/sizeof(methods[0])); ++i)
+	{
+		ioeta_estim_t *const estim = ioeta_alloc(NULL);
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/large",
+			.arg2.dst = SANDBOX_PATH "/large-copy",
+
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		iop_cp_methods = methods[i];
+		assert_success(iop_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+		assert_true(estim->current_byte == LARGE_FILE_SIZE);
+		ioeta_free(estim);
+
+		assert_true(files_are_identical(SANDBOX_PATH "/large-copy",
+					SANDBOX_PATH "/large"));
+		delete_test_file(SANDBOX_PATH "/large-copy");
+	}
+	iop_cp_methods = IO_CP_DEFAULT;
+
+	delete_test_file(SANDBOX_PATH "/large");
+}
+
+TEST(pipelined_copying_is_compared_with_plain_loop)
+{
+	double pipelined_time, plain_time;
+
+	create_large_file(SANDBOX_PATH "/large");
+
+	pipelined_time = time_copying(SANDBOX_PATH "/large",
+			SANDBOX_PATH "/large-copy", IO_CP_PIPELINE);
+	plain_time = time_copying(SANDBOX_PATH "/large", SANDBOX_PATH "/large-copy",
+			0);
+
+	delete_test_file(SANDBOX_PATH "/large");
+
+	/* Set BENCHMARK environment variable to see the difference. */
+	if(getenv("BENCHMARK") != NULL)
+	{
+		printf("%d bytes: pipelined %.3f ms, read/write loop %.3f ms\n",
+				LARGE_FILE_SIZE, pipelined_time*1000.0, plain_time*1000.0);
+	}
+}
+
+TEST(holes_of_sparse_files_are_preserved_by_every_method, IF(not_windows))
+{
+	const int methods[] = {
+		IO_CP_ALL, IO_CP_CLONE, IO_CP_RANGE, IO_CP_SENDFILE, IO_CP_PIPELINE, 0
+	};
+	int i;
+
+	create_sparse_file(SANDBOX_PATH "/sparse");
+
+	for(i = 0; i < (int)(sizeof(methods)/sizeof(methods[0])); ++i)
+	{
+		ioeta_estim_t *const estim = ioeta_alloc(NULL);
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/sparse",
+			.arg2.dst = SANDBOX_PATH "/sparse-copy",
+
+			.estim = estim,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		ioeta_calculate(estim, SANDBOX_PATH "/sparse", 0);
+		assert_true(estim->total_bytes == SPARSE_FILE_SIZE);
+
+		iop_cp_methods = methods[i];
+		assert_success(iop_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+
+		/* Only data is counted unless holes are shared by cloning. */
+		assert_true(estim->current_byte == estim->total_bytes);
+		if(estim->current_byte != SPARSE_FILE_SIZE)
+		{
+			assert_true(estim->current_byte < SPARSE_FILE_SIZE/2);
+		}
+		ioeta_free(estim);
+
+		assert_true(files_are_identical(SANDBOX_PATH "/sparse-copy",
+					SANDBOX_PATH "/sparse"));
+		assert_true(allocated(SANDBOX_PATH "/sparse-copy") < SPARSE_FILE_SIZE/2);
+		delete_test_file(SANDBOX_PATH "/sparse-copy");
+	}
+	iop_cp_methods = IO_CP_DEFAULT;
+
+	delete_test_file(SANDBOX_PATH "/sparse");
+}
+
+/* Checks that file is copied by all the methods. */
 static void
 file_is_copied(const char original[])
 {
+	file_is_copied_by(original, IO_CP_ALL);
+	file_is_copied_by(original, IO_CP_CLONE);
+	file_is_copied_by(original, IO_CP_RANGE);
+	file_is_copied_by(original, IO_CP_SENDFILE);
+	file_is_copied_by(original, IO_CP_PIPELINE);
+	file_is_copied_by(original, 0);
+}
+
+static void
+file_is_copied_by(const char original[], int methods)
+{
+	iop_cp_methods = methods;
+
 	{
 		io_args_t args = {
 			.arg1.src = original,
@@ -167,11 +302,92 @@ file_is_copied(const char original[])
 		assert_int_equal(0, args.result.errors.error_count);
 	}
 
+	iop_cp_methods = IO_CP_DEFAULT;
+
 	assert_true(files_are_identical(SANDBOX_PATH "/copy", original));
 
 	delete_test_file(SANDBOX_PATH "/copy");
 }
 
+/* Makes a file of SPARSE_FILE_SIZE bytes with data only at the beginning and in
+ * the middle. */
+static void
+create_sparse_file(const char path[])
+{
+	char data[8192];
+	FILE *const f = fopen(path, "wb");
+
+	memset(data, 'x', sizeof(data));
+
+	assert_non_null(f);
+	assert_int_equal(sizeof(data), fwrite(data, 1, sizeof(data), f));
+	assert_success(fseek(f, SPARSE_FILE_SIZE/2, SEEK_SET));
+	assert_int_equal(sizeof(data), fwrite(data, 1, sizeof(data), f));
+	assert_success(ftruncate(fileno(f), SPARSE_FILE_SIZE));
+	assert_success(fclose(f));
+
+	assert_true(allocated(path) < SPARSE_FILE_SIZE/2);
+}
+
+/* Queries space allocated for a file.  Returns the size. */
+static uint64_t
+allocated(const char path[])
+{
+	struct stat st;
+	assert_success(lstat(path, &st));
+	return (uint64_t)st.st_blocks*512U;
+}
+
+/* Copies src to dst using specified methods, checks the result and removes
+ * the copy.  Returns time spent on copying in seconds. */
+static double
+time_copying(const char src[], const char dst[], int methods)
+{
+	double time;
+	io_args_t args = {
+		.arg1.src = src,
+		.arg2.dst = dst,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	iop_cp_methods = methods;
+	time = get_time();
+	assert_success(iop_cp(&args));
+	time = get_time() - time;
+	iop_cp_methods = IO_CP_DEFAULT;
+
+	assert_int_equal(0, args.result.errors.error_count);
+	assert_true(files_are_identical(dst, src));
+	delete_test_file(dst);
+
+	return time;
+}
+
+/* Retrieves current time.  Returns it in seconds. */
+static double
+get_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+/* Makes a file of LARGE_FILE_SIZE bytes that doesn't repeat on block
+ * boundaries. */
+static void
+create_large_file(const char path[])
+{
+	FILE *const f = fopen(path, "wb");
+	uint64_t i;
+
+	assert_non_null(f);
+	for(i = 0U; i < LARGE_FILE_SIZE; ++i)
+	{
+		fputc((int)(i%251U), f);
+	}
+	assert_success(fclose(f));
+}
+
 TEST(appending_works_for_files)
 {
 	uint64_t size;
@@ -216,6 +432,35 @@ TEST(appending_works_for_files)
 	delete_test_file(SANDBOX_PATH "/appending");
 }
 
+TEST(appending_large_file_by_pipeline_continues_from_destination_size,
+     IF(not_windows))
+{
+	create_large_file(SANDBOX_PATH "/large");
+	clone_test_file(SANDBOX_PATH "/large", SANDBOX_PATH "/large-copy");
+	assert_success(truncate(SANDBOX_PATH "/large-copy", LARGE_FILE_SIZE/3));
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/large",
+			.arg2.dst = SANDBOX_PATH "/large-copy",
+			.arg3.crs = IO_CRS_APPEND_TO_FILES,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		iop_cp_methods = IO_CP_PIPELINE;
+		assert_success(iop_cp(&args));
+		iop_cp_methods = IO_CP_DEFAULT;
+
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_true(files_are_identical(SANDBOX_PATH "/large-copy",
+				SANDBOX_PATH "/large"));
+
+	delete_test_file(SANDBOX_PATH "/large-copy");
+	delete_test_file(SANDBOX_PATH "/large");
+}
+
 TEST(appending_does_not_shrink_files)
 {
 	uint64_t size;
@@ -0,0 +1,228 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* chmod() stat() */
+#include <pthread.h> /* pthread_equal() pthread_self() pthread_t */
+#include <unistd.h> /* F_OK access() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
+#include "../../src/io/ior.h"
+
+#include "utils.h"
+
+#define NFILES 40
+
+static int confirm_overwrite(io_args_t *args, const char src[],
+		const char dst[]);
+static void create_tree(const char root[]);
+static void create_file(const char path[], const char contents[]);
+static int not_windows(void);
+
+static int confirm_calls;
+static int confirm_on_other_thread;
+static pthread_t main_thread;
+
+SETUP()
+{
+	confirm_calls = 0;
+	confirm_on_other_thread = 0;
+	main_thread = pthread_self();
+
+	create_tree(SANDBOX_PATH "/src");
+}
+
+TEARDOWN()
+{
+	assert_success(chmod(SANDBOX_PATH "/src/ro", 0700));
+	delete_tree(SANDBOX_PATH "/src");
+}
+
+TEST(tree_is_copied_by_several_threads, IF(not_windows))
+{
+	struct stat st;
+	char path[PATH_MAX];
+	int i;
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+
+			.max_jobs = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dst/sub/%d", i);
+		assert_success(access(path, F_OK));
+	}
+
+	/* Files are added to read-only directory before its permissions are
+	 * copied. */
+	assert_success(access(SANDBOX_PATH "/dst/ro/file", F_OK));
+	assert_success(stat(SANDBOX_PATH "/dst/ro", &st));
+	assert_int_equal(0500, st.st_mode & 0777);
+
+	assert_success(chmod(SANDBOX_PATH "/dst/ro", 0700));
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(progress_of_parallel_copying_is_reported, IF(not_windows))
+{
+	ioeta_estim_t *const estim = ioeta_alloc(NULL);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/src",
+		.arg2.dst = SANDBOX_PATH "/dst",
+
+		.max_jobs = 4,
+		.estim = estim,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	ioeta_calculate(estim, SANDBOX_PATH "/src", 0);
+	assert_true(estim->total_bytes > 0U);
+
+	assert_success(ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_true(estim->current_byte == estim->total_bytes);
+	assert_int_equal(estim->total_items, estim->current_item);
+
+	ioeta_free(estim);
+
+	assert_success(chmod(SANDBOX_PATH "/dst/ro", 0700));
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(errors_of_all_files_are_collected, IF(not_windows))
+{
+	char path[PATH_MAX];
+	int i;
+
+	/* Files can't replace non-empty directories. */
+	assert_success(os_mkdir(SANDBOX_PATH "/dst", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dst/sub", 0700));
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dst/sub/%d", i);
+		assert_success(os_mkdir(path, 0700));
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dst/sub/%d/file", i);
+		create_file(path, "");
+	}
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.arg3.crs = IO_CRS_REPLACE_FILES,
+
+			.max_jobs = 4,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_failure(ior_cp(&args));
+		assert_true(args.result.errors.error_count > 0U);
+		ioe_errlst_free(&args.result.errors);
+	}
+
+	(void)chmod(SANDBOX_PATH "/dst/ro", 0700);
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(confirmations_are_asked_on_calling_thread, IF(not_windows))
+{
+	create_tree(SANDBOX_PATH "/dst");
+	assert_success(chmod(SANDBOX_PATH "/dst/ro", 0700));
+
+	{
+		io_args_t args = {
+			.arg1.src = SANDBOX_PATH "/src",
+			.arg2.dst = SANDBOX_PATH "/dst",
+			.arg3.crs = IO_CRS_REPLACE_FILES,
+
+			.max_jobs = 4,
+			.confirm = &confirm_overwrite,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_cp(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_int_equal(NFILES + 1, confirm_calls);
+	assert_false(confirm_on_other_thread);
+
+	assert_success(chmod(SANDBOX_PATH "/dst/ro", 0700));
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+static int
+confirm_overwrite(io_args_t *args, const char src[], const char dst[])
+{
+	++confirm_calls;
+	if(!pthread_equal(pthread_self(), main_thread))
+	{
+		confirm_on_other_thread = 1;
+	}
+	return 1;
+}
+
+/* Creates directory with many files in a subdirectory and a read-only
+ * subdirectory. */
+static void
+create_tree(const char root[])
+{
+	char path[PATH_MAX];
+	int i;
+
+	assert_success(os_mkdir(root, 0700));
+
+	snprintf(path, sizeof(path), "%s/sub", root);
+	assert_success(os_mkdir(path, 0700));
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/sub/%d", root, i);
+		create_file(path, "contents");
+	}
+
+	snprintf(path, sizeof(path), "%s/ro", root);
+	assert_success(os_mkdir(path, 0700));
+	snprintf(path, sizeof(path), "%s/ro/file", root);
+	create_file(path, "read-only");
+	snprintf(path, sizeof(path), "%s/ro", root);
+	assert_success(chmod(path, 0500));
+}
+
+static void
+create_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
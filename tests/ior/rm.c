@@ -1,7 +1,11 @@
 #include <stic.h>
 
-#include <unistd.h> /* F_OK access() */
+#include <unistd.h> /* F_OK access() symlink() */
 
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strlen() */
+
+#include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
 #include "../../src/io/ior.h"
 #include "../../src/utils/fs.h"
@@ -11,6 +15,12 @@
 #define DIRECTORY_NAME SANDBOX_PATH "/directory-to-remove"
 #define FILE_NAME "file-to-remove"
 
+/* Nesting level of a tree which is deep enough to require many open
+ * directories at once. */
+#define DEEP_TREE_DEPTH 500
+
+static int not_windows(void);
+
 TEST(file_is_removed)
 {
 	create_empty_file(SANDBOX_PATH "/" FILE_NAME);
@@ -65,5 +75,68 @@ TEST(non_empty_directory_is_removed)
 	assert_failure(access(DIRECTORY_NAME, F_OK));
 }
 
+TEST(deep_directory_tree_is_removed)
+{
+	char path[PATH_MAX];
+	int i;
+
+	snprintf(path, sizeof(path), "%s", DIRECTORY_NAME);
+	assert_success(os_mkdir(path, 0700));
+	for(i = 0; i < DEEP_TREE_DEPTH; ++i)
+	{
+		const size_t len = strlen(path);
+		snprintf(path + len, sizeof(path) - len, "/d");
+		assert_success(os_mkdir(path, 0700));
+	}
+	snprintf(path + strlen(path), sizeof(path) - strlen(path), "/" FILE_NAME);
+	create_empty_file(path);
+	assert_success(access(path, F_OK));
+
+	{
+		io_args_t args = {
+			.arg1.src = DIRECTORY_NAME,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_failure(access(DIRECTORY_NAME, F_OK));
+}
+
+TEST(symbolic_links_to_directories_are_not_followed, IF(not_windows))
+{
+	os_mkdir(DIRECTORY_NAME, 0700);
+	os_mkdir(SANDBOX_PATH "/target", 0700);
+	create_empty_file(SANDBOX_PATH "/target/" FILE_NAME);
+	assert_success(symlink(SANDBOX_PATH "/target", DIRECTORY_NAME "/link"));
+
+	{
+		io_args_t args = {
+			.arg1.src = DIRECTORY_NAME,
+		};
+		ioe_errlst_init(&args.result.errors);
+
+		assert_success(ior_rm(&args));
+		assert_int_equal(0, args.result.errors.error_count);
+	}
+
+	assert_failure(access(DIRECTORY_NAME, F_OK));
+	assert_success(access(SANDBOX_PATH "/target/" FILE_NAME, F_OK));
+
+	delete_tree(SANDBOX_PATH "/target");
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
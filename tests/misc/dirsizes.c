@@ -0,0 +1,221 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() unlink() */
+#include <utime.h> /* utimbuf utime() */
+
+#include <stdint.h> /* uint64_t */
+
+#include "../../src/cfg/config.h"
+#include "../../src/cfg/dirsizes.h"
+#include "../../src/compat/os.h"
+#include "../../src/utils/str.h"
+#include "../../src/opt_handlers.h"
+
+static void set_mtime(const char path[], time_t mtime);
+
+SETUP()
+{
+	copy_str(cfg.config_dir, sizeof(cfg.config_dir), SANDBOX_PATH);
+	cfg.vifm_info = VIFMINFO_DIRSIZES;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/a", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/b", 0700));
+	set_mtime(SANDBOX_PATH "/a", 1000);
+	set_mtime(SANDBOX_PATH "/b", 1000);
+
+	assert_success(dirsizes_reset());
+}
+
+TEARDOWN()
+{
+	assert_success(dirsizes_reset());
+
+	assert_success(rmdir(SANDBOX_PATH "/a"));
+	assert_success(rmdir(SANDBOX_PATH "/b"));
+	(void)unlink(SANDBOX_PATH "/dirsizes");
+	(void)unlink(SANDBOX_PATH "/dirsizes.du");
+
+	cfg.disk_usage = 0;
+	cfg.vifm_info = 0;
+	cfg.config_dir[0] = '\0';
+}
+
+TEST(sizes_are_known_after_they_are_set)
+{
+	uint64_t size;
+
+	assert_failure(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	assert_int_equal(10, size);
+}
+
+TEST(sizes_are_read_back_from_the_file)
+{
+	uint64_t size;
+
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	dirsizes_write();
+	assert_success(dirsizes_reset());
+
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	assert_int_equal(10, size);
+}
+
+TEST(sizes_of_changed_directories_are_dropped)
+{
+	uint64_t size;
+
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/b", 20, 1, NULL);
+	dirsizes_write();
+	assert_success(dirsizes_reset());
+
+	set_mtime(SANDBOX_PATH "/a", 2000);
+
+	assert_failure(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	assert_success(dirsizes_get(SANDBOX_PATH "/b", &size, NULL));
+	assert_int_equal(20, size);
+
+	/* Stale size isn't written back. */
+	dirsizes_write();
+	assert_success(dirsizes_reset());
+	set_mtime(SANDBOX_PATH "/a", 1000);
+	assert_failure(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+}
+
+TEST(sizes_that_were_not_looked_up_are_not_lost)
+{
+	uint64_t size;
+
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	dirsizes_write();
+	assert_success(dirsizes_reset());
+
+	dirsizes_set(SANDBOX_PATH "/b", 20, 1, NULL);
+	dirsizes_write();
+	assert_success(dirsizes_reset());
+
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	assert_int_equal(10, size);
+	assert_success(dirsizes_get(SANDBOX_PATH "/b", &size, NULL));
+	assert_int_equal(20, size);
+}
+
+TEST(new_sizes_override_sizes_from_the_file)
+{
+	uint64_t size;
+
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	dirsizes_write();
+	assert_success(dirsizes_reset());
+
+	dirsizes_set(SANDBOX_PATH "/a", 30, 1, NULL);
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	assert_int_equal(30, size);
+}
+
+TEST(updates_are_propagated_to_known_ancestors)
+{
+	uint64_t size;
+	int exact;
+
+	dirsizes_set(SANDBOX_PATH, 100, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+
+	dirsizes_update(SANDBOX_PATH "/a", 5, 1, NULL);
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, &exact));
+	assert_int_equal(15, size);
+	assert_true(exact);
+	assert_success(dirsizes_get(SANDBOX_PATH, &size, &exact));
+	assert_int_equal(105, size);
+	assert_true(exact);
+
+	dirsizes_update(SANDBOX_PATH "/a", -20, 0, NULL);
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, &exact));
+	assert_int_equal(0, size);
+	assert_false(exact);
+	assert_success(dirsizes_get(SANDBOX_PATH, &size, &exact));
+	assert_int_equal(85, size);
+	assert_false(exact);
+}
+
+TEST(updates_stop_at_common_ancestor)
+{
+	uint64_t size;
+	int exact;
+
+	dirsizes_set(SANDBOX_PATH, 100, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+
+	dirsizes_update(SANDBOX_PATH "/a", 5, 0, SANDBOX_PATH "/b");
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, &exact));
+	assert_int_equal(15, size);
+	assert_false(exact);
+	assert_success(dirsizes_get(SANDBOX_PATH, &size, &exact));
+	assert_int_equal(100, size);
+	assert_true(exact);
+}
+
+TEST(estimates_are_read_back_from_the_file)
+{
+	uint64_t size;
+	int exact;
+
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	dirsizes_set(SANDBOX_PATH "/b", 20, 1, NULL);
+	dirsizes_update(SANDBOX_PATH "/a", 1, 0, NULL);
+	dirsizes_write();
+	assert_success(dirsizes_reset());
+
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, &exact));
+	assert_int_equal(11, size);
+	assert_false(exact);
+	assert_success(dirsizes_get(SANDBOX_PATH "/b", &size, &exact));
+	assert_int_equal(20, size);
+	assert_true(exact);
+}
+
+TEST(disk_usage_sizes_are_stored_separately)
+{
+	uint64_t size;
+
+	cfg.disk_usage = 1;
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	dirsizes_write();
+	assert_success(os_access(SANDBOX_PATH "/dirsizes.du", R_OK));
+	assert_failure(os_access(SANDBOX_PATH "/dirsizes", R_OK));
+	assert_success(dirsizes_reset());
+
+	cfg.disk_usage = 0;
+	assert_failure(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	assert_success(dirsizes_reset());
+
+	cfg.disk_usage = 1;
+	assert_success(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+	assert_int_equal(10, size);
+}
+
+TEST(file_is_not_used_without_vifminfo_flag)
+{
+	uint64_t size;
+
+	cfg.vifm_info = 0;
+
+	dirsizes_set(SANDBOX_PATH "/a", 10, 1, NULL);
+	dirsizes_write();
+	assert_failure(os_access(SANDBOX_PATH "/dirsizes", R_OK));
+	assert_success(dirsizes_reset());
+
+	assert_failure(dirsizes_get(SANDBOX_PATH "/a", &size, NULL));
+}
+
+static void
+set_mtime(const char path[], time_t mtime)
+{
+	struct utimbuf times = { .actime = mtime, .modtime = mtime };
+	assert_success(utime(path, &times));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,193 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/str_arena.h"
+#include "../../src/filelist.h"
+
+#define NFILES 100
+
+static void free_entries(FileView *view);
+static void create_file(const char name[]);
+
+static FileView *const view = &lwin;
+static size_t empty_usage;
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+	int i;
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	cfg.fuse_home = strdup("no");
+	cfg.slow_fs_list = strdup("");
+
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%03d", i);
+		create_file(name);
+	}
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	view->names = str_arena_create();
+	assert_non_null(view->names);
+	empty_usage = str_arena_mem_usage(view->names);
+}
+
+TEARDOWN()
+{
+	int i;
+
+	free_entries(view);
+	str_arena_free(view->names);
+	view->names = NULL;
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+	free(cfg.fuse_home);
+	cfg.fuse_home = NULL;
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%03d", i);
+		assert_success(unlink(name));
+	}
+}
+
+TEST(names_are_allocated_in_arena_of_the_view)
+{
+	int i;
+
+	populate_dir_list(view, 0);
+	assert_true(view->list_rows >= NFILES);
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		assert_true(str_arena_owns(view->names, view->dir_entry[i].name));
+	}
+}
+
+TEST(memory_of_list_is_freed_along_with_it)
+{
+	populate_dir_list(view, 0);
+	assert_true(str_arena_mem_usage(view->names) > empty_usage);
+
+	free_entries(view);
+	assert_int_equal(empty_usage, str_arena_mem_usage(view->names));
+}
+
+TEST(reloading_releases_memory_of_previous_list)
+{
+	size_t usage;
+	int i;
+
+	populate_dir_list(view, 0);
+	usage = str_arena_mem_usage(view->names);
+
+	for(i = 0; i < 10; ++i)
+	{
+		populate_dir_list(view, 1);
+		assert_true(str_arena_mem_usage(view->names) <= usage);
+	}
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		assert_true(str_arena_owns(view->names, view->dir_entry[i].name));
+	}
+}
+
+TEST(renamed_entry_stays_in_arena)
+{
+	populate_dir_list(view, 0);
+
+	assert_success(fentry_rename(view, &view->dir_entry[0], "renamed"));
+	assert_string_equal("renamed", view->dir_entry[0].name);
+	assert_true(str_arena_owns(view->names, view->dir_entry[0].name));
+
+	free_entries(view);
+	assert_int_equal(empty_usage, str_arena_mem_usage(view->names));
+}
+
+TEST(origins_of_custom_view_are_interned)
+{
+	size_t usage;
+
+	flist_custom_start(view, "test");
+	flist_custom_add(view, TEST_DATA_PATH "/existing-files/a");
+	flist_custom_add(view, TEST_DATA_PATH "/existing-files/b");
+	flist_custom_add(view, TEST_DATA_PATH "/existing-files/c");
+	assert_success(flist_custom_finish(view, 0));
+
+	assert_true(view->list_rows >= 3);
+	assert_true(view->dir_entry[0].origin == view->dir_entry[1].origin);
+	assert_true(view->dir_entry[1].origin == view->dir_entry[2].origin);
+	assert_true(str_arena_owns(view->names, view->dir_entry[0].origin));
+
+	/* Replacing custom view doesn't keep memory of the previous one. */
+	usage = str_arena_mem_usage(view->names);
+	flist_custom_start(view, "test");
+	flist_custom_add(view, TEST_DATA_PATH "/existing-files/a");
+	flist_custom_add(view, TEST_DATA_PATH "/existing-files/b");
+	flist_custom_add(view, TEST_DATA_PATH "/existing-files/c");
+	assert_success(flist_custom_finish(view, 0));
+	assert_true(str_arena_mem_usage(view->names) <= usage);
+
+	free(view->custom.orig_dir);
+	view->custom.orig_dir = NULL;
+	free(view->custom.title);
+	view->custom.title = NULL;
+}
+
+/* Frees entries of the view leaving it with an empty list. */
+static void
+free_entries(FileView *view)
+{
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		free_dir_entry(view, &view->dir_entry[i]);
+	}
+	dynarray_free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+}
+
+static void
+create_file(const char name[])
+{
+	FILE *const f = fopen(name, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
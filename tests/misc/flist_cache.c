@@ -0,0 +1,319 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() rmdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/filemon.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_cache.h"
+
+static void create_file(const char name[]);
+static void free_entries(dir_entry_t *entries, int count);
+static int not_cancelled(void *arg);
+static int cancelled(void *arg);
+
+static FileView *const view = &lwin;
+static filemon_t mon;
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	cfg.slow_fs_list = strdup("");
+	cfg.list_cache_size = 1024;
+
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+
+	create_file("a");
+	create_file("b");
+	assert_success(os_mkdir("dir", 0700));
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->hide_dot = 1;
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	populate_dir_list(view, 0);
+	assert_int_equal(3, view->list_rows);
+	assert_success(filemon_from_file(view->curr_dir, &mon));
+}
+
+TEARDOWN()
+{
+	cfg.list_cache_size = 0;
+	flist_cache_trim();
+
+	free_entries(view->dir_entry, view->list_rows);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+
+	assert_success(unlink("a"));
+	assert_success(unlink("b"));
+	assert_success(rmdir("dir"));
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+}
+
+TEST(list_can_be_taken_back)
+{
+	dir_entry_t *entries;
+	int count, filtered, raw;
+
+	flist_cache_put(view, &mon);
+	assert_true(flist_cache_get_mem_usage() != 0U);
+
+	assert_success(flist_cache_take(view, &mon, &entries, &count, &filtered,
+				&raw));
+	assert_int_equal(3, count);
+	assert_int_equal(0, filtered);
+	assert_false(raw);
+	assert_string_equal("dir", entries[0].name);
+	assert_string_equal("a", entries[1].name);
+	assert_string_equal("b", entries[2].name);
+	assert_null(entries[0].origin);
+	free_entries(entries, count);
+
+	assert_true(flist_cache_get_mem_usage() == 0U);
+	assert_failure(flist_cache_take(view, &mon, &entries, &count, &filtered,
+				&raw));
+}
+
+TEST(list_is_not_taken_for_changed_directory)
+{
+	dir_entry_t *entries;
+	int count, filtered, raw;
+	filemon_t changed = mon;
+	++changed.inode;
+
+	flist_cache_put(view, &mon);
+	assert_failure(flist_cache_take(view, &changed, &entries, &count,
+				&filtered, &raw));
+	assert_true(flist_cache_get_mem_usage() == 0U);
+}
+
+TEST(list_is_not_taken_for_different_view_state)
+{
+	dir_entry_t *entries;
+	int count, filtered, raw;
+
+	flist_cache_put(view, &mon);
+
+	view->hide_dot = 0;
+	assert_failure(flist_cache_take(view, &mon, &entries, &count, &filtered,
+				&raw));
+	view->hide_dot = 1;
+
+	flist_cache_put(view, &mon);
+
+	view->sort[0] = SK_BY_SIZE;
+	assert_failure(flist_cache_take(view, &mon, &entries, &count, &filtered,
+				&raw));
+	view->sort[0] = SK_BY_NAME;
+}
+
+TEST(nothing_is_cached_when_cache_is_disabled)
+{
+	cfg.list_cache_size = 0;
+	flist_cache_put(view, &mon);
+	assert_true(flist_cache_get_mem_usage() == 0U);
+}
+
+TEST(reducing_limit_evicts_lists)
+{
+	flist_cache_put(view, &mon);
+	assert_true(flist_cache_get_mem_usage() != 0U);
+
+	cfg.list_cache_size = 0;
+	flist_cache_trim();
+	assert_true(flist_cache_get_mem_usage() == 0U);
+}
+
+TEST(changes_inside_directory_invalidate_its_list)
+{
+	char path[PATH_MAX];
+
+	flist_cache_put(view, &mon);
+	snprintf(path, sizeof(path), "%s/a", view->curr_dir);
+	flist_cache_invalidate(path);
+	assert_true(flist_cache_get_mem_usage() == 0U);
+
+	flist_cache_put(view, &mon);
+	flist_cache_invalidate("a");
+	assert_true(flist_cache_get_mem_usage() == 0U);
+}
+
+TEST(changes_of_parent_directory_invalidate_list)
+{
+	char path[PATH_MAX];
+
+	flist_cache_put(view, &mon);
+	snprintf(path, sizeof(path), "%s/..", view->curr_dir);
+	flist_cache_invalidate(path);
+	assert_true(flist_cache_get_mem_usage() == 0U);
+}
+
+TEST(unrelated_changes_do_not_invalidate_list)
+{
+	char path[PATH_MAX];
+
+	flist_cache_put(view, &mon);
+	snprintf(path, sizeof(path), "%s/dir/a", view->curr_dir);
+	flist_cache_invalidate(path);
+	assert_true(flist_cache_get_mem_usage() != 0U);
+}
+
+TEST(populating_view_uses_cached_list)
+{
+	flist_cache_put(view, &mon);
+	assert_true(flist_cache_get_mem_usage() != 0U);
+
+	populate_dir_list(view, 0);
+	assert_true(flist_cache_get_mem_usage() == 0U);
+
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_true(view->dir_entry[0].origin == &view->curr_dir[0]);
+}
+
+TEST(raw_list_is_read_and_taken_back)
+{
+	dir_entry_t *entries;
+	int count, filtered, raw;
+
+	create_file(".hidden");
+
+	assert_success(flist_read_raw(view->curr_dir, 100, &not_cancelled, NULL,
+				&entries, &count));
+	assert_int_equal(4, count);
+	flist_cache_put_raw(view->curr_dir, &mon, entries, count);
+
+	/* Raw lists don't depend on state of a view. */
+	view->sort[0] = SK_BY_SIZE;
+	assert_success(flist_cache_take(view, &mon, &entries, &count, &filtered,
+				&raw));
+	view->sort[0] = SK_BY_NAME;
+
+	assert_true(raw);
+	assert_int_equal(4, count);
+	free_entries(entries, count);
+
+	assert_success(unlink(".hidden"));
+}
+
+TEST(reading_raw_list_respects_limits)
+{
+	dir_entry_t *entries;
+	int count;
+
+	assert_failure(flist_read_raw(view->curr_dir, 2, &not_cancelled, NULL,
+				&entries, &count));
+	assert_failure(flist_read_raw(view->curr_dir, 100, &cancelled, NULL,
+				&entries, &count));
+}
+
+TEST(populating_view_filters_and_sorts_raw_list)
+{
+	dir_entry_t *entries;
+	int count;
+
+	create_file(".hidden");
+
+	assert_success(filemon_from_file(view->curr_dir, &mon));
+	assert_success(flist_read_raw(view->curr_dir, 100, &not_cancelled, NULL,
+				&entries, &count));
+	flist_cache_put_raw(view->curr_dir, &mon, entries, count);
+
+	populate_dir_list(view, 0);
+	assert_true(flist_cache_get_mem_usage() == 0U);
+
+	assert_int_equal(3, view->list_rows);
+	assert_int_equal(1, view->filtered);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_int_equal(FT_DIR, view->dir_entry[0].type);
+	assert_string_equal("a", view->dir_entry[1].name);
+	assert_string_equal("b", view->dir_entry[2].name);
+	assert_true(view->dir_entry[2].origin == &view->curr_dir[0]);
+
+	assert_success(unlink(".hidden"));
+}
+
+TEST(names_of_raw_list_can_be_queried)
+{
+	dir_entry_t *entries;
+	int count;
+	char **names;
+
+	assert_success(flist_read_raw(view->curr_dir, 100, &not_cancelled, NULL,
+				&entries, &count));
+	flist_cache_put_raw(view->curr_dir, &mon, entries, count);
+
+	count = flist_cache_get_names(view->curr_dir, &mon, &names);
+	assert_int_equal(3, count);
+	assert_true(is_in_string_array(names, count, "a"));
+	assert_true(is_in_string_array(names, count, "b"));
+	assert_true(is_in_string_array(names, count, "dir/"));
+	free_string_array(names, count);
+
+	assert_true(flist_cache_contains(view->curr_dir));
+	assert_int_equal(-1, flist_cache_get_names("/no-such-dir", &mon, &names));
+}
+
+static int
+not_cancelled(void *arg)
+{
+	return 0;
+}
+
+static int
+cancelled(void *arg)
+{
+	return 1;
+}
+
+static void
+create_file(const char name[])
+{
+	FILE *const f = fopen(name, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+}
+
+static void
+free_entries(dir_entry_t *entries, int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(entries[i].name);
+	}
+	dynarray_free(entries);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
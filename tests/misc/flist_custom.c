@@ -1,7 +1,8 @@
 #include <stic.h>
 
-#include <unistd.h> /* chdir() rmdir() */
+#include <unistd.h> /* chdir() rmdir() unlink() */
 
+#include <stdio.h> /* FILE fclose() fopen() */
 #include <stdlib.h> /* free() */
 #include <string.h> /* memset() strcpy() */
 
@@ -189,6 +190,40 @@ TEST(files_are_sorted_undecorated)
 	assert_success(rmdir("foo0"));
 }
 
+TEST(files_are_sorted_by_short_paths)
+{
+	FILE *f;
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	assert_success(os_mkdir("a", 0700));
+	assert_non_null(f = fopen("a/c", "w"));
+	fclose(f);
+	assert_non_null(f = fopen("B", "w"));
+	fclose(f);
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, "a/c");
+	flist_custom_add(&lwin, "B");
+	assert_success(flist_custom_finish(&lwin, 0));
+
+	assert_string_equal("B", lwin.dir_entry[0].name);
+	assert_string_equal("c", lwin.dir_entry[1].name);
+
+	lwin.sort[0] = SK_BY_INAME;
+	sort_view(&lwin);
+
+	assert_string_equal("c", lwin.dir_entry[0].name);
+	assert_string_equal("B", lwin.dir_entry[1].name);
+
+	assert_success(unlink("a/c"));
+	assert_success(rmdir("a"));
+	assert_success(unlink("B"));
+}
+
 static void
 setup_custom_view(FileView *view)
 {
@@ -0,0 +1,199 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* S_ISDIR() */
+#include <unistd.h> /* chdir() rmdir() symlink() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+/* Should be big enough for meta-data to be loaded by several threads. */
+#define NFILES 2000
+
+static void create_file(const char name[]);
+
+static FileView *const view = &lwin;
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+	int i;
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	cfg.slow_fs_list = strdup("");
+
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d", i);
+		create_file(name);
+	}
+	create_file(".hidden");
+	assert_success(os_mkdir("dir", 0700));
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+}
+
+TEARDOWN()
+{
+	int i;
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		free(view->dir_entry[i].name);
+	}
+	dynarray_free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d", i);
+		assert_success(unlink(name));
+	}
+	assert_success(unlink(".hidden"));
+	assert_success(rmdir("dir"));
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+}
+
+TEST(all_entries_are_loaded_in_order)
+{
+	int i;
+
+	view->hide_dot = 0;
+	populate_dir_list(view, 0);
+
+	assert_int_equal(NFILES + 2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_int_equal(FT_DIR, view->dir_entry[0].type);
+	assert_string_equal(".hidden", view->dir_entry[1].name);
+	assert_int_equal(FT_REG, view->dir_entry[1].type);
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d", i);
+		assert_string_equal(name, view->dir_entry[2 + i].name);
+		assert_int_equal(FT_REG, view->dir_entry[2 + i].type);
+		assert_true(view->dir_entry[2 + i].mtime != 0);
+	}
+}
+
+TEST(dot_files_are_still_hidden)
+{
+	view->hide_dot = 1;
+	populate_dir_list(view, 0);
+
+	assert_int_equal(NFILES + 1, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_string_equal("0000", view->dir_entry[1].name);
+}
+
+TEST(reading_continues_after_partial_list_is_shown)
+{
+	int i;
+
+	view->window_cells = 10;
+	view->hide_dot = 0;
+	populate_dir_list(view, 0);
+	view->window_cells = 0;
+
+	assert_int_equal(NFILES + 2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_string_equal(".hidden", view->dir_entry[1].name);
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "%04d", i);
+		assert_string_equal(name, view->dir_entry[2 + i].name);
+		assert_true(view->dir_entry[2 + i].mtime != 0);
+	}
+}
+
+TEST(memory_usage_accounts_for_all_entries)
+{
+	view->hide_dot = 0;
+	populate_dir_list(view, 0);
+
+	assert_true(flist_get_mem_usage(view) >=
+			(NFILES + 2)*(sizeof(dir_entry_t) + sizeof("0000")));
+}
+
+/* Windows is really bad at handling links. */
+#ifndef _WIN32
+
+TEST(mode_of_symlink_target_is_loaded)
+{
+	assert_success(symlink("dir", "link"));
+
+	view->hide_dot = 1;
+	populate_dir_list(view, 0);
+
+	assert_int_equal(NFILES + 2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+	assert_string_equal("link", view->dir_entry[1].name);
+	assert_int_equal(FT_LINK, view->dir_entry[1].type);
+	assert_true(S_ISDIR(view->dir_entry[1].mode));
+
+	assert_success(unlink("link"));
+}
+
+TEST(state_of_symlink_target_is_loaded)
+{
+	assert_success(symlink("dir", "link"));
+	assert_success(symlink("no-such-file", "nlink"));
+
+	view->hide_dot = 1;
+	populate_dir_list(view, 0);
+
+	assert_int_equal(NFILES + 3, view->list_rows);
+	assert_string_equal("link", view->dir_entry[1].name);
+	assert_int_equal(LTS_VALID, view->dir_entry[1].link_state);
+	assert_string_equal("nlink", view->dir_entry[NFILES + 2].name);
+	assert_int_equal(FT_LINK, view->dir_entry[NFILES + 2].type);
+	assert_int_equal(LTS_BROKEN, view->dir_entry[NFILES + 2].link_state);
+
+	assert_success(unlink("nlink"));
+	assert_success(unlink("link"));
+}
+
+#endif
+
+static void
+create_file(const char name[])
+{
+	FILE *const f = fopen(name, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,184 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() rmdir() unlink() usleep() */
+
+#include <stdio.h> /* FILE fclose() fopen() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/background.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_cache.h"
+#include "../../src/flist_prefetch.h"
+
+static void create_file(const char name[]);
+static void wait_for_bg(void);
+
+static FileView *const view = &lwin;
+static char dir_path[PATH_MAX];
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	cfg.slow_fs_list = strdup("");
+	cfg.list_cache_size = 1024;
+	cfg.prefetch_dirs = 1;
+
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+	snprintf(dir_path, sizeof(dir_path), "%s/dir", cwd);
+
+	create_file("file");
+	assert_success(os_mkdir("dir", 0700));
+	create_file("dir/nested");
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->hide_dot = 1;
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	populate_dir_list(view, 0);
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("dir", view->dir_entry[0].name);
+}
+
+TEARDOWN()
+{
+	int i;
+
+	flist_prefetch_cancel();
+	wait_for_bg();
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	cfg.prefetch_dirs = 0;
+	cfg.list_cache_size = 0;
+	flist_cache_trim();
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		free(view->dir_entry[i].name);
+	}
+	dynarray_free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+
+	assert_success(unlink("dir/nested"));
+	assert_success(rmdir("dir"));
+	assert_success(unlink("file"));
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+}
+
+TEST(directory_under_cursor_is_prefetched)
+{
+	view->list_pos = 0;
+	flist_prefetch(view);
+	wait_for_bg();
+
+	assert_true(flist_cache_contains(dir_path));
+}
+
+TEST(files_are_not_prefetched)
+{
+	view->list_pos = 1;
+	flist_prefetch(view);
+	wait_for_bg();
+
+	assert_true(flist_cache_get_mem_usage() == 0U);
+}
+
+TEST(nothing_is_prefetched_when_cache_is_disabled)
+{
+	cfg.list_cache_size = 0;
+
+	view->list_pos = 0;
+	flist_prefetch(view);
+	wait_for_bg();
+
+	assert_false(flist_cache_contains(dir_path));
+}
+
+TEST(nothing_is_prefetched_when_option_is_off)
+{
+	cfg.prefetch_dirs = 0;
+
+	view->list_pos = 0;
+	flist_prefetch(view);
+	wait_for_bg();
+
+	assert_false(flist_cache_contains(dir_path));
+}
+
+TEST(prefetching_is_not_a_background_job)
+{
+	const job_t *const last_job = jobs;
+
+	view->list_pos = 0;
+	flist_prefetch(view);
+	assert_true(jobs == last_job);
+	wait_for_bg();
+
+	assert_true(flist_cache_contains(dir_path));
+}
+
+TEST(prefetched_list_is_used_on_entering_directory)
+{
+	view->list_pos = 0;
+	flist_prefetch(view);
+	wait_for_bg();
+
+	copy_str(view->curr_dir, sizeof(view->curr_dir), dir_path);
+	populate_dir_list(view, 0);
+
+	assert_false(flist_cache_contains(dir_path));
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("nested", view->dir_entry[0].name);
+	assert_int_equal(FT_REG, view->dir_entry[0].type);
+}
+
+static void
+create_file(const char name[])
+{
+	FILE *const f = fopen(name, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+}
+
+/* Waits for all prefetching tasks to finish. */
+static void
+wait_for_bg(void)
+{
+	int counter = 0;
+	while(flist_prefetch_in_progress() && ++counter < 5000)
+	{
+		usleep(1000);
+	}
+
+	assert_false(flist_prefetch_in_progress());
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -1,8 +1,14 @@
 #include <stic.h>
 
+#include <sys/stat.h> /* chmod() */
+#include <unistd.h> /* symlink() unlink() */
+
 #include <stddef.h> /* NULL */
-#include <string.h> /* memset() */
+#include <stdio.h> /* FILE fclose() fopen() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strcmp() strdup() */
 
+#include "../../src/cfg/config.h"
 #include "../../src/compat/os.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/dynarray.h"
@@ -10,6 +16,8 @@
 #include "../../src/utils/str.h"
 #include "../../src/filelist.h"
 
+static int get_pos(const char name[]);
+
 static FileView *const view = &lwin;
 
 SETUP()
@@ -22,6 +30,8 @@ SETUP()
 
 	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
 
+	cfg.slow_fs_list = strdup("");
+
 	assert_success(os_mkdir("0", 0000));
 	assert_success(os_mkdir("1", 0000));
 	assert_success(os_mkdir("2", 0000));
@@ -49,6 +59,9 @@ TEARDOWN()
 	filter_dispose(&view->manual_filter);
 	filter_dispose(&view->local_filter.filter);
 
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+
 	(void)rmdir("0");
 	(void)rmdir("1");
 	(void)rmdir("2");
@@ -102,5 +115,125 @@ TEST(selection_is_preserved)
 	assert_int_equal(2, view->selected_files);
 }
 
+TEST(new_files_are_sorted_and_cursor_stays_on_the_same_file)
+{
+	view->list_pos = 2;
+	view->top_line = 0;
+	assert_success(os_mkdir("10", 0000));
+
+	populate_dir_list(view, 1);
+	assert_int_equal(5, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("1", view->dir_entry[1].name);
+	assert_string_equal("10", view->dir_entry[2].name);
+	assert_string_equal("2", view->dir_entry[view->list_pos].name);
+
+	(void)rmdir("10");
+}
+
+TEST(several_new_files_are_inserted_in_order)
+{
+	view->list_pos = 2;
+	view->top_line = 1;
+	assert_success(os_mkdir("00", 0000));
+	assert_success(os_mkdir("15", 0000));
+	assert_success(os_mkdir("4", 0000));
+
+	populate_dir_list(view, 1);
+	assert_int_equal(7, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("00", view->dir_entry[1].name);
+	assert_string_equal("1", view->dir_entry[2].name);
+	assert_string_equal("15", view->dir_entry[3].name);
+	assert_string_equal("2", view->dir_entry[4].name);
+	assert_string_equal("3", view->dir_entry[5].name);
+	assert_string_equal("4", view->dir_entry[6].name);
+	assert_int_equal(4, view->list_pos);
+	assert_int_equal(3, view->top_line);
+
+	(void)rmdir("00");
+	(void)rmdir("15");
+	(void)rmdir("4");
+}
+
+TEST(reload_without_changes_preserves_the_list)
+{
+	view->list_pos = 1;
+	view->dir_entry[3].hi_num = 7;
+
+	populate_dir_list(view, 1);
+	assert_int_equal(4, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("3", view->dir_entry[3].name);
+	assert_int_equal(7, view->dir_entry[3].hi_num);
+	assert_int_equal(1, view->list_pos);
+}
+
+TEST(new_file_does_not_resort_list_sorted_by_time)
+{
+	view->sort[0] = SK_BY_TIME_MODIFIED;
+	populate_dir_list(view, 0);
+
+	/* Sorting renumbers all entries. */
+	view->dir_entry[get_pos("0")].list_num = -100;
+	assert_success(os_mkdir("4", 0000));
+
+	populate_dir_list(view, 1);
+	assert_int_equal(5, view->list_rows);
+	assert_true(get_pos("4") >= 0);
+	assert_int_equal(-100, view->dir_entry[get_pos("0")].list_num);
+
+	(void)rmdir("4");
+}
+
+TEST(new_executable_does_not_resort_list)
+{
+	FILE *const f = fopen("4", "w");
+	assert_non_null(f);
+	fclose(f);
+	assert_success(chmod("4", 0755));
+
+	view->dir_entry[get_pos("0")].list_num = -100;
+	populate_dir_list(view, 1);
+
+	assert_int_equal(5, view->list_rows);
+	assert_int_equal(4, get_pos("4"));
+	assert_int_equal(-100, view->dir_entry[get_pos("0")].list_num);
+
+	assert_success(unlink("4"));
+}
+
+TEST(new_symlink_does_not_resort_list_sorted_by_ctime)
+{
+	view->sort[0] = SK_BY_TIME_CHANGED;
+	populate_dir_list(view, 0);
+
+	view->dir_entry[get_pos("0")].list_num = -100;
+	assert_success(symlink("0", "4"));
+
+	populate_dir_list(view, 1);
+
+	assert_int_equal(5, view->list_rows);
+	assert_true(get_pos("4") >= 0);
+	assert_int_equal(-100, view->dir_entry[get_pos("0")].list_num);
+
+	assert_success(unlink("4"));
+}
+
+/* Finds entry by its name.  Returns its position or -1 if it's not there. */
+static int
+get_pos(const char name[])
+{
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(strcmp(view->dir_entry[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
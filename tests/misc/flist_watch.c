@@ -0,0 +1,299 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* chmod() */
+#include <unistd.h> /* chdir() symlink() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strcmp() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/fswatch.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+static void create_file(const char name[]);
+static int get_pos(const char name[]);
+
+static FileView *const view = &lwin;
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	cfg.slow_fs_list = strdup("");
+
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+
+	create_file("a");
+	create_file("b");
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+	view->hide_dot = 1;
+	populate_dir_list(view, 0);
+
+	/* Sets up the watcher. */
+	check_if_filelist_have_changed(view);
+}
+
+TEARDOWN()
+{
+	int i;
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		free(view->dir_entry[i].name);
+	}
+	dynarray_free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	fswatch_free(view->watch);
+	view->watch = NULL;
+	view->watched_dir[0] = '\0';
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+	cfg.trust_notify = 0;
+
+	(void)unlink("a");
+	(void)unlink("b");
+	(void)unlink("c");
+}
+
+/* Other systems don't provide per-file notifications. */
+#ifdef __linux__
+
+TEST(changes_are_applied_without_reload)
+{
+	const uint64_t last_reload = view->postponed_reload;
+
+	create_file("c");
+	assert_success(unlink("a"));
+	view->list_pos = 0;
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(last_reload, view->postponed_reload);
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("b", view->dir_entry[0].name);
+	assert_string_equal("c", view->dir_entry[1].name);
+	assert_int_equal(0, view->list_pos);
+}
+
+TEST(created_files_are_inserted_in_order)
+{
+	create_file("0");
+	create_file("ab");
+	create_file("c");
+	view->list_pos = 1;
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(5, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("a", view->dir_entry[1].name);
+	assert_string_equal("ab", view->dir_entry[2].name);
+	assert_string_equal("b", view->dir_entry[3].name);
+	assert_string_equal("c", view->dir_entry[4].name);
+	assert_int_equal(3, view->list_pos);
+
+	assert_success(unlink("0"));
+	assert_success(unlink("ab"));
+}
+
+TEST(filtered_files_are_not_added)
+{
+	create_file(".c");
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(2, view->list_rows);
+	assert_success(unlink(".c"));
+}
+
+TEST(modified_file_is_updated)
+{
+	FILE *const f = fopen("b", "w");
+	fputs("text", f);
+	fclose(f);
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("b", view->dir_entry[1].name);
+	assert_int_equal(4, view->dir_entry[1].size);
+}
+
+TEST(modification_that_does_not_affect_sorting_keeps_order)
+{
+	FILE *const f = fopen("b", "w");
+	fputs("text", f);
+	fclose(f);
+	/* Sorting renumbers all entries. */
+	view->dir_entry[0].list_num = -100;
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(4, view->dir_entry[1].size);
+	assert_int_equal(-100, view->dir_entry[0].list_num);
+}
+
+TEST(file_modified_after_creation_is_up_to_date)
+{
+	FILE *const f = fopen("c", "w");
+	fputs("text", f);
+	fputs("text", f);
+	fclose(f);
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("c", view->dir_entry[2].name);
+	assert_int_equal(8, view->dir_entry[2].size);
+}
+
+TEST(removal_of_filtered_file_updates_filtered_count)
+{
+	create_file(".c");
+	check_if_filelist_have_changed(view);
+	assert_int_equal(1, view->filtered);
+
+	assert_success(unlink(".c"));
+	check_if_filelist_have_changed(view);
+	assert_int_equal(0, view->filtered);
+
+	/* The counter doesn't go below zero. */
+	create_file(".c");
+	check_if_filelist_have_changed(view);
+	view->filtered = 0;
+	assert_success(unlink(".c"));
+	check_if_filelist_have_changed(view);
+	assert_int_equal(0, view->filtered);
+}
+
+TEST(trusted_reload_does_not_reread_metadata)
+{
+	cfg.trust_notify = 1;
+
+	/* The watcher wasn't active when the list was read, so it's not trusted. */
+	view->dir_entry[0].size = 100;
+	populate_dir_list(view, 1);
+	assert_int_equal(0, view->dir_entry[0].size);
+
+	view->dir_entry[0].size = 100;
+	create_file("c");
+	populate_dir_list(view, 1);
+
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("a", view->dir_entry[0].name);
+	assert_int_equal(100, view->dir_entry[0].size);
+	assert_string_equal("c", view->dir_entry[2].name);
+}
+
+TEST(created_file_does_not_resort_list_sorted_by_time)
+{
+	view->sort[0] = SK_BY_TIME_MODIFIED;
+	/* Sorting renumbers all entries. */
+	view->dir_entry[0].list_num = -100;
+	create_file("c");
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(3, view->list_rows);
+	assert_true(get_pos("c") >= 0);
+	assert_int_equal(-100, view->dir_entry[get_pos("a")].list_num);
+}
+
+TEST(created_executable_and_symlink_do_not_resort_list)
+{
+	create_file("ab");
+	assert_success(chmod("ab", 0755));
+	assert_success(symlink("b", "ba"));
+	view->dir_entry[0].list_num = -100;
+
+	check_if_filelist_have_changed(view);
+
+	assert_int_equal(4, view->list_rows);
+	assert_int_equal(0, get_pos("a"));
+	assert_int_equal(1, get_pos("ab"));
+	assert_int_equal(2, get_pos("b"));
+	assert_int_equal(3, get_pos("ba"));
+	assert_int_equal(-100, view->dir_entry[0].list_num);
+
+	assert_success(unlink("ab"));
+	assert_success(unlink("ba"));
+}
+
+TEST(trusted_reload_does_not_resort_list_sorted_by_time)
+{
+	cfg.trust_notify = 1;
+	view->sort[0] = SK_BY_TIME_MODIFIED;
+	populate_dir_list(view, 1);
+
+	view->dir_entry[0].list_num = -100;
+	create_file("c");
+	populate_dir_list(view, 1);
+
+	assert_int_equal(3, view->list_rows);
+	assert_true(get_pos("c") >= 0);
+	assert_int_equal(-100, view->dir_entry[get_pos("a")].list_num);
+}
+
+TEST(untrusted_reload_rereads_metadata)
+{
+	populate_dir_list(view, 1);
+
+	view->dir_entry[0].size = 100;
+	populate_dir_list(view, 1);
+
+	assert_int_equal(2, view->list_rows);
+	assert_int_equal(0, view->dir_entry[0].size);
+}
+
+#endif
+
+static void
+create_file(const char name[])
+{
+	FILE *const f = fopen(name, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+}
+
+/* Finds entry by its name.  Returns its position or -1 if it's not there. */
+static int
+get_pos(const char name[])
+{
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(strcmp(view->dir_entry[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -2,7 +2,11 @@
 
 #include <unistd.h> /* chdir() unlink() */
 
+#include <sys/time.h> /* gettimeofday() timeval */
+
 #include <locale.h> /* LC_ALL setlocale() */
+#include <stdio.h> /* printf() snprintf() */
+#include <stdlib.h> /* getenv() */
 #include <string.h> /* memset() */
 
 #include "../../src/cfg/config.h"
@@ -15,7 +19,13 @@
 #define ASSERT_STRCMP_EQUAL(a, b) \
 		do { assert_int_equal(SIGN(a), SIGN(b)); } while(0)
 
+/* Number of entries used to compare sorting approaches. */
+#define MANY_ENTRIES 20000
+
 static void free_view(FileView *view);
+static void fill_view(FileView *view, int count);
+static void sort_by_each_key(FileView *view, const char keys[], int nkeys);
+static double get_time(void);
 
 SETUP_ONCE()
 {
@@ -320,5 +330,157 @@ TEST(extensions_of_dot_files_are_sorted_correctly)
 	assert_string_equal(".tmux.conf", lwin.dir_entry[2].name);
 }
 
+TEST(only_changes_of_sorting_keys_affect_order)
+{
+	dir_entry_t was = lwin.dir_entry[0];
+	dir_entry_t now = lwin.dir_entry[0];
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	now.size = was.size + 1;
+	now.mtime = was.mtime + 1;
+	assert_false(sort_is_affected(&lwin, &was, &now));
+
+	lwin.sort[1] = -SK_BY_TIME_MODIFIED;
+	assert_true(sort_is_affected(&lwin, &was, &now));
+
+	now.mtime = was.mtime;
+	assert_false(sort_is_affected(&lwin, &was, &now));
+}
+
+TEST(change_of_type_affects_order)
+{
+	dir_entry_t was = lwin.dir_entry[0];
+	dir_entry_t now = lwin.dir_entry[0];
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	now.type = FT_DIR;
+	assert_true(sort_is_affected(&lwin, &was, &now));
+}
+
+TEST(insert_position_is_found_in_sorted_list)
+{
+	dir_entry_t entry = lwin.dir_entry[0];
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	sort_view(&lwin);
+
+	/* The list is "A", "_", "a". */
+	entry.name = "B";
+	assert_int_equal(1, sort_find_insert_pos(&lwin, lwin.dir_entry,
+				lwin.list_rows, &entry));
+	entry.name = "0";
+	assert_int_equal(0, sort_find_insert_pos(&lwin, lwin.dir_entry,
+				lwin.list_rows, &entry));
+	entry.name = "b";
+	assert_int_equal(3, sort_find_insert_pos(&lwin, lwin.dir_entry,
+				lwin.list_rows, &entry));
+	entry.name = "_";
+	assert_int_equal(2, sort_find_insert_pos(&lwin, lwin.dir_entry,
+				lwin.list_rows, &entry));
+}
+
+TEST(directories_are_inserted_before_files)
+{
+	dir_entry_t entry = lwin.dir_entry[0];
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	sort_view(&lwin);
+
+	entry.name = "z";
+	entry.type = FT_DIR;
+	assert_int_equal(0, sort_find_insert_pos(&lwin, lwin.dir_entry,
+				lwin.list_rows, &entry));
+}
+
+TEST(single_pass_sort_matches_sorting_by_each_key)
+{
+	static const char keys[] = {
+		SK_BY_EXTENSION, -SK_BY_TIME_MODIFIED, SK_BY_NAME
+	};
+	double single_time, multi_time;
+	int i;
+
+	free_view(&lwin);
+	free_view(&rwin);
+	fill_view(&lwin, MANY_ENTRIES);
+	fill_view(&rwin, MANY_ENTRIES);
+
+	memcpy(lwin.sort, keys, sizeof(keys));
+	memset(&lwin.sort[sizeof(keys)], SK_NONE, sizeof(lwin.sort) - sizeof(keys));
+
+	single_time = get_time();
+	sort_view(&lwin);
+	single_time = get_time() - single_time;
+
+	multi_time = get_time();
+	sort_by_each_key(&rwin, keys, sizeof(keys));
+	multi_time = get_time() - multi_time;
+
+	for(i = 0; i < MANY_ENTRIES; ++i)
+	{
+		assert_string_equal(rwin.dir_entry[i].name, lwin.dir_entry[i].name);
+	}
+
+	/* Set BENCHMARK environment variable to see the difference. */
+	if(getenv("BENCHMARK") != NULL)
+	{
+		printf("%d entries: single pass %.3f ms, pass per key %.3f ms\n",
+				MANY_ENTRIES, single_time*1000.0, multi_time*1000.0);
+	}
+}
+
+/* Populates view with entries that have many equal sorting keys. */
+static void
+fill_view(FileView *view, int count)
+{
+	static const char *const exts[] = { "c", "h", "txt", "" };
+	unsigned int seed = 1;
+	int i;
+
+	view->list_rows = count;
+	view->dir_entry = dynarray_cextend(NULL, count*sizeof(*view->dir_entry));
+	for(i = 0; i < count; ++i)
+	{
+		char name[32];
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		seed = seed*1103515245U + 12345U;
+		snprintf(name, sizeof(name), "file%d.%s", (int)(seed%1000U),
+				exts[(seed >> 10)%4U]);
+
+		entry->name = strdup(name);
+		entry->type = ((seed >> 12)%8U == 0U) ? FT_DIR : FT_REG;
+		entry->mtime = (seed >> 14)%16U;
+	}
+}
+
+/* Sorts view in a way it used to be done: stable sort per key starting with the
+ * least significant one. */
+static void
+sort_by_each_key(FileView *view, const char keys[], int nkeys)
+{
+	while(--nkeys >= 0)
+	{
+		view->sort[0] = keys[nkeys];
+		memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+		sort_view(view);
+	}
+}
+
+/* Retrieves current time.  Returns it in seconds. */
+static double
+get_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
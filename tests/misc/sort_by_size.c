@@ -0,0 +1,138 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() rmdir() unlink() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/cfg/dirsizes.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+static void create_file(const char path[], const char contents[]);
+
+static FileView *const view = &lwin;
+static char cwd[PATH_MAX];
+
+SETUP()
+{
+	assert_success(chdir(SANDBOX_PATH));
+
+	cfg.slow_fs_list = strdup("");
+	assert_success(dirsizes_reset());
+
+	assert_true(get_cwd(cwd, sizeof(cwd)) == cwd);
+	copy_str(view->curr_dir, sizeof(view->curr_dir), cwd);
+
+	assert_success(os_mkdir("a", 0700));
+	assert_success(os_mkdir("b", 0700));
+	create_file("a/file", "aaaaaaaaaa");
+	create_file("b/file", "b");
+
+	filter_init(&view->local_filter.filter, 1);
+	filter_init(&view->manual_filter, 1);
+	filter_init(&view->auto_filter, 1);
+	view->sort[0] = SK_BY_SIZE;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+	view->hide_dot = 1;
+}
+
+TEARDOWN()
+{
+	int i;
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		free_dir_entry(view, &view->dir_entry[i]);
+	}
+	dynarray_free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+
+	filter_dispose(&view->auto_filter);
+	filter_dispose(&view->manual_filter);
+	filter_dispose(&view->local_filter.filter);
+
+	assert_success(unlink("a/file"));
+	assert_success(unlink("b/file"));
+	assert_success(rmdir("a"));
+	assert_success(rmdir("b"));
+
+	assert_success(dirsizes_reset());
+
+	free(cfg.slow_fs_list);
+	cfg.slow_fs_list = NULL;
+	cfg.calc_dir_sizes = 0;
+}
+
+TEST(cached_sizes_of_directories_are_used)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "%s/a", cwd);
+	dirsizes_set(path, 200, 1, NULL);
+	snprintf(path, sizeof(path), "%s/b", cwd);
+	dirsizes_set(path, 100, 1, NULL);
+
+	populate_dir_list(view, 0);
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("b", view->dir_entry[0].name);
+	assert_string_equal("a", view->dir_entry[1].name);
+}
+
+TEST(missing_sizes_are_calculated_if_requested)
+{
+	char path[PATH_MAX];
+	uint64_t size;
+
+	cfg.calc_dir_sizes = 1;
+	populate_dir_list(view, 0);
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("b", view->dir_entry[0].name);
+	assert_string_equal("a", view->dir_entry[1].name);
+
+	snprintf(path, sizeof(path), "%s/a", cwd);
+	assert_success(dirsizes_get(path, &size, NULL));
+	assert_int_equal(10, size);
+	snprintf(path, sizeof(path), "%s/b", cwd);
+	assert_success(dirsizes_get(path, &size, NULL));
+	assert_int_equal(1, size);
+}
+
+TEST(sizes_are_not_calculated_by_default)
+{
+	char path[PATH_MAX];
+	uint64_t size;
+
+	populate_dir_list(view, 0);
+
+	snprintf(path, sizeof(path), "%s/a", cwd);
+	assert_failure(dirsizes_get(path, &size, NULL));
+}
+
+static void
+create_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
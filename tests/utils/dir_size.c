@@ -0,0 +1,281 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <sys/stat.h> /* stat */
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+#include <unistd.h> /* link() rmdir() truncate() unlink() */
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() snprintf() */
+#include <string.h> /* strcmp() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/utils/dir_size.h"
+#include "../../src/utils/macros.h"
+
+#define MANY_DIRS 300
+
+static int lookup(const char path[], uint64_t *size, void *arg);
+static void store(const dir_size_result_t results[], int count, void *arg);
+static void progress(uint64_t ndirs, uint64_t size, void *arg);
+static int stored_size(const char path[], uint64_t *size);
+static int stored_exact(const char path[]);
+static uint64_t allocated(const char path[]);
+static void create_file(const char path[], const char contents[]);
+
+/* Sizes passed to store(). */
+static struct
+{
+	char path[PATH_MAX];
+	uint64_t size;
+	int exact;
+}
+stored[16];
+static int nstored;
+static pthread_mutex_t stored_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Number of progress() calls. */
+static int nprogress;
+
+static const dir_size_client_t client = {
+	.lookup = &lookup, .store = &store, .progress = &progress,
+};
+
+SETUP()
+{
+	nstored = 0;
+	nprogress = 0;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dir/sub", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dir/known", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dir/known/deep", 0700));
+	create_file(SANDBOX_PATH "/dir/a", "aaaaaaaaaa");
+	create_file(SANDBOX_PATH "/dir/sub/b", "bbbbb");
+	create_file(SANDBOX_PATH "/dir/known/deep/c", "c");
+}
+
+TEARDOWN()
+{
+	assert_success(unlink(SANDBOX_PATH "/dir/known/deep/c"));
+	assert_success(unlink(SANDBOX_PATH "/dir/sub/b"));
+	assert_success(unlink(SANDBOX_PATH "/dir/a"));
+	assert_success(rmdir(SANDBOX_PATH "/dir/known/deep"));
+	assert_success(rmdir(SANDBOX_PATH "/dir/known"));
+	assert_success(rmdir(SANDBOX_PATH "/dir/sub"));
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+}
+
+TEST(nonexistent_directory_is_an_error)
+{
+	uint64_t size = 1U;
+	assert_failure(dir_size_calc(SANDBOX_PATH "/no-such-dir", &client, &size));
+	assert_int_equal(0, size);
+	assert_int_equal(0, nstored);
+}
+
+TEST(sizes_of_nested_directories_are_summed)
+{
+	const dir_size_client_t no_callbacks = { .lookup = NULL };
+	uint64_t size;
+
+	assert_success(dir_size_calc(SANDBOX_PATH "/dir", &no_callbacks, &size));
+	assert_int_equal(16, size);
+}
+
+TEST(sizes_of_all_directories_are_stored)
+{
+	const dir_size_client_t no_lookup = { .store = &store };
+	uint64_t size;
+
+	assert_success(dir_size_calc(SANDBOX_PATH "/dir/", &no_lookup, &size));
+	assert_int_equal(16, size);
+
+	assert_int_equal(4, nstored);
+	assert_success(stored_size(SANDBOX_PATH "/dir/", &size));
+	assert_int_equal(16, size);
+	assert_success(stored_size(SANDBOX_PATH "/dir/sub", &size));
+	assert_int_equal(5, size);
+	assert_success(stored_size(SANDBOX_PATH "/dir/known", &size));
+	assert_int_equal(1, size);
+	assert_success(stored_size(SANDBOX_PATH "/dir/known/deep", &size));
+	assert_int_equal(1, size);
+}
+
+TEST(known_directories_are_not_traversed)
+{
+	uint64_t size;
+
+	assert_success(dir_size_calc(SANDBOX_PATH "/dir", &client, &size));
+	assert_int_equal(115, size);
+
+	assert_int_equal(2, nstored);
+	assert_success(stored_size(SANDBOX_PATH "/dir", &size));
+	assert_int_equal(115, size);
+	assert_success(stored_size(SANDBOX_PATH "/dir/sub", &size));
+	assert_int_equal(5, size);
+	assert_failure(stored_size(SANDBOX_PATH "/dir/known/deep", &size));
+}
+
+TEST(progress_is_reported_for_many_directories)
+{
+	const dir_size_client_t progress_only = { .progress = &progress };
+	char path[PATH_MAX];
+	uint64_t size;
+	int i;
+
+	for(i = 0; i < MANY_DIRS; ++i)
+	{
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir/sub/%d", i);
+		assert_success(os_mkdir(path, 0700));
+	}
+
+	assert_success(dir_size_calc(SANDBOX_PATH "/dir", &progress_only, &size));
+	assert_int_equal(16, size);
+	assert_true(nprogress > 0);
+
+	for(i = 0; i < MANY_DIRS; ++i)
+	{
+		snprintf(path, sizeof(path), SANDBOX_PATH "/dir/sub/%d", i);
+		assert_success(rmdir(path));
+	}
+}
+
+TEST(hard_links_are_counted_once_in_disk_usage_mode)
+{
+	const dir_size_client_t du = { .store = &store, .disk_usage = 1 };
+	uint64_t size;
+
+	assert_success(link(SANDBOX_PATH "/dir/a", SANDBOX_PATH "/dir/sub/a"));
+
+	assert_success(dir_size_calc(SANDBOX_PATH "/dir", &du, &size));
+	assert_int_equal(allocated(SANDBOX_PATH "/dir") +
+			allocated(SANDBOX_PATH "/dir/a") +
+			allocated(SANDBOX_PATH "/dir/sub") +
+			allocated(SANDBOX_PATH "/dir/sub/b") +
+			allocated(SANDBOX_PATH "/dir/known") +
+			allocated(SANDBOX_PATH "/dir/known/deep") +
+			allocated(SANDBOX_PATH "/dir/known/deep/c"), size);
+	assert_int_equal(1, stored_exact(SANDBOX_PATH "/dir"));
+	assert_int_equal(1, stored_exact(SANDBOX_PATH "/dir/known"));
+
+	assert_success(unlink(SANDBOX_PATH "/dir/sub/a"));
+}
+
+TEST(sparse_files_are_counted_by_allocated_space_in_disk_usage_mode)
+{
+	const dir_size_client_t du = { .disk_usage = 1 };
+	const dir_size_client_t apparent = { .disk_usage = 0 };
+	uint64_t du_size, apparent_size;
+
+	assert_success(truncate(SANDBOX_PATH "/dir/sub/b", 10*1024*1024));
+
+	assert_success(dir_size_calc(SANDBOX_PATH "/dir/sub", &du, &du_size));
+	assert_success(dir_size_calc(SANDBOX_PATH "/dir/sub", &apparent,
+				&apparent_size));
+
+	assert_int_equal(10*1024*1024, apparent_size);
+	assert_int_equal(allocated(SANDBOX_PATH "/dir/sub") +
+			allocated(SANDBOX_PATH "/dir/sub/b"), du_size);
+	assert_true(du_size < apparent_size);
+}
+
+/* Reports fixed size for "known" directory. */
+static int
+lookup(const char path[], uint64_t *size, void *arg)
+{
+	if(strcmp(path, SANDBOX_PATH "/dir/known") == 0)
+	{
+		*size = 100U;
+		return 0;
+	}
+	return 1;
+}
+
+/* Remembers reported sizes. */
+static void
+store(const dir_size_result_t results[], int count, void *arg)
+{
+	int i;
+
+	pthread_mutex_lock(&stored_mutex);
+	for(i = 0; i < count && nstored < (int)ARRAY_LEN(stored); ++i)
+	{
+		snprintf(stored[nstored].path, sizeof(stored[nstored].path), "%s",
+				results[i].path);
+		stored[nstored].size = results[i].size;
+		stored[nstored].exact = results[i].exact;
+		++nstored;
+	}
+	pthread_mutex_unlock(&stored_mutex);
+}
+
+/* Counts progress reports. */
+static void
+progress(uint64_t ndirs, uint64_t size, void *arg)
+{
+	pthread_mutex_lock(&stored_mutex);
+	++nprogress;
+	pthread_mutex_unlock(&stored_mutex);
+}
+
+/* Looks up size passed to store().  Returns zero if it's found, otherwise
+ * non-zero is returned. */
+static int
+stored_size(const char path[], uint64_t *size)
+{
+	int i;
+	for(i = 0; i < nstored; ++i)
+	{
+		if(strcmp(stored[i].path, path) == 0)
+		{
+			*size = stored[i].size;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Looks up exactness of size passed to store().  Returns the exactness or -1 if
+ * size wasn't stored. */
+static int
+stored_exact(const char path[])
+{
+	int i;
+	for(i = 0; i < nstored; ++i)
+	{
+		if(strcmp(stored[i].path, path) == 0)
+		{
+			return stored[i].exact;
+		}
+	}
+	return -1;
+}
+
+/* Queries space allocated for a file.  Returns the size. */
+static uint64_t
+allocated(const char path[])
+{
+	struct stat st;
+	assert_success(lstat(path, &st));
+	return (uint64_t)st.st_blocks*512U;
+}
+
+static void
+create_file(const char path[], const char contents[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fputs(contents, f);
+		fclose(f);
+	}
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,27 @@
+#include <stic.h>
+
+#include <string.h> /* memset() */
+
+#include "../../src/utils/dynarray.h"
+
+TEST(array_can_be_extended_after_shrinking)
+{
+	char *array = dynarray_extend(NULL, 10);
+	assert_non_null(array);
+	array = dynarray_extend(array, 10);
+	assert_non_null(array);
+	memset(array, 'a', 20);
+
+	array = dynarray_shrink(array);
+	array = dynarray_extend(array, 100);
+	assert_non_null(array);
+	memset(array + 20, 'b', 100);
+
+	assert_int_equal('a', array[19]);
+	assert_int_equal('b', array[119]);
+
+	dynarray_free(array);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
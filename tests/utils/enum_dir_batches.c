@@ -0,0 +1,276 @@
+#include <stic.h>
+
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <dirent.h> /* DT_DIR DT_REG DT_UNKNOWN */
+#include <fcntl.h> /* O_RDONLY open() */
+#include <unistd.h> /* close() rmdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() printf() snprintf() */
+#include <stdlib.h> /* getenv() */
+#include <string.h> /* strcmp() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/string_array.h"
+
+#define MANY_FILES 2000
+
+static int collect_names(const dir_batch_entry_t entries[], int count,
+		void *param);
+static int collect_name(const char name[], const void *data, void *param);
+static int count_batches(const dir_batch_entry_t entries[], int count,
+		void *param);
+static int remember_dir_type(const dir_batch_entry_t entries[], int count,
+		void *param);
+static int stop(const dir_batch_entry_t entries[], int count, void *param);
+static void create_files(int count);
+static void remove_files(int count);
+static double get_time(void);
+
+/* List of collected names. */
+static char **names;
+static int nnames;
+
+SETUP()
+{
+	names = NULL;
+	nnames = 0;
+}
+
+TEARDOWN()
+{
+	free_string_array(names, nnames);
+}
+
+TEST(nonexistent_directory_is_an_error)
+{
+	assert_failure(enum_dir_batches(SANDBOX_PATH "/no-such-dir", 0U,
+				&collect_names, NULL));
+}
+
+TEST(all_entries_except_builtin_ones_are_reported)
+{
+	assert_success(enum_dir_batches(TEST_DATA_PATH "/existing-files", 0U,
+				&collect_names, NULL));
+
+	assert_int_equal(3, nnames);
+	assert_true(is_in_string_array(names, nnames, "a"));
+	assert_true(is_in_string_array(names, nnames, "b"));
+	assert_true(is_in_string_array(names, nnames, "c"));
+}
+
+#ifndef _WIN32
+
+TEST(opened_directory_is_read_and_left_open)
+{
+	const int fd = open(TEST_DATA_PATH "/existing-files", O_RDONLY);
+	assert_true(fd >= 0);
+
+	assert_success(enum_dir_fd_batches(fd, 0U, &collect_names, NULL));
+	assert_int_equal(3, nnames);
+
+	assert_success(close(fd));
+}
+
+#endif
+
+TEST(type_of_entries_is_reported)
+{
+	unsigned char type = DT_REG;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	assert_success(enum_dir_batches(SANDBOX_PATH, 0U, &remember_dir_type,
+				&type));
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+
+	assert_true(type == DT_DIR || type == DT_UNKNOWN);
+}
+
+TEST(small_buffer_results_in_several_batches)
+{
+	int batches = 0;
+
+	create_files(100);
+	assert_success(enum_dir_batches(SANDBOX_PATH, 1U, &count_batches,
+				&batches));
+	remove_files(100);
+
+	assert_int_equal(100, nnames);
+	assert_true(batches > 1);
+}
+
+TEST(stopping_enumeration_is_reported)
+{
+	assert_failure(enum_dir_batches(TEST_DATA_PATH "/existing-files", 0U, &stop,
+				NULL));
+}
+
+TEST(reader_reports_batches_on_request)
+{
+	const dir_batch_entry_t *entries;
+	int count;
+	int batches = 0;
+	dir_batch_reader_t *reader;
+
+	create_files(100);
+
+	reader = dir_batch_reader_open(SANDBOX_PATH, 1U);
+	assert_non_null(reader);
+
+	do
+	{
+		assert_success(dir_batch_reader_next(reader, &entries, &count));
+		batches += (count != 0);
+		assert_success(collect_names(entries, count, NULL));
+	}
+	while(count != 0);
+
+	/* End of directory is reported repeatedly. */
+	assert_success(dir_batch_reader_next(reader, &entries, &count));
+	assert_int_equal(0, count);
+
+	dir_batch_reader_free(reader);
+	remove_files(100);
+
+	assert_int_equal(100, nnames);
+	assert_true(batches > 1);
+}
+
+TEST(reader_fails_to_open_nonexistent_directory)
+{
+	assert_null(dir_batch_reader_open(SANDBOX_PATH "/no-such-dir", 0U));
+}
+
+TEST(batches_report_same_entries_as_readdir)
+{
+	char **batch_names;
+	int nbatch_names;
+	double batches_time, readdir_time;
+	int i;
+
+	create_files(MANY_FILES);
+
+	readdir_time = get_time();
+	assert_success(enum_dir_content(SANDBOX_PATH, &collect_name, NULL));
+	readdir_time = get_time() - readdir_time;
+
+	/* Entries of enum_dir_content() include "." and "..". */
+	assert_int_equal(MANY_FILES + 2, nnames);
+	batch_names = names;
+	nbatch_names = nnames;
+	names = NULL;
+	nnames = 0;
+
+	batches_time = get_time();
+	assert_success(enum_dir_batches(SANDBOX_PATH, 0U, &collect_names, NULL));
+	batches_time = get_time() - batches_time;
+
+	remove_files(MANY_FILES);
+
+	assert_int_equal(MANY_FILES, nnames);
+	for(i = 0; i < nnames; ++i)
+	{
+		assert_true(is_in_string_array(batch_names, nbatch_names, names[i]));
+	}
+	free_string_array(batch_names, nbatch_names);
+
+	/* Set BENCHMARK environment variable to see the difference. */
+	if(getenv("BENCHMARK") != NULL)
+	{
+		printf("%d entries: readdir() %.3f ms, enum_dir_batches() %.3f ms\n",
+				MANY_FILES, readdir_time*1000.0, batches_time*1000.0);
+	}
+}
+
+static int
+collect_names(const dir_batch_entry_t entries[], int count, void *param)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		nnames = add_to_string_array(&names, nnames, 1, entries[i].name);
+	}
+	return 0;
+}
+
+static int
+collect_name(const char name[], const void *data, void *param)
+{
+	nnames = add_to_string_array(&names, nnames, 1, name);
+	return 0;
+}
+
+static int
+count_batches(const dir_batch_entry_t entries[], int count, void *param)
+{
+	int *const batches = param;
+	++*batches;
+	return collect_names(entries, count, NULL);
+}
+
+static int
+remember_dir_type(const dir_batch_entry_t entries[], int count, void *param)
+{
+	unsigned char *const type = param;
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(strcmp(entries[i].name, "dir") == 0)
+		{
+			*type = entries[i].type;
+		}
+	}
+	return 0;
+}
+
+static int
+stop(const dir_batch_entry_t entries[], int count, void *param)
+{
+	return 1;
+}
+
+static void
+create_files(int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char path[PATH_MAX];
+		FILE *f;
+
+		snprintf(path, sizeof(path), "%s/file-with-quite-a-long-name-%05d",
+				SANDBOX_PATH, i);
+		f = fopen(path, "w");
+		assert_non_null(f);
+		if(f != NULL)
+		{
+			fclose(f);
+		}
+	}
+}
+
+static void
+remove_files(int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/file-with-quite-a-long-name-%05d",
+				SANDBOX_PATH, i);
+		assert_success(unlink(path));
+	}
+}
+
+/* Retrieves current time.  Returns it in seconds. */
+static double
+get_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
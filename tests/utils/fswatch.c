@@ -0,0 +1,120 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() */
+#include <string.h> /* strcpy() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/fswatch.h"
+
+/* Other systems don't provide per-file notifications. */
+#ifdef __linux__
+
+static void create_file(const char name[]);
+static void remember_event(FSWatchEvent event, const char name[], void *arg);
+
+static int nevents;
+static FSWatchEvent last_event;
+static char last_name[64];
+
+SETUP()
+{
+	nevents = 0;
+	last_name[0] = '\0';
+}
+
+TEST(watcher_is_not_created_for_missing_dir)
+{
+	assert_null(fswatch_create(SANDBOX_PATH "/no-such-dir"));
+}
+
+TEST(no_changes_are_reported_for_untouched_dir)
+{
+	fswatch_t *const w = fswatch_create(SANDBOX_PATH);
+	assert_non_null(w);
+
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(w, &remember_event, NULL));
+	assert_int_equal(0, nevents);
+
+	fswatch_free(w);
+}
+
+TEST(creation_and_removal_are_reported)
+{
+	fswatch_t *const w = fswatch_create(SANDBOX_PATH);
+	assert_non_null(w);
+
+	create_file(SANDBOX_PATH "/file");
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(w, &remember_event, NULL));
+	assert_int_equal(FSWE_CREATED, last_event);
+	assert_string_equal("file", last_name);
+
+	assert_success(unlink(SANDBOX_PATH "/file"));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(w, &remember_event, NULL));
+	assert_int_equal(FSWE_DELETED, last_event);
+	assert_string_equal("file", last_name);
+
+	fswatch_free(w);
+}
+
+TEST(modification_is_reported)
+{
+	fswatch_t *w;
+	FILE *f;
+
+	create_file(SANDBOX_PATH "/file");
+
+	w = fswatch_create(SANDBOX_PATH);
+	assert_non_null(w);
+
+	f = fopen(SANDBOX_PATH "/file", "w");
+	fputs("text", f);
+	fclose(f);
+
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(w, &remember_event, NULL));
+	assert_int_equal(FSWE_MODIFIED, last_event);
+	assert_string_equal("file", last_name);
+
+	fswatch_free(w);
+	assert_success(unlink(SANDBOX_PATH "/file"));
+}
+
+TEST(removal_of_directory_itself_is_an_error)
+{
+	fswatch_t *w;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	w = fswatch_create(SANDBOX_PATH "/dir");
+	assert_non_null(w);
+
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+	assert_int_equal(FSWS_ERRORED, fswatch_poll(w, &remember_event, NULL));
+	assert_int_equal(FSWS_ERRORED, fswatch_poll(w, &remember_event, NULL));
+
+	fswatch_free(w);
+}
+
+static void
+create_file(const char name[])
+{
+	FILE *const f = fopen(name, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+}
+
+static void
+remember_event(FSWatchEvent event, const char name[], void *arg)
+{
+	++nevents;
+	last_event = event;
+	strcpy(last_name, name);
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,77 @@
+#include <stic.h>
+
+#include <stddef.h> /* size_t */
+#include <string.h> /* memset() */
+
+#include "../../src/utils/macros.h"
+#include "../../src/utils/parallel.h"
+
+static void mark_items(size_t from, size_t to, void *arg);
+
+static int visits[10000];
+
+SETUP()
+{
+	memset(&visits, 0, sizeof(visits));
+}
+
+TEST(cpu_count_is_positive)
+{
+	assert_true(parallel_cpu_count() > 0);
+}
+
+TEST(empty_range_is_not_processed)
+{
+	parallel_for(0U, 1U, &mark_items, NULL);
+	assert_int_equal(0, visits[0]);
+}
+
+TEST(small_range_is_processed_once)
+{
+	size_t i;
+
+	parallel_for(10U, 100U, &mark_items, NULL);
+
+	for(i = 0U; i < 10U; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+	assert_int_equal(0, visits[10]);
+}
+
+TEST(large_range_is_processed_once)
+{
+	size_t i;
+
+	parallel_for(ARRAY_LEN(visits), 7U, &mark_items, NULL);
+
+	for(i = 0U; i < ARRAY_LEN(visits); ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+TEST(zero_chunk_size_is_handled)
+{
+	size_t i;
+
+	parallel_for(100U, 0U, &mark_items, NULL);
+
+	for(i = 0U; i < 100U; ++i)
+	{
+		assert_int_equal(1, visits[i]);
+	}
+}
+
+static void
+mark_items(size_t from, size_t to, void *arg)
+{
+	size_t i;
+	for(i = from; i < to; ++i)
+	{
+		++visits[i];
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
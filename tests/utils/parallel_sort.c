@@ -0,0 +1,162 @@
+#include <stic.h>
+
+#include <sys/time.h> /* gettimeofday() timeval */
+
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* printf() */
+#include <stdlib.h> /* getenv() qsort() */
+#include <string.h> /* memcmp() memcpy() */
+
+#include "../../src/utils/macros.h"
+#include "../../src/utils/parallel.h"
+
+/* Item to be sorted, which remembers its original position. */
+typedef struct
+{
+	int key; /* Value to sort by. */
+	int pos; /* Original position. */
+}
+item_t;
+
+static void fill_items(item_t items[], int count, int range);
+static int key_cmp(const void *a, const void *b);
+static int full_cmp(const void *a, const void *b);
+static double get_time(void);
+
+static item_t items[100000];
+static item_t expected[100000];
+
+TEST(empty_array_is_handled)
+{
+	parallel_sort(items, 0U, sizeof(items[0]), &key_cmp, 1U);
+	parallel_sort_runs(items, 0U, sizeof(items[0]), &key_cmp, 4U);
+}
+
+TEST(small_array_is_sorted)
+{
+	fill_items(items, 3, 10);
+	memcpy(expected, items, 3*sizeof(items[0]));
+
+	parallel_sort(items, 3U, sizeof(items[0]), &full_cmp, 1000U);
+	qsort(expected, 3U, sizeof(expected[0]), &full_cmp);
+
+	assert_success(memcmp(items, expected, 3*sizeof(items[0])));
+}
+
+TEST(any_number_of_runs_produces_same_result)
+{
+	size_t nruns;
+
+	for(nruns = 1U; nruns <= 9U; ++nruns)
+	{
+		fill_items(items, 1001, 1000);
+		memcpy(expected, items, 1001*sizeof(items[0]));
+
+		parallel_sort_runs(items, 1001U, sizeof(items[0]), &full_cmp, nruns);
+		qsort(expected, 1001U, sizeof(expected[0]), &full_cmp);
+
+		assert_success(memcmp(items, expected, 1001*sizeof(items[0])));
+	}
+}
+
+TEST(runs_with_many_equal_items_are_merged_correctly)
+{
+	size_t nruns;
+
+	for(nruns = 2U; nruns <= 5U; ++nruns)
+	{
+		fill_items(items, 1000, 3);
+		memcpy(expected, items, 1000*sizeof(items[0]));
+
+		parallel_sort_runs(items, 1000U, sizeof(items[0]), &full_cmp, nruns);
+		qsort(expected, 1000U, sizeof(expected[0]), &full_cmp);
+
+		assert_success(memcmp(items, expected, 1000*sizeof(items[0])));
+	}
+}
+
+TEST(equal_items_are_sorted_correctly)
+{
+	int i;
+
+	fill_items(items, 1000, 5);
+	parallel_sort_runs(items, 1000U, sizeof(items[0]), &key_cmp, 4U);
+
+	for(i = 1; i < 1000; ++i)
+	{
+		assert_true(items[i - 1].key <= items[i].key);
+	}
+}
+
+TEST(big_array_is_sorted_same_as_by_qsort)
+{
+	const int count = ARRAY_LEN(items);
+	double parallel_time, qsort_time;
+
+	fill_items(items, count, count);
+	memcpy(expected, items, sizeof(items));
+
+	parallel_time = get_time();
+	parallel_sort(items, count, sizeof(items[0]), &full_cmp, 10000U);
+	parallel_time = get_time() - parallel_time;
+
+	qsort_time = get_time();
+	qsort(expected, count, sizeof(expected[0]), &full_cmp);
+	qsort_time = get_time() - qsort_time;
+
+	assert_success(memcmp(items, expected, sizeof(items)));
+
+	/* Set BENCHMARK environment variable to see the difference. */
+	if(getenv("BENCHMARK") != NULL)
+	{
+		printf("%d items on %d CPUs: parallel_sort() %.3f ms, qsort() %.3f ms\n",
+				count, parallel_cpu_count(), parallel_time*1000.0,
+				qsort_time*1000.0);
+	}
+}
+
+/* Fills array with pseudo-random keys in [0, range) range. */
+static void
+fill_items(item_t items[], int count, int range)
+{
+	unsigned int seed = 12345U;
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		seed = seed*1103515245U + 12345U;
+		items[i].key = (int)((seed >> 16)%range);
+		items[i].pos = i;
+	}
+}
+
+/* Compares items by key only. */
+static int
+key_cmp(const void *a, const void *b)
+{
+	const item_t *const x = a;
+	const item_t *const y = b;
+	return (x->key > y->key) - (x->key < y->key);
+}
+
+/* Compares items by key and original position. */
+static int
+full_cmp(const void *a, const void *b)
+{
+	const item_t *const x = a;
+	const item_t *const y = b;
+	const int result = key_cmp(a, b);
+	return (result != 0) ? result : x->pos - y->pos;
+}
+
+/* Retrieves current time.  Returns it in seconds. */
+static double
+get_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,208 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strdup() */
+
+#include "../../src/utils/str_arena.h"
+
+static str_arena_t *arena;
+
+SETUP()
+{
+	arena = str_arena_create();
+	assert_non_null(arena);
+}
+
+TEARDOWN()
+{
+	str_arena_free(arena);
+}
+
+TEST(strings_are_copied)
+{
+	const char str[] = "string";
+	char *const copy = str_arena_dup(arena, str);
+
+	assert_string_equal(str, copy);
+	assert_false(copy == str);
+	assert_true(str_arena_owns(arena, copy));
+}
+
+TEST(heap_is_used_without_arena)
+{
+	char *const copy = str_arena_dup(NULL, "string");
+	char *const interned = str_arena_intern(NULL, "string");
+
+	assert_string_equal("string", copy);
+	assert_false(str_arena_owns(NULL, copy));
+	assert_false(copy == interned);
+
+	str_arena_release(NULL, copy);
+	str_arena_release(NULL, interned);
+	assert_int_equal(0, str_arena_mem_usage(NULL));
+}
+
+TEST(foreign_strings_are_freed_on_release)
+{
+	char *const str = strdup("string");
+	assert_false(str_arena_owns(arena, str));
+	str_arena_release(arena, str);
+}
+
+TEST(releasing_null_is_ok)
+{
+	str_arena_release(arena, NULL);
+	str_arena_release(NULL, NULL);
+}
+
+TEST(interned_strings_are_shared)
+{
+	char *const a = str_arena_intern(arena, "/some/path");
+	char *const b = str_arena_intern(arena, "/some/path");
+	char *const c = str_arena_intern(arena, "/other/path");
+
+	assert_true(a == b);
+	assert_false(a == c);
+	assert_string_equal("/some/path", a);
+	assert_string_equal("/other/path", c);
+}
+
+TEST(many_strings_are_interned)
+{
+	char buf[32];
+	char *first;
+	int i;
+
+	first = str_arena_intern(arena, "0");
+	for(i = 1; i < 1000; ++i)
+	{
+		snprintf(buf, sizeof(buf), "%d", i);
+		assert_string_equal(buf, str_arena_intern(arena, buf));
+	}
+
+	assert_true(first == str_arena_intern(arena, "0"));
+}
+
+TEST(long_strings_are_stored)
+{
+	char str[10000];
+	memset(str, 'x', sizeof(str) - 1U);
+	str[sizeof(str) - 1U] = '\0';
+
+	assert_string_equal(str, str_arena_dup(arena, str));
+	assert_string_equal("short", str_arena_dup(arena, "short"));
+}
+
+TEST(memory_is_freed_when_all_strings_are_released)
+{
+	char *strs[1000];
+	const size_t empty_usage = str_arena_mem_usage(arena);
+	int i;
+
+	for(i = 0; i < 1000; ++i)
+	{
+		strs[i] = str_arena_dup(arena, "some file name");
+	}
+	assert_true(str_arena_mem_usage(arena) > empty_usage + 1000U*15U);
+
+	for(i = 0; i < 1000; ++i)
+	{
+		str_arena_release(arena, strs[i]);
+	}
+	assert_int_equal(empty_usage, str_arena_mem_usage(arena));
+}
+
+TEST(interned_string_is_kept_until_last_release)
+{
+	const size_t empty_usage = str_arena_mem_usage(arena);
+	char *const a = str_arena_intern(arena, "/path");
+	char *const b = str_arena_intern(arena, "/path");
+
+	str_arena_release(arena, a);
+	assert_true(str_arena_owns(arena, b));
+	assert_string_equal("/path", b);
+
+	str_arena_release(arena, b);
+	assert_int_equal(empty_usage, str_arena_mem_usage(arena));
+}
+
+TEST(old_generation_is_freed_with_its_last_string)
+{
+	char *const old = str_arena_dup(arena, "old");
+	char *new;
+	size_t usage;
+
+	str_arena_new_gen(arena);
+	new = str_arena_dup(arena, "new");
+	usage = str_arena_mem_usage(arena);
+
+	str_arena_release(arena, old);
+	assert_false(str_arena_owns(arena, old));
+	assert_true(str_arena_owns(arena, new));
+	assert_true(str_arena_mem_usage(arena) < usage);
+}
+
+TEST(new_generation_isn_t_started_for_empty_one)
+{
+	const size_t empty_usage = str_arena_mem_usage(arena);
+	str_arena_new_gen(arena);
+	str_arena_new_gen(arena);
+	assert_int_equal(empty_usage, str_arena_mem_usage(arena));
+}
+
+TEST(strings_are_interned_within_generation)
+{
+	char *const old = str_arena_intern(arena, "/path");
+	char *new;
+
+	str_arena_new_gen(arena);
+	new = str_arena_intern(arena, "/path");
+
+	assert_false(old == new);
+
+	/* Strings of previous generation don't pin the current one. */
+	str_arena_release(arena, old);
+	assert_string_equal("/path", new);
+}
+
+TEST(pointer_past_used_part_of_block_is_not_owned)
+{
+	char *const copy = str_arena_dup(arena, "string");
+	assert_true(str_arena_owns(arena, copy + 6));
+	assert_false(str_arena_owns(arena, copy + 7));
+}
+
+TEST(strings_of_many_blocks_and_generations_are_released)
+{
+	char *strs[4][1000];
+	char str[200];
+	const size_t empty_usage = str_arena_mem_usage(arena);
+	int gen, i;
+
+	memset(str, 'x', sizeof(str) - 1U);
+	str[sizeof(str) - 1U] = '\0';
+
+	for(gen = 0; gen < 4; ++gen)
+	{
+		str_arena_new_gen(arena);
+		for(i = 0; i < 1000; ++i)
+		{
+			strs[gen][i] = str_arena_dup(arena, str);
+		}
+	}
+
+	/* Interleave releases of strings of different generations. */
+	for(i = 0; i < 1000; ++i)
+	{
+		for(gen = 0; gen < 4; ++gen)
+		{
+			assert_true(str_arena_owns(arena, strs[gen][i]));
+			str_arena_release(arena, strs[gen][i]);
+		}
+	}
+	assert_int_equal(empty_usage, str_arena_mem_usage(arena));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,184 @@
+#include <stic.h>
+
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <unistd.h> /* rmdir() */
+
+#include <stdio.h> /* printf() snprintf() */
+#include <stdlib.h> /* getenv() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/utils/tree.h"
+
+#define MANY_DIRS 5000
+
+static void create_dirs(int count);
+static void remove_dirs(int count);
+static void make_path(char buf[], size_t buf_len, int i);
+static double get_time(void);
+
+static tree_t tree;
+
+SETUP()
+{
+	tree = tree_create(0, 0);
+	assert_non_null(tree);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/a", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/a/b", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/ab", 0700));
+}
+
+TEARDOWN()
+{
+	tree_free(tree);
+
+	assert_success(rmdir(SANDBOX_PATH "/a/b"));
+	assert_success(rmdir(SANDBOX_PATH "/a"));
+	assert_success(rmdir(SANDBOX_PATH "/ab"));
+}
+
+TEST(empty_tree_has_no_data)
+{
+	tree_val_t data;
+	assert_failure(tree_get_data(tree, SANDBOX_PATH "/a", &data));
+}
+
+TEST(data_is_stored_per_path)
+{
+	tree_val_t data;
+
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/ab", 3));
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/a", 1));
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/a/b", 2));
+
+	assert_success(tree_get_data(tree, SANDBOX_PATH "/a", &data));
+	assert_int_equal(1, data);
+	assert_success(tree_get_data(tree, SANDBOX_PATH "/a/b", &data));
+	assert_int_equal(2, data);
+	assert_success(tree_get_data(tree, SANDBOX_PATH "/ab", &data));
+	assert_int_equal(3, data);
+
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/a/", 4));
+	assert_success(tree_get_data(tree, SANDBOX_PATH "/a", &data));
+	assert_int_equal(4, data);
+}
+
+TEST(intermediate_nodes_have_no_data)
+{
+	tree_val_t data;
+
+	assert_success(tree_set_data(tree, SANDBOX_PATH "/a/b", 2));
+	assert_failure(tree_get_data(tree, SANDBOX_PATH "/a", &data));
+}
+
+TEST(longest_match_is_found_if_requested)
+{
+	tree_t longest = tree_create(1, 0);
+	tree_val_t data;
+
+	assert_success(tree_set_data(longest, SANDBOX_PATH "/a", 1));
+	assert_success(tree_get_data(longest, SANDBOX_PATH "/a/b", &data));
+	assert_int_equal(1, data);
+	assert_failure(tree_get_data(longest, SANDBOX_PATH "/ab", &data));
+
+	tree_free(longest);
+}
+
+TEST(values_are_freed_with_the_tree)
+{
+	tree_t mem = tree_create(0, 1);
+	union
+	{
+		char *s;
+		tree_val_t l;
+	}
+	u = { .s = malloc(10) };
+
+	assert_success(tree_set_data(mem, SANDBOX_PATH "/a", u.l));
+	u.s = malloc(10);
+	assert_success(tree_set_data(mem, SANDBOX_PATH "/a", u.l));
+
+	tree_free(mem);
+}
+
+TEST(many_siblings_are_handled)
+{
+	char path[PATH_MAX];
+	double set_time, get_time_;
+	tree_val_t data;
+	int i;
+
+	create_dirs(MANY_DIRS);
+
+	set_time = get_time();
+	for(i = 0; i < MANY_DIRS; ++i)
+	{
+		make_path(path, sizeof(path), i);
+		assert_success(tree_set_data(tree, path, i));
+	}
+	set_time = get_time() - set_time;
+
+	get_time_ = get_time();
+	for(i = 0; i < MANY_DIRS; ++i)
+	{
+		make_path(path, sizeof(path), i);
+		assert_success(tree_get_data(tree, path, &data));
+		assert_int_equal(i, data);
+	}
+	get_time_ = get_time() - get_time_;
+
+	remove_dirs(MANY_DIRS);
+
+	/* Set BENCHMARK environment variable to see the timings. */
+	if(getenv("BENCHMARK") != NULL)
+	{
+		printf("%d siblings: tree_set_data() %.3f ms, tree_get_data() %.3f ms\n",
+				MANY_DIRS, set_time*1000.0, get_time_*1000.0);
+	}
+}
+
+static void
+create_dirs(int count)
+{
+	char path[PATH_MAX];
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		make_path(path, sizeof(path), i);
+		assert_success(os_mkdir(path, 0700));
+	}
+}
+
+static void
+remove_dirs(int count)
+{
+	char path[PATH_MAX];
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		make_path(path, sizeof(path), i);
+		assert_success(rmdir(path));
+	}
+}
+
+/* Formats path of i-th directory in the sandbox. */
+static void
+make_path(char buf[], size_t buf_len, int i)
+{
+	snprintf(buf, buf_len, SANDBOX_PATH "/a/%d", i);
+}
+
+/* Retrieves current time.  Returns it in seconds. */
+static double
+get_time(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */